@@ -0,0 +1,34 @@
+#ifndef ACCEL_FIFO_H
+#define ACCEL_FIFO_H
+
+// Accelerometer acquisition through the LSM6DS3 FIFO
+// The IMU queues every sample at its ODR, and read() drains whatever is waiting in
+// a few burst reads, so no sample is read twice or missed between loop passes.
+
+#include "LSM6DS3.h"
+
+#define accelFifoBurst 5  // samples per I2C read (30 bytes, fits a 32 byte Wire buffer)
+
+struct accelSample {
+  int16_t x;  // raw counts, LSM6DS3::calcAccel() converts to g
+  int16_t y;
+  int16_t z;
+};
+
+class AccelFifo {
+  public:
+    AccelFifo(LSM6DS3 &imu) : imu(imu) {}
+
+    // Starts the FIFO in continuous mode at the accelerometer ODR, call after imu.begin()
+    void begin();
+
+    // Reads up to maxSamples waiting samples, returns how many (0 if none, never waits)
+    uint16_t read(accelSample *samples, uint16_t maxSamples);
+
+    uint32_t overruns = 0;  // times the FIFO filled up and lost old samples
+
+  private:
+    LSM6DS3 &imu;
+};
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef ANGLE_GAUGE_H
+#define ANGLE_GAUGE_H
+
+// Graphical OLED display (oledFormatGauge): a roll dial, a pitch bar and a scrolling
+// sparkline of both angles, for matching control surface endpoints at a glance.
+// The angle history is a fixed ring with one entry per reading. The sparkline is kept
+// on a page-major canvas between frames: each new reading scrolls it one column (a
+// memmove per page) and only the new column is drawn. It is redrawn from the ring only
+// when the auto scale changes. Readings whose frame was skipped (the last one still on
+// the bus) are caught up by scrolling several columns at once.
+
+#include <stdint.h>
+#include <Adafruit_SSD1306Canvas.h>
+
+#define gaugeColumns 128  // sparkline width, one column per reading
+#define gaugeHistorySize (gaugeColumns + 1)  // the leftmost column still joins its previous reading
+#define gaugeSparkTop 40  // sparkline rows, the bottom 3 pages
+#define gaugeSparkHeight 24
+#define gaugeDialX 17  // roll dial centre and radius
+#define gaugeDialY 19
+#define gaugeDialRadius 17
+#define gaugeBarX 37  // pitch bar, centred on the dial's row, the same half height
+#define gaugeBarWidth 5
+#define gaugeTextX 44  // R/P labels, the values are right justified up to gaugeTextRight
+#define gaugeTextRight 122
+
+class AngleHistory {
+  public:
+    // Adds one reading (degrees), overwriting the oldest once full, O(1)
+    void add(float roll, float pitch);
+
+    uint16_t size() const { return count; }
+    uint32_t added() const { return total; }  // readings since boot
+    // Angles in tenths of a degree, age 0 is the newest reading
+    int16_t roll(uint16_t age) const { return rolls[slot(age)]; }
+    int16_t pitch(uint16_t age) const { return pitches[slot(age)]; }
+    // Largest magnitude of either angle over the shown columns, tenths of a degree
+    int16_t peak() const;
+
+  private:
+    uint16_t slot(uint16_t age) const { return (head + gaugeHistorySize - 1 - age) % gaugeHistorySize; }
+
+    int16_t rolls[gaugeHistorySize];
+    int16_t pitches[gaugeHistorySize];
+    uint16_t head = 0;  // next slot written
+    uint16_t count = 0;
+    uint32_t total = 0;
+};
+
+class AngleGauge {
+  public:
+    AngleGauge() : sparkline(gaugeColumns, gaugeSparkHeight) {}
+
+    // Adds a reading to the history, call it for every reading even when no frame is drawn
+    void add(float roll, float pitch) { history.add(roll, pitch); }
+
+    // Draws the gauge into a cleared framebuffer: roll dial, pitch bar, values and sparkline
+    // The dial and bar show roll/pitch (degrees), the text is printed as is
+    void draw(Adafruit_SSD1306 &display, float roll, float pitch, const char *rollText, const char *pitchText);
+
+    uint8_t range() const { return shownRange; }  // degrees at the sparkline edges and the bar ends
+    const AngleHistory &readings() const { return history; }
+    const Adafruit_SSD1306Canvas &chart() const { return sparkline; }
+
+  private:
+    void updateSparkline();
+    void drawColumn(int16_t x, uint16_t age);
+    int16_t row(int16_t tenths) const;
+
+    AngleHistory history;
+    Adafruit_SSD1306Canvas sparkline;
+    uint32_t drawnTotal = 0;  // history.added() when the sparkline was last brought up to date
+    uint8_t shownRange = 0;  // scale it was drawn at, 0 = not drawn yet
+};
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef BATTERY_CHARGE_H
+#define BATTERY_CHARGE_H
+
+// 1s lipo state of charge and time remaining
+// The filtered battery voltage is corrected for the voltage drop under the present
+// load, looked up in a resting (open circuit) voltage table, and the charge history
+// gives the discharge rate for a time remaining estimate. Work is only done once
+// every batteryChargePeriod, the battery changes over minutes.
+
+#include <stdint.h>
+
+#define batteryChargePeriod 60000   // msec between state of charge updates
+#define batteryHistorySize 64       // updates kept for the discharge rate (about an hour at 1 min)
+#define batteryResistance 250       // milliohm, internal resistance of a small 1s lipo
+#define batteryUnknownTime 0xFFFF   // minutesRemaining() when not discharging
+
+class BatteryCharge {
+  public:
+    // Feed the latest battery reading and the estimated load, cheap unless an update is due
+    // returns true when percent()/minutesRemaining() were recalculated
+    bool update(uint32_t now, uint16_t millivolts, uint16_t loadMilliamps);
+
+    uint8_t percent() const { return (charge + 50) / 100; }
+    uint16_t minutesRemaining() const { return remaining; }
+
+    // Open circuit voltage to charge in 0.01% steps, from the lipo table
+    static uint16_t ocvToCharge(uint16_t millivolts);
+
+  private:
+    uint16_t charge = 0;  // 0.01%
+    uint16_t remaining = batteryUnknownTime;
+    float dischargeRate = 0;  // smoothed 0.01% per update
+    uint16_t history[batteryHistorySize];  // charge at each update
+    uint8_t historyCount = 0;
+    uint8_t historyHead = 0;
+    uint32_t lastUpdate = 0;
+    bool started = false;
+};
+
+#endif
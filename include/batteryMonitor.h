@@ -0,0 +1,39 @@
+#ifndef BATTERY_MONITOR_H
+#define BATTERY_MONITOR_H
+
+// Background battery measurement for the Xiao nRF52840 Sense
+// RTC2 fires at a low rate and, through PPI, starts the SAADC which takes one burst
+// of hardware oversampled conversions on the battery divider. The CPU only picks up
+// the finished result in update(), so there is no ADC work in the sampling loop.
+
+#include <stdint.h>
+
+#define batteryOversample 4     // SAADC OVERSAMPLE setting, 2^4 = 16 conversions per reading
+#define batteryFilterShift 2    // filter weight of a new reading, 1/2^shift
+#define batteryDividerHigh 1510 // battery divider resistors (kohm), Vbat = Vpin * high / low
+#define batteryDividerLow 510
+#define batteryPpiStart 8       // PPI channels: RTC2 compare -> SAADC start (+ fork RTC2 clear)
+#define batteryPpiSample 9      //               SAADC started -> SAADC sample
+
+class BatteryMonitor {
+  public:
+    // Starts conversions every periodMs (125ms steps) on analog input ain, first one right away
+    void begin(uint8_t ain, uint16_t periodMs);
+
+    // Call from loop(), true when a new reading has been filtered in
+    bool update();
+
+    uint16_t millivolts() const { return (filtered + 8) >> 4; }
+    bool ready() const { return primed; }
+
+    // Conversion math, separate from the hardware so it can be checked anywhere
+    static uint16_t resultToMillivolts(int16_t result);
+    void addReading(uint16_t millivolts);
+
+  private:
+    volatile int16_t result = 0;  // SAADC EasyDMA target
+    uint32_t filtered = 0;        // millivolts with 4 fraction bits
+    bool primed = false;
+};
+
+#endif
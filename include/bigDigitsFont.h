@@ -0,0 +1,87 @@
+#ifndef BIG_DIGITS_FONT_H
+#define BIG_DIGITS_FONT_H
+
+// Large digits for the oledFormatBig readout: DejaVu Sans Bold 13pt, only the
+// characters an angle needs, pre-rendered in SSD1306 page order so
+// drawPageText() blits whole glyphs instead of scaling the 5x7 font.
+// Everything below the include is generated with
+//   fontconvert DejaVuSans-Bold.ttf 13 -p "0123456789+-. " 176
+// (lib/Adafruit_GFX_Library/fontconvert, 176 is the degree sign)
+
+#include <Adafruit_GFX.h>
+
+const uint8_t DejaVuSans_Bold13ptPagesBitmaps[] PROGMEM = {
+  0xC0, 0xF0, 0xF8, 0xFC, 0x3C, 0x1E, 0x0E, 0x0E, 0x0E, 0x1E, 0x3C, 0xFC,
+  0xF8, 0xF0, 0xC0, 0x3F, 0xFF, 0xFF, 0xFF, 0xC0, 0x80, 0x00, 0x00, 0x00,
+  0x80, 0xC0, 0xFF, 0xFF, 0xFF, 0x3F, 0x00, 0x00, 0x01, 0x03, 0x07, 0x07,
+  0x07, 0x07, 0x07, 0x07, 0x07, 0x03, 0x01, 0x00, 0x00, 0x1C, 0x1C, 0x0E,
+  0x0E, 0xFE, 0xFE, 0xFE, 0xFE, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x07, 0x07, 0x07,
+  0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x3C, 0x1C, 0x1E,
+  0x0E, 0x0E, 0x0E, 0x0E, 0x0E, 0x1E, 0xFC, 0xFC, 0xF8, 0xF0, 0x00, 0x80,
+  0xC0, 0xE0, 0xF0, 0xF8, 0xF8, 0x7C, 0x3E, 0x1F, 0x0F, 0x07, 0x03, 0x07,
+  0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07,
+  0x00, 0x1C, 0x1C, 0x0E, 0x0E, 0x0E, 0x0E, 0x0E, 0x0E, 0x1E, 0xFE, 0xFC,
+  0xFC, 0xF0, 0x80, 0x80, 0x00, 0x0E, 0x0E, 0x0E, 0x0E, 0x0E, 0x0E, 0x9F,
+  0xFF, 0xFF, 0xF9, 0xF0, 0x03, 0x03, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07,
+  0x07, 0x07, 0x03, 0x03, 0x01, 0x00, 0x00, 0x00, 0x00, 0xC0, 0xE0, 0xF0,
+  0xFC, 0x3E, 0x1E, 0xFE, 0xFE, 0xFE, 0xFE, 0x00, 0x00, 0x00, 0x78, 0x7E,
+  0x7F, 0x7F, 0x73, 0x71, 0x70, 0x70, 0x70, 0xFF, 0xFF, 0xFF, 0xFF, 0x70,
+  0x70, 0x70, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x07,
+  0x07, 0x07, 0x07, 0x00, 0x00, 0x00, 0x00, 0xFE, 0xFE, 0xFE, 0xFE, 0xCE,
+  0xCE, 0xCE, 0xCE, 0xCE, 0x8E, 0x8E, 0x0E, 0x00, 0x80, 0x83, 0x03, 0x01,
+  0x01, 0x01, 0x01, 0x01, 0x83, 0xC7, 0xFF, 0xFF, 0xFF, 0x7C, 0x03, 0x03,
+  0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x03, 0x03, 0x01, 0x00,
+  0x80, 0xE0, 0xF8, 0xF8, 0x3C, 0x9C, 0x9E, 0x8E, 0x8E, 0x8E, 0x8E, 0x0E,
+  0x1E, 0x1C, 0x00, 0x3F, 0xFF, 0xFF, 0xFF, 0x87, 0x03, 0x03, 0x03, 0x03,
+  0x03, 0x87, 0xFF, 0xFF, 0xFE, 0x7C, 0x00, 0x00, 0x01, 0x03, 0x03, 0x07,
+  0x07, 0x07, 0x07, 0x07, 0x07, 0x03, 0x03, 0x01, 0x00, 0x0E, 0x0E, 0x0E,
+  0x0E, 0x0E, 0x0E, 0x0E, 0x0E, 0xCE, 0xFE, 0xFE, 0xFE, 0x7E, 0x1E, 0x00,
+  0x00, 0x00, 0x00, 0xC0, 0xF0, 0xFC, 0xFF, 0x7F, 0x1F, 0x07, 0x01, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x07, 0x07, 0x07, 0x07, 0x01, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0xF8, 0xFC, 0xFC, 0xFE, 0x9E, 0x0E, 0x0E, 0x0E, 0x0E,
+  0x0E, 0x9E, 0xFE, 0xFC, 0xFC, 0x70, 0xF0, 0xFD, 0xFD, 0xFF, 0x8F, 0x07,
+  0x07, 0x07, 0x07, 0x07, 0x8F, 0xFF, 0xFD, 0xFD, 0xF0, 0x00, 0x01, 0x03,
+  0x03, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x03, 0x03, 0x01, 0x00,
+  0xE0, 0xF8, 0xFC, 0xFC, 0x1E, 0x0E, 0x0E, 0x0E, 0x0E, 0x0E, 0x1C, 0xFC,
+  0xF8, 0xF0, 0xC0, 0x03, 0x87, 0x0F, 0x0F, 0x1E, 0x1C, 0x1C, 0x1C, 0x9C,
+  0x9C, 0xCE, 0xFF, 0xFF, 0x7F, 0x1F, 0x00, 0x03, 0x07, 0x07, 0x07, 0x07,
+  0x07, 0x07, 0x07, 0x03, 0x03, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0xF0, 0xF0, 0xF0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0xFF, 0xFF, 0xFF, 0x1C, 0x1C, 0x1C,
+  0x1C, 0x1C, 0x1C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x07, 0x07, 0x07,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x3C, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xC0, 0xC0,
+  0xC0, 0xC0, 0x07, 0x07, 0x07, 0x07, 0x00, 0x00, 0x00, 0x3C, 0x7E, 0xE7,
+  0xC3, 0xC3, 0xE7, 0x7E, 0x3C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+
+const GFXpageGlyph DejaVuSans_Bold13ptPagesGlyphs[] PROGMEM = {
+  {     0,  15,  17,    1 },  // 0x30 '0'
+  {    45,  12,  17,    3 },  // 0x31 '1'
+  {    81,  13,  17,    2 },  // 0x32 '2'
+  {   120,  14,  17,    2 },  // 0x33 '3'
+  {   162,  16,  17,    1 },  // 0x34 '4'
+  {   210,  14,  17,    2 },  // 0x35 '5'
+  {   252,  15,  17,    1 },  // 0x36 '6'
+  {   297,  14,  17,    2 },  // 0x37 '7'
+  {   339,  15,  17,    1 },  // 0x38 '8'
+  {   384,  15,  17,    1 },  // 0x39 '9'
+  {   429,  15,  21,    3 },  // 0x2B '+'
+  {   474,   8,  10,    1 },  // 0x2D '-'
+  {   498,   4,  10,    3 },  // 0x2E '.'
+  {   510,   1,   9,    0 },  // 0x20 ' '
+  {   513,   8,  13,    2 } }; // 0xB0
+
+const uint8_t DejaVuSans_Bold13ptPagesChars[] PROGMEM = { 0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x2B, 0x2D, 0x2E, 0x20, 0xB0 };
+
+const GFXpageFont DejaVuSans_Bold13ptPages PROGMEM = {
+  (uint8_t      *)DejaVuSans_Bold13ptPagesBitmaps,
+  (GFXpageGlyph *)DejaVuSans_Bold13ptPagesGlyphs,
+  (uint8_t      *)DejaVuSans_Bold13ptPagesChars,
+  15, 19, 3 };
+
+// Approx. 636 bytes
+
+#endif
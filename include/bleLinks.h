@@ -0,0 +1,74 @@
+#ifndef BLE_LINKS_H
+#define BLE_LINKS_H
+
+// Connected BLE centrals and the notification scheduler
+// Keeps a small table of connected centrals (phone, laptop logger...), fed from the
+// ArduinoBLE connect events. Each reading is formatted once; update() then marks the
+// characteristics (channels) that changed, and next() hands them out a few per loop.
+// ArduinoBLE keeps one CCCD per characteristic, shared by all centrals: once any of
+// them subscribes, every write notifies every connected link, and any of them
+// unsubscribing turns it off for all. So a notifying write costs one packet per
+// connected link, and a per loop packet budget keeps 3 connections from stalling the
+// loop while the radio drains its buffers.
+
+#include <stdint.h>
+#include "textFormat.h"
+
+#define bleMaxLinks 3      // simultaneous centrals
+#define bleMaxChannels 16  // characteristics the scheduler can track
+#define bleNoChannel -1
+
+struct bleLink {
+  bool used = false;
+  char address[addressLength + 1] = "";
+  uint32_t connectedMillis = 0;
+};
+
+class BleLinks {
+  public:
+    // Connection table, addresses are "xx:xx:xx:xx:xx:xx"
+    bool connect(const char *address, uint32_t now);  // false if the table is full
+    void disconnect(const char *address);
+    uint8_t count() const { return links; }
+    bool full() const { return links >= bleMaxLinks; }
+    const char *newest() const;  // address of the latest connection, "" if none
+
+    // Scheduler
+    // Marks channels (bit per channel) as changed, anything not yet written is replaced
+    void update(uint16_t channels, uint32_t now);
+    // Next changed channel to write, or bleNoChannel when done or the budget is spent
+    // budget is in notification packets (at least bleMaxLinks), notifying channels (bit per
+    // channel, their characteristic is subscribed) cost one per connected link, the rest nothing
+    int8_t next(uint8_t *budget, uint16_t notifying, uint32_t now);
+    bool pending() const { return dirty != 0; }
+    uint32_t latency = 0;  // msec from update() to the last write of the previous update
+
+  private:
+    bleLink table[bleMaxLinks];
+    uint8_t links = 0;
+    uint16_t dirty = 0;
+    uint8_t cursor = 0;  // round robin start, so no channel is always last
+    uint32_t updateMillis = 0;
+
+    bleLink *find(const char *address);
+};
+
+// Channels whose characteristic has notifications on (bit per channel), read from the
+// stack's own CCCDs through subscribed(), characteristics[i] is channel i
+template <typename Characteristic>
+uint16_t bleSubscribedChannels(Characteristic *const *characteristics, uint8_t count) {
+  uint16_t channels = 0;
+  for (uint8_t channel = 0; channel < count; channel++) {
+    if (characteristics[channel]->subscribed()) {
+      channels |= 1 << channel;
+    }
+  }
+  return channels;
+}
+
+// Channels to queue for a new reading: the notifying ones out of `all`, or all of them on
+// a refresh tick (for apps that read without subscribing). Channels whose value is the
+// same as the one last written (`unchanged`, e.g. the battery level) are left out either way.
+uint16_t bleChannelsDue(uint16_t all, uint16_t notifying, bool refreshDue, uint16_t unchanged);
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef BUS_CLOCK_H
+#define BUS_CLOCK_H
+
+// I2C bus clock profiles with automatic fallback
+// Each bus starts at its configured profile. The caller hands update() the bus error
+// count (NACKs, short or all-ones reads, failed OLED frames) every loop, and when
+// busClockMaxErrors pile up within busClockPeriod the bus steps down one profile
+// (1MHz -> 400kHz -> 100kHz). It stays there until the next boot, since a harness
+// that failed once at a speed will fail again. A faster bus shortens both the IMU
+// burst reads and the OLED frames; long OLED wires are what usually can't keep up.
+// Fast-mode plus needs both ends to support it, the nRF52840 TWI tops out at 400kHz
+// and runs a 1MHz request at that.
+
+#include <stdint.h>
+
+enum busClockProfiles : uint8_t {
+  busClockStandard,  // 100kHz
+  busClockFast,      // 400kHz
+  busClockFastPlus,  // 1MHz
+  busClockProfileCount
+};
+
+#define busClockPeriod 10000  // msec error counting window (the OLED only sends a few frames a second)
+#define busClockMaxErrors 3  // errors within a window that step the clock down
+
+constexpr uint32_t busClockRate(uint8_t profile) {
+  return profile == busClockFastPlus ? 1000000 : profile == busClockFast ? 400000 : 100000;
+}
+
+class BusClock {
+  public:
+    BusClock(uint8_t profile) : current(profile < busClockProfileCount ? profile : (uint8_t)busClockFast) {}
+
+    uint8_t profile() const { return current; }
+    uint32_t hz() const { return busClockRate(current); }
+
+    // errors is a free running count (it may wrap), true when the clock stepped down
+    bool update(uint16_t errors, uint32_t now);
+
+    uint8_t stepDowns = 0;
+
+  private:
+    uint8_t current;
+    bool started = false;
+    uint16_t windowErrors = 0;  // error count at the start of the window
+    uint32_t windowStart = 0;
+};
+
+#endif
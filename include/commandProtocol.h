@@ -0,0 +1,81 @@
+#ifndef COMMAND_PROTOCOL_H
+#define COMMAND_PROTOCOL_H
+
+// Binary command protocol for runtime configuration over BLE
+// Requests are written to the command characteristic, and every request gets a
+// response notification on the same characteristic (little endian):
+//   request:  version | sequence | opcode | payload...
+//   response: version | sequence | opcode | status | payload...
+// The sequence byte is echoed so an app can match responses to requests.
+// handleCommand() only validates and updates a runtimeConfig; the returned action
+// flags tell the caller what needs applying (restart the IMU, save to flash...).
+// Changes are lost at power off unless commandPersist is sent.
+
+#include <stdint.h>
+
+#define commandVersion 1
+#define commandMaxLength 20  // request or response bytes (fits the default ATT MTU)
+
+enum commandOpcodes : uint8_t {
+  commandGetConfig = 0x00,    // response payload: commandConfig
+  commandSetWindow = 0x01,    // uint16 samples averaged per reading (1 - 1000)
+  commandSetOutput = 0x02,    // uint16 min msec between readings sent out, 0 = every reading
+  commandSetFilter = 0x03,    // uint8 filterTypes
+  commandSetImu = 0x04,       // uint16 accelerometer ODR (Hz), uint8 range (g)
+  commandSetStream = 0x05,    // uint8 0 = off, telemetryFrameRaw or telemetryFrameAngles
+  commandSetCapture = 0x06,   // uint8 captureModes
+  commandPersist = 0x07,      // save the current config to flash
+  commandOpcodeCount
+};
+
+enum commandStatus : uint8_t {
+  commandOk = 0,
+  commandBadVersion = 1,
+  commandBadLength = 2,
+  commandBadOpcode = 3,
+  commandBadValue = 4,
+  commandFailed = 5  // set by the caller when applying the command failed
+};
+
+enum filterTypes : uint8_t {
+  filterAverage = 0,  // plain average of the window (lowest latency)
+  filterSmooth = 1,   // average, then exponential smoothing across readings (lowest noise)
+  filterTypeCount
+};
+
+enum captureModes : uint8_t {
+  captureOff = 0,
+  captureOn = 1,
+  captureReset = 2  // restart the min/max, not stored
+};
+
+// Bits returned by handleCommand()
+enum commandActions : uint8_t {
+  commandActionImu = 1,      // IMU ODR or range changed, restart it
+  commandActionWindow = 2,   // averaging window changed, restart the reading
+  commandActionStream = 4,   // streaming mode changed
+  commandActionCapture = 8,  // capture mode changed (or reset)
+  commandActionPersist = 16, // save the config
+  commandActionReset = 32    // restart the throw capture
+};
+
+// Runtime settings, also the commandGetConfig payload
+struct __attribute__((packed)) commandConfig {
+  uint16_t window;        // samples per reading
+  uint16_t outputPeriod;  // msec, 0 = every reading
+  uint8_t filter;         // filterTypes
+  uint16_t imuRate;       // Hz
+  uint8_t imuRange;       // g
+  uint8_t stream;         // 0, telemetryFrameRaw or telemetryFrameAngles
+  uint8_t capture;        // captureOff or captureOn
+};
+
+// Validates a request, applies it to config and writes the response
+// returns commandActions bits, 0 if nothing changed or the request was rejected
+uint8_t handleCommand(const uint8_t *request, uint8_t length, commandConfig &config,
+                      uint8_t *response, uint8_t *responseLength);
+
+// true if the config only holds values handleCommand() would accept (for values read from flash)
+bool validConfig(const commandConfig &config);
+
+#endif
@@ -0,0 +1,129 @@
+#ifndef DFU_ENGINE_H
+#define DFU_ENGINE_H
+
+// Firmware update over BLE
+// A new image is written into a secondary slot in internal flash, a chunk at a time:
+//   control (write + notify): opcode | payload, answered with a dfuResponse
+//     dfuStart    uint32 image size, uint32 image crc32 - resumes if it's the same image,
+//                 answered once the slot is erased (erase() from loop(), a page at a time)
+//     dfuStatus   reports the next expected offset
+//     dfuInstall  verifies the whole slot against the crc and checks the image's vector
+//                 table (initial SP in RAM, Thumb reset vector inside the installed image),
+//                 then the caller installs it
+//     dfuAbort    forgets the transfer
+//   data (write without response): uint32 offset | image bytes (multiple of 4, except the last)
+// A chunk at the wrong offset is dropped and the sender is told where to continue, so
+// a dropped link just resumes with another dfuStart. Progress is saved (through the
+// caller) once per page, so after a power cycle the transfer resumes from the top of
+// the last page it reached.
+// Nothing touches the running firmware until the image has verified; the copy into
+// the application area then runs from RAM. Erasing a page stalls the CPU for ~85ms,
+// so it is never done from the data write callback: the slot is cleared before the
+// dfuStart is answered, and a transfer is refused if the running sketch reaches into it.
+
+#include <stdint.h>
+#include "settingsStore.h"
+
+#define dfuMaxChunk 240  // image bytes per data write (ATT MTU 247 - 3 - offset)
+
+enum dfuOpcodes : uint8_t {
+  dfuStart = 1,
+  dfuStatus = 2,
+  dfuInstall = 3,
+  dfuAbort = 4
+};
+
+enum dfuResults : uint8_t {
+  dfuOk = 0,
+  dfuBadLength = 1,
+  dfuBadOpcode = 2,
+  dfuTooLarge = 3,    // image doesn't fit the slot
+  dfuBadOffset = 4,   // chunk out of order, continue from dfuResponse.offset
+  dfuNotStarted = 5,
+  dfuCrcError = 6,    // image doesn't match its crc, start over
+  dfuIncomplete = 7,  // dfuInstall before all bytes arrived
+  dfuSlotInUse = 8,   // the running firmware reaches into the slot, move dfuSlotBase up
+  dfuBadImage = 9     // crc fine, but not a firmware image for this board (.hex, .uf2...), start over
+};
+
+enum dfuStates : uint8_t {
+  dfuIdle,
+  dfuReceiving,
+  dfuVerified,  // ready to install
+  dfuErasing    // clearing the slot for a dfuStart
+};
+
+// Notified on the control characteristic (little endian)
+struct __attribute__((packed)) dfuResponse {
+  uint8_t opcode;  // request opcode | 0x80, or 0x80 for a data chunk
+  uint8_t result;  // dfuResults
+  uint8_t state;   // dfuStates
+  uint32_t offset; // next image byte expected
+  uint32_t size;   // image size
+};
+
+// Transfer state, saved in the settings store so a transfer survives a power cycle
+struct dfuProgress {
+  uint32_t size;
+  uint32_t crc;         // expected crc32 of the whole image
+  uint32_t offset;      // bytes written
+  uint32_t runningCrc;  // crc32 state of the bytes before offset
+};
+
+class DfuEngine {
+  public:
+    // appBase is where images are installed (their reset vector must point in there),
+    // codeEnd is the end of the running firmware in flash, it must not reach the slot
+    DfuEngine(SettingsFlash &flash, uint32_t slotBase, uint32_t slotSize, uint32_t pageSize, uint32_t appBase, uint32_t codeEnd);
+
+    // Picks up a transfer saved before a reset (or nullptr)
+    void begin(const dfuProgress *saved);
+
+    // Handles a control request, always fills in a response
+    void control(const uint8_t *request, uint8_t length, dfuResponse *response);
+
+    // Handles a data write, returns dfuOk or the error to notify with status()
+    uint8_t data(const uint8_t *chunk, uint8_t length);
+
+    // Erases the next page of the slot that isn't blank yet, call once per loop
+    // true once, when the slot is ready and a pending dfuStart can be answered
+    bool erase();
+
+    void status(uint8_t opcode, uint8_t result, dfuResponse *response) const;
+
+    // true once per page written, save progress() then
+    bool progressDue();
+    const dfuProgress &progress() const { return saved; }
+
+    uint8_t state() const { return current; }
+    uint32_t slot() const { return slotBase; }
+
+    static uint32_t crc32(const void *data, uint32_t length, uint32_t crc = 0xFFFFFFFF);
+
+  private:
+    SettingsFlash &flash;
+    uint32_t slotBase;
+    uint32_t slotSize;
+    uint32_t pageSize;
+    uint32_t appBase;
+    uint32_t codeEnd;
+    uint32_t eraseAddress = 0;  // next page to erase
+    uint32_t eraseEnd = 0;
+    uint8_t current = dfuIdle;
+    dfuProgress transfer = {};  // live state
+    dfuProgress saved = {};     // last page boundary
+    bool savePending = false;
+
+    bool verify();
+    bool bootable();
+    bool blank(uint32_t page);
+    void startErase();
+};
+
+#if defined(NRF52840_XXAA)
+// Copies an image from the slot over the application and resets, never returns
+// runs from RAM with interrupts off, as it erases the code it would otherwise run from
+void dfuInstallImage(uint32_t from, uint32_t to, uint32_t size, uint32_t pageSize);
+#endif
+
+#endif
@@ -0,0 +1,174 @@
+#ifndef I2C_QUEUE_H
+#define I2C_QUEUE_H
+
+// Queued, non-blocking I2C transactions for the ble-inclinometer
+// Blocking Wire calls hold the loop for the whole transfer; a full OLED frame is
+// over 1kB, ~25ms even at 400kHz. Transactions are submitted to a queue per bus
+// instead, service() starts the next transfer and picks up finished ones, and the
+// submitter is told through a completion callback (called from service(), never
+// from an interrupt).
+// Long writes go out in chunks, each with the transaction's prefix (register address
+// or SSD1306 control byte) repeated, so a higher priority transaction on the same bus
+// can run between two chunks of a lower priority one. Same priority runs in order.
+// On the nRF52840 the transfers run on TWIM EasyDMA while the loop carries on; the
+// Wire backend does the same job synchronously on any core.
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define i2cQueueLength 8  // transactions waiting per bus
+#define i2cMaxPrefix 4    // prefix bytes sent before the data of every chunk
+#define i2cTimeout 50     // msec before a stuck transfer is abandoned (TWIM)
+
+enum i2cPriorities : uint8_t {
+  i2cPriorityDisplay,  // bulk display data, lowest
+  i2cPrioritySensor    // sensor reads, preempt display chunks
+};
+
+enum i2cStatus : uint8_t {
+  i2cIdle,     // not submitted yet
+  i2cQueued,   // waiting for the bus, or between chunks
+  i2cRunning,  // a chunk is on the bus
+  i2cDone,     // finished, every byte acknowledged
+  i2cFailed    // NACK, bus error or timeout, the rest was not sent
+};
+
+struct i2cTransaction;
+typedef void (*i2cCallback)(i2cTransaction &transaction);
+
+// Owned by the submitter, and must stay put (with its buffers) until it completes
+struct i2cTransaction {
+  uint8_t address = 0;        // 7 bit device address
+  uint8_t priority = i2cPriorityDisplay;
+  uint8_t prefix[i2cMaxPrefix] = {};
+  uint8_t prefixLength = 0;
+  const uint8_t *data = nullptr;  // written after the prefix
+  uint16_t length = 0;
+  uint8_t *readData = nullptr;    // read after the write (repeated start), RAM only
+  uint16_t readLength = 0;        // reads are never split, they go with the last chunk
+  uint16_t chunkSize = 0;         // max data bytes per transfer, 0 = as many as the bus takes
+  bool prefixed = false;          // the prefixLength bytes just before data hold the prefix too, so
+                                  // a bus that sends straight from RAM does it all in one transfer
+  i2cCallback done = nullptr;
+  void *context = nullptr;        // for the callback
+  volatile uint8_t status = i2cIdle;
+  uint16_t sent = 0;              // data bytes written so far
+  uint16_t order = 0;             // submit order, set by the queue
+};
+
+// One bus transfer at a time: START, prefix + data written, then readLength bytes
+// read after a repeated START, STOP. Lets the queue run against a mock.
+class I2cBus {
+  public:
+    virtual ~I2cBus() {}
+    // largest data length start() accepts after a prefixLength byte prefix
+    virtual uint16_t maxTransfer(uint8_t prefixLength) = 0;
+    virtual bool start(uint8_t address, const uint8_t *prefix, uint8_t prefixLength,
+                       const uint8_t *data, uint16_t length, uint8_t *readData, uint16_t readLength) = 0;
+    // i2cRunning until the transfer ends, then i2cDone or i2cFailed
+    virtual uint8_t poll() = 0;
+    virtual void setClock(uint32_t hz) = 0;
+    // Zero-copy transfers: largest prefix + data run startDirect() can send from
+    // where it is (0 = none, the default), and the transfer itself
+    virtual uint16_t maxDirect(const uint8_t *) { return 0; }
+    virtual bool startDirect(uint8_t, const uint8_t *, uint16_t, uint8_t *, uint16_t) { return false; }
+};
+
+#if defined(ARDUINO)
+#include <Wire.h>
+
+#if defined(ARDUINO_ARCH_MBED)
+#define i2cWireBuffer 256  // MbedI2C transmit buffer, prefix + data of one transfer
+#else
+#define i2cWireBuffer 32   // Wire transmit buffer, prefix + data of one transfer
+#endif
+
+// Any Arduino Wire, start() does the whole transfer before returning
+class WireI2cBus : public I2cBus {
+  public:
+    WireI2cBus(TwoWire &wire) : wire(wire) {}
+    uint16_t maxTransfer(uint8_t prefixLength) override { return i2cWireBuffer - prefixLength; }
+    bool start(uint8_t address, const uint8_t *prefix, uint8_t prefixLength,
+               const uint8_t *data, uint16_t length, uint8_t *readData, uint16_t readLength) override;
+    uint8_t poll() override { return result; }
+    void setClock(uint32_t hz) override;
+
+  private:
+    TwoWire &wire;
+    uint8_t result = i2cDone;
+};
+#endif
+
+#if defined(NRF52840_XXAA)
+#define twimBufferSize 256  // staging buffer, prefix + data of one transfer
+
+// nRF52840 TWIM with EasyDMA. Borrows the TWI instance a Wire object already set
+// up on the same pins, and hands it back (TWI mode, interrupts, clock) after each
+// transfer, so the Wire driver keeps working in between. Prefixed runs in RAM go
+// out straight from there, up to 64kB in one transfer (a whole OLED frame);
+// anything else is copied into the staging buffer first.
+class TwimI2cBus : public I2cBus {
+  public:
+    // pins as P0.xx / P1.xx numbers (digitalPinToPinName()), call after wire.begin()
+    // false if no TWI instance is set up on those pins
+    bool begin(uint32_t sdaPin, uint32_t sclPin, uint32_t hz);
+    uint16_t maxTransfer(uint8_t prefixLength) override { return twimBufferSize - prefixLength; }
+    bool start(uint8_t address, const uint8_t *prefix, uint8_t prefixLength,
+               const uint8_t *data, uint16_t length, uint8_t *readData, uint16_t readLength) override;
+    uint8_t poll() override;
+    void setClock(uint32_t hz) override;
+    uint16_t maxDirect(const uint8_t *run) override;
+    bool startDirect(uint8_t address, const uint8_t *run, uint16_t length, uint8_t *readData, uint16_t readLength) override;
+
+  private:
+    void *twim = nullptr;  // NRF_TWIM_Type
+    uint32_t frequency = 0;  // FREQUENCY register value
+    uint32_t clock = 100000;  // Hz, for the timeout
+    uint8_t buffer[twimBufferSize];  // EasyDMA can't read flash, and wants prefix + data in one run
+    uint16_t txLength = 0;
+    uint16_t rxLength = 0;
+    uint32_t savedEnable = 0;
+    uint32_t savedInterrupts = 0;
+    uint32_t savedFrequency = 0;
+    uint32_t started = 0;
+    uint32_t timeout = 0;  // msec, i2cTimeout plus the time the bytes take
+    bool running = false;
+    uint8_t result = i2cDone;
+
+    void release();
+};
+#endif
+
+class I2cQueue {
+  public:
+    I2cQueue(I2cBus &bus) : bus(&bus) {}
+
+    // Switches to another backend, only while idle
+    bool setBus(I2cBus &newBus);
+
+    // Queues a transaction, false if the queue is full or it is already queued
+    bool submit(i2cTransaction &transaction);
+
+    // Picks up a finished transfer and starts the next one, call once per loop
+    // (more often while a display flush is running shortens it)
+    void service();
+
+    bool idle() const { return !count; }
+    uint8_t queued() const { return count; }
+
+    uint32_t completed = 0;  // transactions finished
+    uint32_t failed = 0;     // transactions that ended in i2cFailed
+
+  private:
+    I2cBus *bus;
+    i2cTransaction *queue[i2cQueueLength] = {};
+    uint8_t count = 0;
+    uint16_t nextOrder = 0;
+    int8_t active = -1;        // slot with a chunk on the bus
+    uint16_t activeLength = 0;  // data bytes in that chunk
+
+    int8_t pick() const;
+    void finish(uint8_t slot, uint8_t status);
+};
+
+#endif
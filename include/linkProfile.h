@@ -0,0 +1,123 @@
+#ifndef LINK_PROFILE_H
+#define LINK_PROFILE_H
+
+// BLE link profiles, connection parameters / PHY / data length per connection
+// The central picks the connection interval, anywhere from 7.5ms to over 100ms. The
+// link manager asks for what the current use needs instead:
+//   low latency - short interval, no slave latency, while a central is watching the live angles
+//   low power   - long interval with slave latency, for idle monitoring
+// Every connection also gets the 2M PHY and long packets (DLE) once; both cut airtime,
+// which saves power as well. The requests go out one at a time per connection (the
+// link layer runs one procedure at a time), spaced by requestGap, and switching
+// profiles only re-requests the connection parameters. The central has the final say; the HCI status of each
+// request is reported through linkDiagnostics.
+
+#include <stdint.h>
+#include "textFormat.h"
+#include "bleLinks.h"
+
+enum linkProfiles : uint8_t {
+  linkProfileLowPower,
+  linkProfileLowLatency,
+  linkProfileCount
+};
+
+#define linkPhy1M 1
+#define linkPhy2M 2
+#define linkPhy linkPhy2M   // requested on every connection
+#define linkDataLength 251  // max link layer payload bytes requested (27 = no DLE)
+#define linkNoHandle 0xFFFF
+#define linkNotRequested 0xFF  // status of a request that hasn't been sent
+
+struct linkSettings {
+  uint16_t intervalMin;  // 1.25ms units
+  uint16_t intervalMax;
+  uint16_t latency;      // connection events the peripheral may skip
+  uint16_t timeout;      // supervision timeout, 10ms units
+};
+
+// Reported by the diagnostics characteristic (little endian)
+struct __attribute__((packed)) linkDiagnostics {
+  uint8_t version;       // 1
+  uint8_t profile;       // linkProfiles
+  uint8_t links;         // connected centrals
+  uint16_t intervalMin;  // requested, 1.25ms units
+  uint16_t intervalMax;
+  uint16_t latency;
+  uint16_t timeout;      // 10ms units
+  uint8_t phy;           // requested
+  uint16_t dataLength;   // requested
+  uint8_t parameterStatus;  // HCI status of the newest link's requests, 0 = accepted
+  uint8_t phyStatus;
+  uint8_t dataLengthStatus;
+};
+
+// Controller access used by the manager, so the state machine can run against a mock
+class LinkControl {
+  public:
+    virtual ~LinkControl() {}
+    virtual uint16_t handle(const char *address) = 0;  // connection handle, linkNoHandle if unknown
+    // each returns the HCI status, 0 = accepted
+    virtual uint8_t setParameters(uint16_t handle, const linkSettings &settings) = 0;
+    virtual uint8_t setPhy(uint16_t handle, uint8_t phy) = 0;
+    virtual uint8_t setDataLength(uint16_t handle, uint16_t length) = 0;
+};
+
+#if defined(NRF52840_XXAA)
+// ArduinoBLE HCI commands (LE Connection Update, LE Set PHY, LE Set Data Length)
+class HciLinkControl : public LinkControl {
+  public:
+    uint16_t handle(const char *address) override;
+    uint8_t setParameters(uint16_t handle, const linkSettings &settings) override;
+    uint8_t setPhy(uint16_t handle, uint8_t phy) override;
+    uint8_t setDataLength(uint16_t handle, uint16_t length) override;
+};
+#endif
+
+class LinkManager {
+  public:
+    LinkManager(LinkControl &control) : control(control) {}
+
+    uint16_t requestGap = 100;  // msec between requests on a link
+
+    void connect(const char *address, uint32_t now);
+    void disconnect(const char *address);
+
+    // Switches every link to a profile, only sends anything if it changed
+    void setProfile(uint8_t profile);
+    uint8_t profile() const { return current; }
+
+    // Sends at most one pending request, call once per loop
+    // returns true when the diagnostics changed
+    bool service(uint32_t now);
+
+    void diagnostics(linkDiagnostics *report) const;
+
+    static const linkSettings settings[linkProfileCount];
+
+  private:
+    enum linkSteps : uint8_t {
+      linkStepParameters = 1,
+      linkStepPhy = 2,
+      linkStepDataLength = 4
+    };
+    struct linkState {
+      bool used = false;
+      char address[addressLength + 1] = "";
+      uint16_t handle = linkNoHandle;
+      uint8_t steps = 0;  // linkSteps still to send
+      uint32_t lastRequest = 0;
+      uint8_t parameterStatus = linkNotRequested;
+      uint8_t phyStatus = linkNotRequested;
+      uint8_t dataLengthStatus = linkNotRequested;
+    };
+
+    LinkControl &control;
+    linkState links[bleMaxLinks];
+    uint8_t current = linkProfileLowPower;
+    int8_t newest = -1;  // link shown in the diagnostics
+
+    linkState *find(const char *address);
+};
+
+#endif
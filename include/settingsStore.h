@@ -0,0 +1,107 @@
+#ifndef SETTINGS_STORE_H
+#define SETTINGS_STORE_H
+
+// Persistent settings for the ble-inclinometer
+// Small key-value store kept in two pages of internal flash.
+// Values are appended as records (never rewritten in place), so each put() only
+// programs a few words and wear is spread across the whole page. When the active
+// page fills up, the latest value of every key is copied to the spare page, which
+// then becomes active and the old page is erased.
+//
+// Record layout (32 bit words, flash erases to 0xFFFFFFFF):
+//   header | payload words... | crc32(header + payload) | commit
+// The commit word is programmed last, so a record torn by power loss is ignored
+// at boot and the previous value of that key is used instead.
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Settings keys, each one stores a single small value
+enum settingsKey : uint8_t {
+  settingsKeyTare = 1,         // tareSettings
+  settingsKeyCalibration = 2,  // calibrationSettings
+  settingsKeyConfig = 3,       // commandConfig, runtime settings saved by commandPersist
+  settingsKeyFilter = 4,       // uint8_t filter type (unused, part of settingsKeyConfig)
+  settingsKeyDisplayMode = 5,  // uint8_t OLED display mode
+  settingsKeyDfu = 6,          // dfuProgress, firmware update in progress
+  settingsKeyCount             // keep last
+};
+
+struct tareSettings {
+  float roll;   // raw roll value when tared
+  float pitch;  // raw pitch value when tared
+};
+
+struct calibrationSettings {
+  float offsetX;  // accelerometer zero-g offsets (g)
+  float offsetY;
+  float offsetZ;
+};
+
+#define settingsMaxValueSize 32  // largest value put() accepts (bytes)
+
+// Flash access used by the store, so it can run against internal flash or a RAM copy
+class SettingsFlash {
+  public:
+    virtual ~SettingsFlash() {}
+    virtual void read(uint32_t address, void *data, uint32_t length) = 0;
+    // program word aligned data, bits can only be cleared (1 -> 0)
+    virtual void program(uint32_t address, const uint32_t *words, uint32_t count) = 0;
+    virtual void erase(uint32_t pageAddress) = 0;
+};
+
+#if defined(NRF52840_XXAA)
+// nRF52840 internal flash via the NVMC registers
+class NvmcFlash : public SettingsFlash {
+  public:
+    void read(uint32_t address, void *data, uint32_t length) override;
+    void program(uint32_t address, const uint32_t *words, uint32_t count) override;
+    void erase(uint32_t pageAddress) override;
+};
+#endif
+
+class SettingsStore {
+  public:
+    // baseAddress must point at two consecutive erasable pages of pageSize bytes
+    SettingsStore(SettingsFlash &flash, uint32_t baseAddress, uint32_t pageSize);
+
+    // Scans flash once and indexes the newest record of every key
+    // returns false only if the store had to be formatted
+    bool begin();
+
+    // Copies the stored value of key into value, false if not stored (or wrong size)
+    bool get(uint8_t key, void *value, uint8_t length) const;
+
+    // Appends a new value for key, skipped if the value is unchanged
+    bool put(uint8_t key, const void *value, uint8_t length);
+
+    uint32_t freeBytes() const { return pageSize - writeOffset; }
+    uint32_t eraseCount() const { return pageSequence; }  // compactions since format
+
+  private:
+    struct recordHeader {
+      uint8_t magic;
+      uint8_t key;
+      uint8_t length;
+      uint8_t reserved;
+    };
+
+    SettingsFlash &flash;
+    uint32_t baseAddress;
+    uint32_t pageSize;
+    uint8_t activePage = 0;
+    uint32_t pageSequence = 0;
+    uint32_t writeOffset = 0;              // next free byte in the active page
+    uint16_t index[settingsKeyCount] = {};  // offset of newest record per key, 0 = none
+
+    uint32_t pageAddress(uint8_t page) const { return baseAddress + page * pageSize; }
+    bool pageValid(uint8_t page, uint32_t *sequence) const;
+    void scanPage();
+    void formatPage(uint8_t page, uint32_t sequence);
+    bool compact();
+    bool appendRecord(uint8_t key, const void *value, uint8_t length);
+    static constexpr uint32_t recordWords(uint8_t length) { return 3 + (length + 3) / 4; }
+    static uint32_t crc32(const void *data, uint32_t length, uint32_t crc = 0xFFFFFFFF);
+};
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef SETTLE_DETECTOR_H
+#define SETTLE_DETECTOR_H
+
+// Settled reading detection
+// A Welford running mean/variance is kept for each axis over the samples since the
+// angle last moved. A sample far outside the current spread (a step) restarts both
+// trackers, and the reading counts as settled once enough samples have gone by with
+// a small spread; a stretch of minSamples that is still too noisy starts over.
+// O(1) per sample, no buffers.
+
+#include <stdint.h>
+
+#define settleMaxCount 4096  // tracker sample count cap, older samples then fade out
+
+struct WelfordTracker {
+  uint16_t count = 0;
+  float mean = 0;
+  float m2 = 0;  // sum of squared differences from the mean
+
+  void reset() { count = 0; mean = 0; m2 = 0; }
+  void add(float value) {
+    if (count < settleMaxCount) {
+      count++;
+    }
+    float delta = value - mean;
+    mean += delta / count;
+    m2 += delta * (value - mean);
+    if (count == settleMaxCount) {
+      m2 -= m2 / count;  // keep the variance estimate from growing stale
+    }
+  }
+  float variance() const { return count > 1 ? m2 / (count - 1) : 0; }
+};
+
+class SettleDetector {
+  public:
+    float noise = 0.05;        // degrees, max standard deviation of a settled reading
+    uint16_t minSamples = 64;  // samples the angle must hold still
+    float stepSigma = 4;       // a sample this many deviations (at least noise) away restarts
+
+    // Adds one sample of the angles (degrees)
+    void add(float roll, float pitch);
+
+    bool settled() const;
+    float roll() const { return rollTracker.mean; }
+    float pitch() const { return pitchTracker.mean; }
+
+  private:
+    WelfordTracker rollTracker;
+    WelfordTracker pitchTracker;
+    bool isStep(const WelfordTracker &tracker, float value) const;
+};
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef SPLASH_SCREEN_H
+#define SPLASH_SCREEN_H
+
+// Boot splash screen for the ble-inclinometer, in SSD1306 page order and run-length
+// encoded so startOLED() streams it straight to the display (streamImageRLE()).
+// Everything below the include is generated from images/splashScreen.bmp with
+//   python3 lib/Adafruit_SSD1306/scripts/make_splash.py images/splashScreen.bmp splashScreen --rle
+
+#include <Arduino.h>
+
+#define splashScreen_width  128
+#define splashScreen_height 64
+
+// SSD1306 page order, run-length encoded (386 of 1024 bytes)
+const uint8_t PROGMEM splashScreen_data[] = {
+  0xb1,0xff,0x00,0xe7,0x87,0x67,0x02,0xe7,0x67,0x67,0x86,0xe7,0x85,0x67,0xe7,0xff,
+  0x02,0x80,0x80,0x9f,0x82,0x93,0x04,0x80,0xc0,0xff,0x80,0x80,0x83,0x9f,0x04,0xbf,
+  0xff,0xe0,0xc0,0x8e,0x82,0x93,0x00,0x9b,0xc2,0xff,0xa3,0x9f,0x00,0x9d,0x97,0x99,
+  0x00,0x9d,0xa3,0x9f,0x9d,0xff,0x10,0x01,0x01,0xff,0x07,0x03,0xf9,0xf9,0xfd,0xf9,
+  0xf9,0x03,0x07,0xff,0x87,0x03,0x39,0x79,0x82,0x7d,0x02,0xff,0x01,0x01,0x83,0x7f,
+  0x27,0xff,0x01,0x01,0xff,0x07,0x03,0xf9,0xf9,0xfd,0xf9,0xf9,0x03,0x07,0xff,0x83,
+  0x01,0x39,0x7d,0x7d,0x79,0x01,0x83,0xff,0x7f,0x03,0x11,0xfd,0xfd,0x11,0x01,0x71,
+  0xfd,0xfd,0x71,0x01,0x7f,0xff,0x83,0x11,0x79,0x82,0x4d,0x06,0x7d,0xff,0xfd,0xfd,
+  0xf9,0x01,0x01,0x82,0xfd,0x03,0xff,0x83,0x01,0x39,0x82,0x4d,0x0a,0x6d,0xff,0x01,
+  0x01,0xf9,0xdd,0xcd,0x89,0x01,0x01,0x77,0x9d,0xff,0x04,0xe6,0xe6,0xe7,0xe6,0xe6,
+  0x84,0xe7,0x01,0xe6,0xe6,0x82,0xe7,0x84,0xe6,0x00,0xe7,0x85,0xe6,0x05,0xe7,0xe6,
+  0xe6,0xe7,0xe6,0xe6,0x84,0xe7,0x01,0xe6,0xe6,0x82,0xe7,0x83,0xe6,0x83,0xe7,0x00,
+  0xe6,0x83,0xe7,0x00,0xe6,0x83,0xe7,0x00,0xe6,0x83,0xe7,0x84,0xe6,0x83,0xe7,0x01,
+  0xe6,0xe6,0x85,0xe7,0x84,0xe6,0x02,0xe7,0xe6,0xe6,0x84,0xe7,0x01,0xe6,0xe6,0xff,
+  0xff,0x9a,0xff,0x09,0x1f,0x7f,0x7f,0xff,0xff,0x7f,0xff,0xff,0x7f,0x7f,0x83,0xff,
+  0x04,0xdf,0xcf,0xcf,0x8f,0x0f,0x82,0xcf,0x03,0xdf,0xff,0x0f,0x0f,0x83,0x4f,0x04,
+  0x0f,0x0f,0xff,0xff,0x0f,0x85,0xff,0x04,0x1f,0xff,0xff,0x0f,0x0f,0x85,0xcf,0x02,
+  0xff,0xff,0x0f,0x87,0xff,0x01,0x1f,0x0f,0x85,0xcf,0x04,0x0f,0xff,0xff,0x0f,0x8f,
+  0x84,0xcf,0x05,0x8f,0x1f,0xff,0x1f,0x1f,0xdf,0x82,0xcf,0x01,0x0f,0x8f,0x82,0xcf,
+  0x02,0xff,0x1f,0x0f,0x85,0xcf,0x97,0xff,0x08,0xf0,0xf7,0xf6,0xf0,0xff,0xfe,0xd1,
+  0xe3,0xfc,0x88,0xff,0x00,0xf0,0x84,0xff,0x00,0xf0,0x82,0xf8,0x06,0xfa,0xf2,0xf6,
+  0xf6,0xff,0xff,0xf0,0x85,0xf3,0x05,0xf0,0xff,0xff,0xf0,0xf3,0xf3,0x84,0xf0,0x02,
+  0xff,0xff,0xf0,0x86,0xf3,0x02,0xff,0xf0,0xf0,0x85,0xf3,0x03,0xf0,0xff,0xff,0xf0,
+  0x85,0xf3,0x04,0xf9,0xfc,0xff,0xf0,0xf0,0x83,0xff,0x00,0xf0,0x84,0xff,0x87,0xf0,
+  0x8c,0xff,
+};
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef TARE_ENGINE_H
+#define TARE_ENGINE_H
+
+// Tare from the live sample stream
+// Every accelerometer sample goes into a short sliding window with running sums.
+// A tare request completes as soon as the window mean is steady (the standard error
+// of the mean is below the tolerance on every axis), which on a still surface is
+// right away. If the surface keeps moving it waits, up to a timeout, then takes the
+// mean it has.
+
+#include "accelFifo.h"
+
+#define tareWindow 64  // samples in the sliding window (~0.3 sec at 208Hz)
+
+class TareEngine {
+  public:
+    uint16_t tolerance = 6;   // max standard error of the mean, accelerometer counts
+    uint16_t timeout = 2000;  // msec to wait for a steady window
+
+    // Adds a sample to the window, O(1)
+    void addSample(const accelSample &sample);
+
+    // Empties the window (after an IMU range change)
+    void clear();
+
+    // Starts a tare, completed by poll()
+    void request(uint32_t now);
+    bool pending() const { return requested; }
+
+    // true once, when the pending tare completes, with the window mean (counts) in x, y, z
+    bool poll(uint32_t now, float *x, float *y, float *z);
+
+    // window is full and steady
+    bool steady() const;
+
+  private:
+    accelSample window[tareWindow];
+    uint8_t head = 0;
+    uint8_t count = 0;
+    int32_t sum[3] = {};
+    int64_t sumSquares[3] = {};
+    bool requested = false;
+    uint32_t requestMillis = 0;
+};
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+// Non-blocking Serial telemetry for the ble-inclinometer
+// Everything printed to telemetry goes into a ring buffer, and service() hands the
+// port only as many bytes as it can take without blocking. Text is committed a whole
+// line at a time; when the buffer is full the line is dropped (and counted) instead
+// of stalling the measurement loop behind a USB host that isn't reading.
+//
+// Binary mode replaces the text lines with COBS framed structs (0x00 delimited),
+// for desktop tools that want every update.
+
+#include <Arduino.h>
+
+#define telemetryBufferSize 2048  // ring buffer bytes (power of 2), ~0.1 sec of a 1.6kHz stream
+#define telemetryLineSize 96      // longest text line
+#define telemetryMaxFrame 64      // largest binary struct
+
+enum telemetryLevels : uint8_t {
+  telemetryOff,   // nothing
+  telemetryInfo,  // status messages (boot, connections, tare)
+  telemetryData   // status plus a line per update
+};
+
+// Binary frame types, first byte of every frame
+enum telemetryFrameTypes : uint8_t {
+  telemetryFrameData = 1,   // telemetryDataFrame
+  telemetryFrameRaw = 2,    // telemetrySamplesHeader + int16 x,y,z counts per sample
+  telemetryFrameAngles = 3  // telemetrySamplesHeader + int16 roll,pitch (0.01 degrees) per sample
+};
+
+struct __attribute__((packed)) telemetryDataFrame {
+  uint8_t type;       // telemetryFrameData
+  uint8_t sequence;   // increments every frame, gaps = dropped frames
+  uint32_t millis;
+  float roll;         // degrees
+  float pitch;
+  float battery;      // volts
+};
+
+// Header of the USB stream frames, one frame carries a run of consecutive IMU samples
+struct __attribute__((packed)) telemetrySamplesHeader {
+  uint8_t type;         // telemetryFrameRaw or telemetryFrameAngles
+  uint8_t count;        // samples in this frame
+  uint32_t firstSample; // index of the first sample since boot, gaps = lost samples
+};
+
+class Telemetry : public Print {
+  public:
+    uint8_t level = telemetryData;
+    bool binary = false;     // COBS frames instead of text
+    uint16_t dataPeriod = 0; // minimum msec between data records, 0 = every update
+    uint32_t dropped = 0;    // lines/frames lost to a full buffer
+
+    // true if text at this level should be printed
+    bool enabled(uint8_t minimumLevel) const { return !binary && level >= minimumLevel; }
+    // true if a data record is due now (level and rate limit)
+    bool dataDue(uint32_t now);
+
+    // Print interface, text is held until the end of the line
+    size_t write(uint8_t c) override;
+    using Print::write;
+
+    // Queues a struct as one COBS frame, all or nothing
+    bool sendFrame(const void *data, uint8_t length);
+
+    // Moves queued bytes to the port without blocking, call once per loop
+    void service(Print &port);
+
+    uint16_t queued() const { return (head - tail) & (telemetryBufferSize - 1); }
+
+  private:
+    uint8_t buffer[telemetryBufferSize];
+    uint16_t head = 0;  // next write
+    uint16_t tail = 0;  // next read
+    char line[telemetryLineSize];
+    uint8_t lineLength = 0;
+    bool lineOverflow = false;
+    uint32_t lastData = 0;
+    bool dataSent = false;
+
+    uint16_t space() const { return telemetryBufferSize - 1 - queued(); }
+    void push(const uint8_t *data, uint16_t length);
+};
+
+extern Telemetry telemetry;
+
+#endif
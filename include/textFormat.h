@@ -0,0 +1,36 @@
+#ifndef TEXT_FORMAT_H
+#define TEXT_FORMAT_H
+
+// Allocation free number/text formatting for BLE, OLED and Serial output
+// formatFixed() produces the same text as dtostrf() (printf "%*.*f"), but uses
+// integer math only and writes into caller owned fixed size buffers.
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define formatMaxDecimals 6
+#define formatBufferSize 20  // fits sign, 10 integer digits, point and 6 decimals
+#define addressLength 17  // "xx:xx:xx:xx:xx:xx"
+
+// Core formatter, writes at most size - 1 characters plus the terminator and returns the length
+// width > 0 right aligns, width < 0 left aligns (like dtostrf), values beyond 32 bits print "ovf"
+uint8_t formatFixed(char *buffer, size_t size, float value, int8_t width, uint8_t decimals);
+
+// Fixed buffer versions, the buffer must fit the widest possible result
+template <size_t size>
+inline uint8_t formatFixed(char (&buffer)[size], float value, int8_t width, uint8_t decimals) {
+  static_assert(size >= formatBufferSize, "buffer too small for formatFixed()");
+  return formatFixed(buffer, size, value, width, decimals);
+}
+
+// Copies a BLE address string ("xx:xx:xx:xx:xx:xx") into a fixed buffer
+inline void copyAddress(char (&buffer)[addressLength + 1], const char *address) {
+  uint8_t i = 0;
+  while (i < addressLength && address[i]) {
+    buffer[i] = address[i];
+    i++;
+  }
+  buffer[i] = 0;
+}
+
+#endif
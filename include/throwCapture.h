@@ -0,0 +1,53 @@
+#ifndef THROW_CAPTURE_H
+#define THROW_CAPTURE_H
+
+// Min/max (peak hold) capture of the angles, for measuring full control surface throw
+// Every sample is lightly low pass filtered (single pole, so sensor noise doesn't
+// inflate the extremes) and compared against the running min/max of each axis.
+// Nothing is averaged away between readings, so a quick sweep to an endpoint is
+// caught even though the display only updates a couple of times a second.
+
+#include <stdint.h>
+
+struct captureAxis {
+  float filtered = 0;
+  float minimum = 0;
+  float maximum = 0;
+
+  void start(float value) { filtered = value; minimum = value; maximum = value; }
+  void add(float value, float smoothing) {
+    filtered += (value - filtered) * smoothing;
+    if (filtered < minimum) {
+      minimum = filtered;
+    }
+    if (filtered > maximum) {
+      maximum = filtered;
+    }
+  }
+  float span() const { return maximum - minimum; }
+};
+
+class ThrowCapture {
+  public:
+    float smoothing = 1;  // filter coefficient per sample, 1 = no filtering
+
+    // Sets the filter from a time constant (msec) at the accelerometer rate (Hz)
+    void setFilter(uint16_t timeConstant, uint16_t sampleRate);
+
+    // Adds one sample of the angles (degrees), O(1)
+    void add(float roll, float pitch);
+
+    // Starts over from the next sample
+    void reset() { empty = true; }
+
+    bool captured() const { return !empty; }
+    const captureAxis &roll() const { return rollAxis; }
+    const captureAxis &pitch() const { return pitchAxis; }
+
+  private:
+    captureAxis rollAxis;
+    captureAxis pitchAxis;
+    bool empty = true;
+};
+
+#endif
@@ -118,6 +118,9 @@ Adafruit_BusIO_Register::Adafruit_BusIO_Register(
 bool Adafruit_BusIO_Register::write(uint8_t *buffer, uint8_t len) {
   uint8_t addrbuffer[2] = {(uint8_t)(_address & 0xFF),
                            (uint8_t)(_address >> 8)};
+  if (useCache(len)) {
+    return _cache->write(_address, buffer, len);
+  }
   if (_i2cdevice) {
     return _i2cdevice->write(buffer, len, true, addrbuffer, _addrwidth);
   }
@@ -219,6 +222,9 @@ uint32_t Adafruit_BusIO_Register::readCached(void) { return _cached; }
 bool Adafruit_BusIO_Register::read(uint8_t *buffer, uint8_t len) {
   uint8_t addrbuffer[2] = {(uint8_t)(_address & 0xFF),
                            (uint8_t)(_address >> 8)};
+  if (useCache(len)) {
+    return _cache->read(_address, buffer, len);
+  }
   if (_i2cdevice) {
     return _i2cdevice->write_then_read(addrbuffer, _addrwidth, buffer, len);
   }
@@ -381,4 +387,19 @@ void Adafruit_BusIO_Register::setAddressWidth(uint16_t address_width) {
   _addrwidth = address_width;
 }
 
+/*!
+ *    @brief  Serve this register from a shared register cache. Only used for
+ * I2C registers with 8-bit addresses that lie inside the cached block, other
+ * accesses still go straight to the bus.
+ *    @param cache The cache covering this register, or nullptr to stop using
+ * one
+ */
+void Adafruit_BusIO_Register::setCache(Adafruit_BusIO_RegisterCache *cache) {
+  _cache = cache;
+}
+
+bool Adafruit_BusIO_Register::useCache(uint8_t len) {
+  return _cache && _i2cdevice && _addrwidth == 1 && _cache->covers(_address, len);
+}
+
 #endif // SPI exists
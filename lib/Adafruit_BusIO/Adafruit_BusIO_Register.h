@@ -6,6 +6,7 @@
 #if !defined(SPI_INTERFACES_COUNT) ||                                          \
     (defined(SPI_INTERFACES_COUNT) && (SPI_INTERFACES_COUNT > 0))
 
+#include <Adafruit_BusIO_RegisterCache.h>
 #include <Adafruit_GenericDevice.h>
 #include <Adafruit_I2CDevice.h>
 #include <Adafruit_SPIDevice.h>
@@ -76,6 +77,7 @@ public:
   void setWidth(uint8_t width);
   void setAddress(uint16_t address);
   void setAddressWidth(uint16_t address_width);
+  void setCache(Adafruit_BusIO_RegisterCache *cache);
 
 #if !defined(NO_GLOBAL_INSTANCES) && !defined(NO_GLOBAL_SERIAL)
   void print(Stream *s = &Serial);
@@ -95,6 +97,8 @@ private:
   uint8_t _buffer[4]; // we won't support anything larger than uint32 for
                       // non-buffered read
   uint32_t _cached = 0;
+  Adafruit_BusIO_RegisterCache *_cache = nullptr;
+  bool useCache(uint8_t len);
 };
 
 /*!
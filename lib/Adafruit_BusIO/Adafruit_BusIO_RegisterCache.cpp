@@ -0,0 +1,244 @@
+#include "Adafruit_BusIO_RegisterCache.h"
+
+/*!
+ *    @brief  Create a cache for a block of consecutive registers on one device
+ *    @param  i2cdevice The I2CDevice the registers live on
+ *    @param  first_addr The lowest register address in the block
+ *    @param  count How many registers the block holds, at most
+ * BUSIO_CACHE_MAX_REGISTERS
+ */
+Adafruit_BusIO_RegisterCache::Adafruit_BusIO_RegisterCache(
+    Adafruit_I2CDevice *i2cdevice, uint8_t first_addr, uint8_t count) {
+  _i2cdevice = i2cdevice;
+  _first = first_addr;
+  _count = min(count, (uint8_t)BUSIO_CACHE_MAX_REGISTERS);
+  _deferred = false;
+  _transactions = 0;
+  memset(_volatile, 0, sizeof(_volatile));
+  invalidateAll();
+}
+
+/*!
+ *    @brief  Check whether a run of registers lies inside this cache
+ *    @param  reg_addr The first register address of the run
+ *    @param  len Number of registers in the run
+ *    @return True if every register of the run is covered
+ */
+bool Adafruit_BusIO_RegisterCache::covers(uint16_t reg_addr, uint8_t len) {
+  return len != 0 && reg_addr >= _first &&
+         reg_addr + len <= (uint16_t)_first + _count;
+}
+
+/*!
+ *    @brief  Read registers, from the shadow when every value is known and
+ * none are volatile, otherwise with one bus read that refreshes the shadow
+ *    @param  reg_addr The first register address to read
+ *    @param  buffer Buffer to read data into
+ *    @param  len Number of registers to read
+ *    @return True on success, false if the run is not covered or the read
+ * failed
+ */
+bool Adafruit_BusIO_RegisterCache::read(uint8_t reg_addr, uint8_t *buffer,
+                                        uint8_t len) {
+  if (!covers(reg_addr, len)) {
+    return false;
+  }
+  uint8_t index = reg_addr - _first;
+
+  bool known = !anyVolatile(index, len);
+  for (uint8_t i = 0; known && i < len; i++) {
+    known = test(_valid, index + i);
+  }
+  if (!known) {
+    _transactions++;
+    if (!_i2cdevice->write_then_read(&reg_addr, 1, buffer, len)) {
+      return false;
+    }
+    for (uint8_t i = 0; i < len; i++) {
+      uint8_t r = index + i;
+      if (test(_volatile, r)) {
+        continue;
+      }
+      if (test(_dirty, r)) {
+        // a deferred write is still pending, it wins over the device
+        buffer[i] = _shadow[r];
+      } else {
+        _shadow[r] = buffer[i];
+        set(_valid, r, true);
+      }
+    }
+    return true;
+  }
+
+  memcpy(buffer, &_shadow[index], len);
+  return true;
+}
+
+/*!
+ *    @brief  Write registers. The shadow is always updated; the bus is written
+ * now unless writes are deferred (volatile registers are always written now).
+ * Write-through skips registers whose known value would not change.
+ *    @param  reg_addr The first register address to write
+ *    @param  buffer Pointer to data to write
+ *    @param  len Number of registers to write
+ *    @return True on success, false if the run is not covered or the write
+ * failed
+ */
+bool Adafruit_BusIO_RegisterCache::write(uint8_t reg_addr,
+                                         const uint8_t *buffer, uint8_t len) {
+  if (!covers(reg_addr, len)) {
+    return false;
+  }
+  uint8_t index = reg_addr - _first;
+  bool now = !_deferred || anyVolatile(index, len);
+
+  bool changed = false;
+  for (uint8_t i = 0; i < len; i++) {
+    uint8_t r = index + i;
+    if (test(_volatile, r) || !test(_valid, r) || _shadow[r] != buffer[i]) {
+      changed = true;
+      if (!now) {
+        set(_dirty, r, true);
+      }
+    }
+    _shadow[r] = buffer[i];
+    set(_valid, r, !test(_volatile, r));
+  }
+  if (!now || !changed) {
+    return true;
+  }
+
+  if (!writeBurst(index, len)) {
+    invalidate(reg_addr, len);
+    return false;
+  }
+  for (uint8_t i = 0; i < len; i++) {
+    set(_dirty, index + i, false);
+  }
+  return true;
+}
+
+/*!
+ *    @brief  Send every deferred write. Dirty registers that are close
+ * together go out in one auto-incrementing burst, rewriting the known values
+ * of clean registers between them instead of starting a new transaction.
+ *    @return True if every burst was acknowledged. Failed runs stay dirty.
+ */
+bool Adafruit_BusIO_RegisterCache::flush(void) {
+  size_t max_burst = _i2cdevice->maxBufferSize() - 1; // less the address byte
+  if (max_burst > BUSIO_CACHE_MAX_REGISTERS) {
+    max_burst = BUSIO_CACHE_MAX_REGISTERS;
+  }
+
+  bool ok = true;
+  uint8_t index = 0;
+  while (index < _count) {
+    if (!test(_dirty, index)) {
+      index++;
+      continue;
+    }
+    // grow the run over dirty and known clean registers, then trim the tail
+    // back to the last dirty one
+    uint8_t end = index + 1;
+    uint8_t last = index;
+    while (end < _count && (size_t)(end - index) < max_burst &&
+           !test(_volatile, end) &&
+           (test(_dirty, end) || test(_valid, end))) {
+      if (test(_dirty, end)) {
+        last = end;
+      }
+      end++;
+    }
+    uint8_t len = last - index + 1;
+    if (writeBurst(index, len)) {
+      for (uint8_t i = 0; i < len; i++) {
+        set(_dirty, index + i, false);
+      }
+    } else {
+      ok = false;
+    }
+    index += len;
+  }
+  return ok;
+}
+
+/*!
+ *    @brief  Choose between write-through and deferred (write-back) mode.
+ * Leaving deferred mode does not flush, call flush() first.
+ *    @param  deferred True to hold writes in the shadow until flush()
+ */
+void Adafruit_BusIO_RegisterCache::setDeferred(bool deferred) {
+  _deferred = deferred;
+}
+
+/*!
+ *    @brief  Mark registers the device can change by itself. They are never
+ * served from the shadow and never deferred.
+ *    @param  reg_addr The first register address
+ *    @param  len Number of registers
+ */
+void Adafruit_BusIO_RegisterCache::setVolatile(uint8_t reg_addr,
+                                               uint8_t len) {
+  if (!covers(reg_addr, len)) {
+    return;
+  }
+  for (uint8_t i = 0; i < len; i++) {
+    uint8_t r = reg_addr - _first + i;
+    set(_volatile, r, true);
+    set(_valid, r, false);
+    set(_dirty, r, false);
+  }
+}
+
+/*!
+ *    @brief  Forget the shadow value of registers (for example after a device
+ * reset), the next read goes to the bus. Pending writes to them are dropped.
+ *    @param  reg_addr The first register address
+ *    @param  len Number of registers
+ */
+void Adafruit_BusIO_RegisterCache::invalidate(uint8_t reg_addr, uint8_t len) {
+  if (!covers(reg_addr, len)) {
+    return;
+  }
+  for (uint8_t i = 0; i < len; i++) {
+    uint8_t r = reg_addr - _first + i;
+    set(_valid, r, false);
+    set(_dirty, r, false);
+  }
+}
+
+/*!
+ *    @brief  Forget every shadow value and drop every pending write
+ */
+void Adafruit_BusIO_RegisterCache::invalidateAll(void) {
+  memset(_valid, 0, sizeof(_valid));
+  memset(_dirty, 0, sizeof(_dirty));
+}
+
+/*!
+ *    @brief  Check for deferred writes that have not been flushed
+ *    @return True if any register is dirty
+ */
+bool Adafruit_BusIO_RegisterCache::dirty(void) {
+  for (uint8_t i = 0; i < sizeof(_dirty); i++) {
+    if (_dirty[i]) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool Adafruit_BusIO_RegisterCache::anyVolatile(uint8_t index, uint8_t len) {
+  for (uint8_t i = 0; i < len; i++) {
+    if (test(_volatile, index + i)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool Adafruit_BusIO_RegisterCache::writeBurst(uint8_t index, uint8_t len) {
+  uint8_t reg_addr = _first + index;
+  _transactions++;
+  return _i2cdevice->write(&_shadow[index], len, true, &reg_addr, 1);
+}
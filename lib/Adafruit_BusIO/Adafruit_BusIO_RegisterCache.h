@@ -0,0 +1,63 @@
+#ifndef Adafruit_BusIO_RegisterCache_h
+#define Adafruit_BusIO_RegisterCache_h
+
+#include <Adafruit_I2CDevice.h>
+#include <Arduino.h>
+
+#define BUSIO_CACHE_MAX_REGISTERS 64 ///< Largest block of registers a cache covers
+
+/*!
+ * @brief A write-back shadow of a block of 8-bit addressed I2C registers.
+ * Registers attached with Adafruit_BusIO_Register::setCache() read their value
+ * from the shadow once it is known, so RegisterBits updates no longer cost a
+ * read-modify-write round trip. With deferred writes enabled, writes only
+ * update the shadow and mark it dirty; flush() then sends every dirty run in
+ * as few auto-incrementing bursts as the device buffer allows. Registers that
+ * the device changes by itself (status, data outputs, self clearing bits)
+ * must be marked volatile so they are always read from and written to the bus.
+ */
+class Adafruit_BusIO_RegisterCache {
+public:
+  Adafruit_BusIO_RegisterCache(Adafruit_I2CDevice *i2cdevice,
+                               uint8_t first_addr, uint8_t count);
+
+  bool covers(uint16_t reg_addr, uint8_t len);
+  bool read(uint8_t reg_addr, uint8_t *buffer, uint8_t len);
+  bool write(uint8_t reg_addr, const uint8_t *buffer, uint8_t len);
+  bool flush(void);
+
+  void setDeferred(bool deferred);
+  void setVolatile(uint8_t reg_addr, uint8_t len = 1);
+  void invalidate(uint8_t reg_addr, uint8_t len = 1);
+  void invalidateAll(void);
+  bool dirty(void);
+
+  /*!   @brief  Bus transactions issued by this cache since construction
+   *    @return The number of I2C writes and reads it has started */
+  uint32_t transactions(void) { return _transactions; }
+
+private:
+  Adafruit_I2CDevice *_i2cdevice;
+  uint8_t _first, _count;
+  bool _deferred;
+  uint32_t _transactions;
+  uint8_t _shadow[BUSIO_CACHE_MAX_REGISTERS];
+  uint8_t _valid[BUSIO_CACHE_MAX_REGISTERS / 8];
+  uint8_t _dirty[BUSIO_CACHE_MAX_REGISTERS / 8];
+  uint8_t _volatile[BUSIO_CACHE_MAX_REGISTERS / 8];
+
+  static bool test(const uint8_t *bits, uint8_t index) {
+    return bits[index >> 3] & (1 << (index & 7));
+  }
+  static void set(uint8_t *bits, uint8_t index, bool value) {
+    if (value) {
+      bits[index >> 3] |= 1 << (index & 7);
+    } else {
+      bits[index >> 3] &= ~(1 << (index & 7));
+    }
+  }
+  bool anyVolatile(uint8_t index, uint8_t len);
+  bool writeBurst(uint8_t index, uint8_t len);
+};
+
+#endif // Adafruit_BusIO_RegisterCache_h
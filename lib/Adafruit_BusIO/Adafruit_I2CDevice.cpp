@@ -15,6 +15,8 @@ Adafruit_I2CDevice::Adafruit_I2CDevice(uint8_t addr, TwoWire *theWire) {
   _maxBufferSize = 250; // as defined in Wire.h's RingBuffer
 #elif defined(ESP32)
   _maxBufferSize = I2C_BUFFER_LENGTH;
+#elif defined(ARDUINO_ARCH_MBED)
+  _maxBufferSize = 256; // MbedI2C transmit buffer
 #else
   _maxBufferSize = 32;
 #endif
@@ -172,6 +174,42 @@ bool Adafruit_I2CDevice::write(const uint8_t *buffer, size_t len, bool stop,
   }
 }
 
+/*!
+ *    @brief  Write a buffer of any length to the I2C device, behind an optional
+ * prefix (register address, control byte), as a plain chunked write: each part
+ * goes through write(), so it is copied into the Wire buffer like any other
+ * write and blocks until sent. When prefix and data fit in maxBufferSize() they
+ * go out as one transaction, otherwise as consecutive transactions that each
+ * start with the prefix again, which suits devices whose address pointer
+ * auto-increments (display RAM, FIFOs). The firmware's own large transfers (the
+ * OLED frame) don't use this, they go through i2cQueue, where
+ * TwimI2cBus::startDirect() sends straight from the caller's buffer by EasyDMA.
+ *    @param  buffer Pointer to buffer of data to write
+ *    @param  len Number of bytes from buffer to write, no limit
+ *    @param  prefix_buffer Pointer to optional array of data to write before
+ * every part of buffer
+ *    @param  prefix_len Number of bytes from prefix buffer to write, less than
+ * maxBufferSize()
+ *    @return True if every transaction was successful, otherwise false.
+ */
+bool Adafruit_I2CDevice::write_chunked(const uint8_t *buffer, size_t len,
+                                       const uint8_t *prefix_buffer,
+                                       size_t prefix_len) {
+  if (prefix_len >= maxBufferSize()) {
+    return false;
+  }
+  size_t chunk = maxBufferSize() - prefix_len;
+  size_t pos = 0;
+  do {
+    size_t part = ((len - pos) > chunk) ? chunk : (len - pos);
+    if (!write(buffer + pos, part, true, prefix_buffer, prefix_len)) {
+      return false;
+    }
+    pos += part;
+  } while (pos < len);
+  return true;
+}
+
 /*!
  *    @brief  Read from I2C into a buffer from the I2C device.
  *    Cannot be more than maxBufferSize() bytes.
@@ -16,6 +16,9 @@ public:
   bool read(uint8_t *buffer, size_t len, bool stop = true);
   bool write(const uint8_t *buffer, size_t len, bool stop = true,
              const uint8_t *prefix_buffer = nullptr, size_t prefix_len = 0);
+  bool write_chunked(const uint8_t *buffer, size_t len,
+                     const uint8_t *prefix_buffer = nullptr,
+                     size_t prefix_len = 0);
   bool write_then_read(const uint8_t *write_buffer, size_t write_len,
                        uint8_t *read_buffer, size_t read_len,
                        bool stop = false);
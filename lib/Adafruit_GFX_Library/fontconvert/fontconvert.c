@@ -29,25 +29,133 @@ See notes at end for glyph nomenclature & other tidbits.
 
 #define DPI 141 // Approximate res. of Adafruit 2.8" TFT
 
+// Write one byte of the bitmap table, formatted 12 per line
+void enbyte(uint8_t value) {
+  static uint8_t row = 0, firstCall = 1;
+  if (!firstCall) {    // Format output table nicely
+    if (++row >= 12) { // Last entry on line?
+      printf(",\n  "); //   Newline format output
+      row = 0;         //   Reset row counter
+    } else {           // Not end of line
+      printf(", ");    //   Simple comma delim
+    }
+  }
+  printf("0x%02X", value); // Write byte value
+  firstCall = 0;           // Formatting flag
+}
+
 // Accumulate bits for output, with periodic hexadecimal byte write
 void enbit(uint8_t value) {
-  static uint8_t row = 0, sum = 0, bit = 0x80, firstCall = 1;
+  static uint8_t sum = 0, bit = 0x80;
   if (value)
-    sum |= bit;          // Set bit if needed
-  if (!(bit >>= 1)) {    // Advance to next bit, end of byte reached?
-    if (!firstCall) {    // Format output table nicely
-      if (++row >= 12) { // Last entry on line?
-        printf(",\n  "); //   Newline format output
-        row = 0;         //   Reset row counter
-      } else {           // Not end of line
-        printf(", ");    //   Simple comma delim
+    sum |= bit;       // Set bit if needed
+  if (!(bit >>= 1)) { // Advance to next bit, end of byte reached?
+    enbyte(sum);      // Write byte value
+    sum = 0;          // Clear for next byte
+    bit = 0x80;       // Reset bit counter
+  }
+}
+
+// One rendered glyph of a page font, kept until the common height is known
+typedef struct {
+  int code, width, rows, top, left, advance, offset;
+  uint8_t *pixels; // rows * width, 1 byte per pixel
+} pageGlyph;
+
+// Page font (-p): the listed characters only, every glyph rendered into
+// the same number of 8-row pages and written in SSD1306 page order, column
+// bytes with the LSB at the top. See GFXpageFont in gfxfont.h.
+int pageFont(FT_Face face, const char *fontName, int count, int *codes) {
+  int i, j, x, y, err, top = 0, below = 0, height, pages, bitmapOffset = 0;
+  pageGlyph *table;
+
+  if (!(table = (pageGlyph *)calloc(count, sizeof(pageGlyph)))) {
+    fprintf(stderr, "Malloc error\n");
+    return 1;
+  }
+
+  for (i = 0; i < count; i++) {
+    pageGlyph *p = &table[i];
+    FT_Bitmap *bitmap;
+    p->code = codes[i];
+    if ((err = FT_Load_Char(face, p->code, FT_LOAD_TARGET_MONO)) ||
+        (err = FT_Render_Glyph(face->glyph, FT_RENDER_MODE_MONO))) {
+      fprintf(stderr, "Error %d rendering char 0x%02X\n", err, p->code);
+      return err;
+    }
+    bitmap = &face->glyph->bitmap;
+    p->width = bitmap->width;
+    p->rows = bitmap->rows;
+    p->top = face->glyph->bitmap_top;
+    p->left = face->glyph->bitmap_left;
+    p->advance = face->glyph->advance.x >> 6;
+    if (!(p->pixels = (uint8_t *)malloc(p->width * p->rows + 1))) {
+      fprintf(stderr, "Malloc error\n");
+      return 1;
+    }
+    for (y = 0; y < p->rows; y++) {
+      for (x = 0; x < p->width; x++) {
+        p->pixels[y * p->width + x] =
+            (bitmap->buffer[y * bitmap->pitch + x / 8] >> (7 - (x & 7))) & 1;
       }
     }
-    printf("0x%02X", sum); // Write byte value
-    sum = 0;               // Clear for next byte
-    bit = 0x80;            // Reset bit counter
-    firstCall = 0;         // Formatting flag
+    if (p->rows) { // Tallest glyph above and lowest below the baseline
+      if (p->top > top)
+        top = p->top;
+      if (p->rows - p->top > below)
+        below = p->rows - p->top;
+    }
+  }
+  height = top + below;
+  pages = (height + 7) / 8;
+
+  printf("const uint8_t %sBitmaps[] PROGMEM = {\n  ", fontName);
+  for (i = 0; i < count; i++) {
+    pageGlyph *p = &table[i];
+    int shift = top - p->top; // Glyph rows start this far down the cell
+    p->offset = bitmapOffset;
+    for (j = 0; j < pages; j++) {
+      for (x = 0; x < p->width; x++) {
+        uint8_t byte = 0;
+        for (y = 0; y < 8; y++) {
+          int row = j * 8 + y - shift;
+          if ((row >= 0) && (row < p->rows) && p->pixels[row * p->width + x])
+            byte |= 1 << y;
+        }
+        enbyte(byte);
+      }
+    }
+    bitmapOffset += pages * p->width;
   }
+  printf(" };\n\n");
+
+  printf("const GFXpageGlyph %sGlyphs[] PROGMEM = {\n", fontName);
+  for (i = 0; i < count; i++) {
+    printf("  { %5d, %3d, %3d, %4d }%s // 0x%02X", table[i].offset,
+           table[i].width, table[i].advance, table[i].left,
+           (i < count - 1) ? ", " : " };", table[i].code);
+    if ((table[i].code >= ' ') && (table[i].code <= '~'))
+      printf(" '%c'", table[i].code);
+    putchar('\n');
+  }
+  putchar('\n');
+
+  printf("const uint8_t %sChars[] PROGMEM = {", fontName);
+  for (i = 0; i < count; i++)
+    printf("%s0x%02X", i ? ", " : " ", table[i].code);
+  printf(" };\n\n");
+
+  printf("const GFXpageFont %s PROGMEM = {\n", fontName);
+  printf("  (uint8_t      *)%sBitmaps,\n", fontName);
+  printf("  (GFXpageGlyph *)%sGlyphs,\n", fontName);
+  printf("  (uint8_t      *)%sChars,\n", fontName);
+  printf("  %d, %d, %d };\n\n", count, height, pages);
+  printf("// Approx. %d bytes\n", bitmapOffset + count * 6 + 9);
+
+  for (i = 0; i < count; i++)
+    free(table[i].pixels);
+  free(table);
+  return 0;
 }
 
 int main(int argc, char *argv[]) {
@@ -60,22 +168,45 @@ int main(int argc, char *argv[]) {
   FT_BitmapGlyphRec *g;
   GFXglyph *table;
   uint8_t bit;
+  int *pageCodes = NULL, pageCount = 0;
 
   // Parse command line.  Valid syntaxes are:
   //   fontconvert [filename] [size]
   //   fontconvert [filename] [size] [last char]
   //   fontconvert [filename] [size] [first char] [last char]
+  //   fontconvert [filename] [size] -p [chars] [extra char codes...]
   // Unless overridden, default first and last chars are
-  // ' ' (space) and '~', respectively
+  // ' ' (space) and '~', respectively. -p writes a page font of just the
+  // listed characters (e.g. -p "0123456789+-. " 176 for numbers with a
+  // degree sign), see pageFont().
 
   if (argc < 3) {
-    fprintf(stderr, "Usage: %s fontfile size [first] [last]\n", argv[0]);
+    fprintf(stderr,
+            "Usage: %s fontfile size [first] [last]\n"
+            "       %s fontfile size -p chars [extra char codes...]\n",
+            argv[0], argv[0]);
     return 1;
   }
 
   size = atoi(argv[2]);
 
-  if (argc == 4) {
+  if ((argc >= 5) && !strcmp(argv[3], "-p")) {
+    pageCount = strlen(argv[4]) + argc - 5;
+    if (!(pageCodes = (int *)malloc(pageCount * sizeof(int)))) {
+      fprintf(stderr, "Malloc error\n");
+      return 1;
+    }
+    for (i = 0; argv[4][i]; i++)
+      pageCodes[i] = (uint8_t)argv[4][i];
+    for (j = 5; j < argc; j++, i++) {
+      pageCodes[i] = atoi(argv[j]);
+      if ((pageCodes[i] < 1) || (pageCodes[i] > 255)) {
+        fprintf(stderr, "Page fonts hold 8 bit chars, not %s\n", argv[j]);
+        return 1;
+      }
+    }
+    last = 255; // 8 bit name
+  } else if (argc == 4) {
     last = atoi(argv[3]);
   } else if (argc == 5) {
     first = atoi(argv[3]);
@@ -109,7 +240,10 @@ int main(int argc, char *argv[]) {
     ptr = &fontName[strlen(fontName)]; // If none, append
   // Insert font size and 7/8 bit.  fontName was alloc'd w/extra
   // space to allow this, we're not sprintfing into Forbidden Zone.
-  sprintf(ptr, "%dpt%db", size, (last > 127) ? 8 : 7);
+  if (pageCodes)
+    sprintf(ptr, "%dptPages", size);
+  else
+    sprintf(ptr, "%dpt%db", size, (last > 127) ? 8 : 7);
   // Space and punctuation chars in name replaced w/ underscores.
   for (i = 0; (c = fontName[i]); i++) {
     if (isspace(c) || ispunct(c))
@@ -139,6 +273,12 @@ int main(int argc, char *argv[]) {
   // << 6 because '26dot6' fixed-point format
   FT_Set_Char_Size(face, size << 6, 0, DPI, 0);
 
+  if (pageCodes) {
+    err = pageFont(face, fontName, pageCount, pageCodes);
+    FT_Done_FreeType(library);
+    return err;
+  }
+
   // Currently all symbols from 'first' to 'last' are processed.
   // Fonts may contain WAY more glyphs than that, but this code
   // will need to handle encoding stuff to deal with extracting
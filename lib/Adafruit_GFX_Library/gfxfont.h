@@ -26,4 +26,28 @@ typedef struct {
   uint8_t yAdvance; ///< Newline distance (y axis)
 } GFXfont;
 
+// Page fonts (fontconvert -p) hold a few glyphs pre-rendered in the SSD1306
+// page layout: every glyph is the same number of 8-row pages tall and is
+// stored as pages of 'width' column bytes, LSB at the top. They are blitted
+// whole rather than drawn pixel by pixel, see Adafruit_SSD1306::drawPageText.
+
+/// Page font data stored PER GLYPH
+typedef struct {
+  uint16_t bitmapOffset; ///< Pointer into GFXpageFont->bitmap
+  uint8_t width;         ///< Columns stored, each GFXpageFont->pages bytes
+  uint8_t xAdvance;      ///< Distance to advance cursor (x axis)
+  int8_t xOffset;        ///< X dist from cursor pos to the first column
+} GFXpageGlyph;
+
+/// Data stored for PAGE FONT AS A WHOLE
+typedef struct {
+  uint8_t *bitmap;       ///< Glyph pages, concatenated
+  GFXpageGlyph *glyph;   ///< Glyph array
+  uint8_t *chars;        ///< Character of each glyph (8 bit, e.g. 0xB0 degree)
+  uint8_t count;         ///< Number of glyphs
+  uint8_t height;        ///< Rows from the top of the tallest glyph to the
+                         ///< bottom of the lowest one, all glyphs share them
+  uint8_t pages;         ///< (height + 7) / 8
+} GFXpageFont;
+
 #endif // _GFXFONT_H_
@@ -55,12 +55,15 @@
 #endif
 
 #include "Adafruit_SSD1306.h"
+#include "Adafruit_SSD1306Canvas.h"
 #include "splash.h"
 #include <Adafruit_GFX.h>
 
 // SOME DEFINES AND STATIC VARIABLES USED INTERNALLY -----------------------
 
-#if defined(I2C_BUFFER_LENGTH)
+#if defined(ARDUINO_ARCH_MBED)
+#define WIRE_MAX 256 ///< MbedI2C transmit buffer
+#elif defined(I2C_BUFFER_LENGTH)
 #define WIRE_MAX min(256, I2C_BUFFER_LENGTH) ///< Particle or similar Wire lib
 #elif defined(BUFFER_LENGTH)
 #define WIRE_MAX min(256, BUFFER_LENGTH) ///< AVR or similar Wire lib
@@ -341,7 +344,7 @@ Adafruit_SSD1306::Adafruit_SSD1306(int8_t rst_pin)
 */
 Adafruit_SSD1306::~Adafruit_SSD1306(void) {
   if (buffer) {
-    free(buffer);
+    free(buffer - 1); // allocated with the I2C control byte in front
     buffer = NULL;
   }
 }
@@ -496,8 +499,15 @@ void Adafruit_SSD1306::ssd1306_command(uint8_t c) {
 bool Adafruit_SSD1306::begin(uint8_t vcs, uint8_t addr, bool reset,
                              bool periphBegin) {
 
-  if ((!buffer) && !(buffer = (uint8_t *)malloc(WIDTH * ((HEIGHT + 7) / 8))))
-    return false;
+  if (!buffer) {
+    // One byte ahead of the frame holds the I2C data control byte, so DMA
+    // capable code can send getBuffer() - 1 as a single transfer from RAM
+    uint8_t *frame = (uint8_t *)malloc(1 + WIDTH * ((HEIGHT + 7) / 8));
+    if (!frame)
+      return false;
+    frame[0] = 0x40;
+    buffer = frame + 1;
+  }
 
   clearDisplay();
 
@@ -983,10 +993,105 @@ bool Adafruit_SSD1306::getPixel(int16_t x, int16_t y) {
 /*!
     @brief  Get base address of display buffer for direct reading or writing.
     @return Pointer to an unsigned 8-bit array, column-major, columns padded
-            to full byte boundary if needed.
+            to full byte boundary if needed. The byte before it is always
+            0x40 (I2C control byte, display data follows).
 */
 uint8_t *Adafruit_SSD1306::getBuffer(void) { return buffer; }
 
+/*!
+    @brief  Copy a page-major canvas into the display buffer, a few columns
+            per 32-bit word (see Adafruit_SSD1306Canvas::blit()).
+    @param  canvas  Source canvas, drawn in the SSD1306 page layout.
+    @param  x       Column of its left edge, unrotated (panel) coordinates.
+    @param  y       Row of its top edge, unrotated, need not be page aligned.
+    @param  op      SSD1306_BLIT_COPY, SSD1306_BLIT_OR or SSD1306_BLIT_AND.
+    @note   Changes buffer contents only, no immediate effect on display.
+*/
+void Adafruit_SSD1306::blit(const Adafruit_SSD1306Canvas &canvas, int16_t x,
+                            int16_t y, uint8_t op) {
+  if (canvas.getBuffer()) {
+    blit(canvas.getBuffer(), canvas.rawWidth(), canvas.rawHeight(), x, y, op);
+  }
+}
+
+/*!
+    @brief  Copy a page-major bitmap into the display buffer.
+    @param  pages  (h + 7) / 8 pages of w bytes, one byte per column, LSB at
+                   the top, the same layout as getBuffer().
+    @param  w      Width in pixels.
+    @param  h      Height in pixels.
+    @param  x      Column of its left edge, unrotated (panel) coordinates.
+    @param  y      Row of its top edge, unrotated, need not be page aligned.
+    @param  op     SSD1306_BLIT_COPY, SSD1306_BLIT_OR or SSD1306_BLIT_AND.
+    @note   Changes buffer contents only, no immediate effect on display.
+*/
+void Adafruit_SSD1306::blit(const uint8_t *pages, int16_t w, int16_t h,
+                            int16_t x, int16_t y, uint8_t op) {
+  if (buffer) {
+    Adafruit_SSD1306Canvas::blit(buffer, WIDTH, HEIGHT, pages, w, h, x, y, op);
+  }
+}
+
+// Glyph index of character c in a page font, -1 if it has none
+static int16_t pageGlyph(const GFXpageFont *font, char c) {
+  for (uint8_t i = 0; i < font->count; i++) {
+    if (font->chars[i] == (uint8_t)c)
+      return i;
+  }
+  return -1;
+}
+
+/*!
+    @brief  Draw a string in a page font (see gfxfont.h and fontconvert -p),
+            every glyph ORed into the display buffer with one blit() rather
+            than pixel by pixel. Characters the font lacks are skipped.
+    @param  x     Column of the text's left edge (cursor position), unrotated
+                  (panel) coordinates.
+    @param  y     Row of the top of the font's cell, need not be page aligned.
+    @param  font  Page font. Its tables are read directly, so on AVR they
+                  must be in RAM rather than PROGMEM.
+    @param  text  Null-terminated string, 8-bit characters (e.g. "\xB0" for
+                  a degree sign in fonts that include it).
+    @return Column just past the last glyph's advance.
+    @note   Changes buffer contents only, no immediate effect on display.
+*/
+int16_t Adafruit_SSD1306::drawPageText(int16_t x, int16_t y,
+                                       const GFXpageFont *font,
+                                       const char *text) {
+  for (; *text; text++) {
+    int16_t i = pageGlyph(font, *text);
+    if (i < 0)
+      continue;
+    const GFXpageGlyph *glyph = &font->glyph[i];
+    if (buffer) {
+      Adafruit_SSD1306Canvas::blit(buffer, WIDTH, HEIGHT,
+                                   &font->bitmap[glyph->bitmapOffset],
+                                   glyph->width, font->height,
+                                   x + glyph->xOffset, y, SSD1306_BLIT_OR);
+    }
+    x += glyph->xAdvance;
+  }
+  return x;
+}
+
+/*!
+    @brief  Width of a string in a page font, the sum of its advances, e.g.
+            to right justify it with drawPageText().
+    @param  font  Page font.
+    @param  text  Null-terminated string.
+    @return Width in pixels.
+*/
+int16_t Adafruit_SSD1306::pageTextWidth(const GFXpageFont *font,
+                                        const char *text) {
+  int16_t w = 0;
+  for (; *text; text++) {
+    int16_t i = pageGlyph(font, *text);
+    if (i >= 0)
+      w += font->glyph[i].xAdvance;
+  }
+  return w;
+}
+
 // REFRESH DISPLAY ---------------------------------------------------------
 
 /*!
@@ -1050,6 +1155,132 @@ void Adafruit_SSD1306::display(void) {
 #endif
 }
 
+/*!
+    @brief  Write an image straight to the display RAM, without going
+            through the framebuffer (which is left as it was, and replaces
+            the image on the next display()).
+    @param  x      Leftmost column, 0 to (screen width - 1).
+    @param  page   Top page (8 rows), 0 to (screen height / 8 - 1).
+    @param  pages  (h + 7) / 8 pages of w bytes, one byte per column, LSB at
+                   the top (scripts/make_splash.py --pages). PROGMEM.
+    @param  w      Width in pixels.
+    @param  h      Height in pixels, rounded up to whole pages.
+    @return true on success, false if the image doesn't fit the display.
+*/
+bool Adafruit_SSD1306::streamImage(uint8_t x, uint8_t page,
+                                   const uint8_t *pages, uint8_t w,
+                                   uint8_t h) {
+  return streamPages(x, page, w, h, pages, 0);
+}
+
+/*!
+    @brief  Write a run-length encoded image straight to the display RAM,
+            decoding it as it goes out; see streamImage().
+    @param  x     Leftmost column, 0 to (screen width - 1).
+    @param  page  Top page (8 rows), 0 to (screen height / 8 - 1).
+    @param  rle   The image in page order, encoded in blocks of 1-128 bytes
+                  (scripts/make_splash.py --rle): a byte 0x00-0x7F is
+                  followed by n+1 literal bytes, 0x80-0xFF by one byte sent
+                  (n & 0x7F)+1 times. PROGMEM.
+    @param  size  Size of the encoded data in bytes.
+    @param  w     Width in pixels.
+    @param  h     Height in pixels, rounded up to whole pages.
+    @return true on success, false if the image doesn't fit the display or
+            the data ends before the image does (the rest is not written).
+*/
+bool Adafruit_SSD1306::streamImageRLE(uint8_t x, uint8_t page,
+                                      const uint8_t *rle, uint16_t size,
+                                      uint8_t w, uint8_t h) {
+  return size ? streamPages(x, page, w, h, rle, size) : false;
+}
+
+/*!
+    @brief  Set the display RAM window and send page-ordered data into it,
+            in I2C transfers of up to WIRE_MAX bytes. Protected, used by
+            streamImage() and streamImageRLE().
+    @param  x         Leftmost column.
+    @param  page      Top page.
+    @param  w         Width in pixels.
+    @param  h         Height in pixels.
+    @param  data      Image data, PROGMEM.
+    @param  rle_size  Size of the run-length encoded data, 0 if raw.
+    @return true if the whole window was written.
+*/
+bool Adafruit_SSD1306::streamPages(uint8_t x, uint8_t page, uint8_t w,
+                                   uint8_t h, const uint8_t *data,
+                                   uint16_t rle_size) {
+  uint8_t page_count = (h + 7) / 8;
+  if (!w || !page_count || (x + w > WIDTH) ||
+      (page + page_count > (HEIGHT + 7) / 8))
+    return false;
+
+  uint8_t column = (WIDTH == 64) ? 0x20 + x : x;
+  const uint8_t window[] = {SSD1306_PAGEADDR,
+                            page,
+                            (uint8_t)(page + page_count - 1),
+                            SSD1306_COLUMNADDR,
+                            column,
+                            (uint8_t)(column + w - 1)};
+  TRANSACTION_START
+  if (wire) { // I2C, the whole window in one transfer
+    wire->beginTransmission(i2caddr);
+    WIRE_WRITE((uint8_t)0x00); // Co = 0, D/C = 0
+    WIRE_WRITE(window, sizeof(window));
+    wire->endTransmission();
+  } else {
+    for (uint8_t i = 0; i < sizeof(window); i++)
+      ssd1306_command1(window[i]);
+  }
+
+  uint8_t chunk[WIRE_MAX - 1]; // display data after the control byte
+  uint16_t left = w * page_count;
+  uint16_t in = 0;     // next data byte
+  uint8_t run = 0;     // RLE: bytes left in the current block
+  bool repeat = false; // RLE: the block is one byte repeated
+  bool ok = true;
+  while (left && ok) {
+    uint16_t count = 0;
+    while (count < sizeof(chunk) && left) {
+      if (rle_size) {
+        if (!run) {
+          if (in + 1 >= rle_size) { // a block needs at least one more byte
+            ok = false;
+            break;
+          }
+          uint8_t c = pgm_read_byte(&data[in++]);
+          repeat = c & 0x80;
+          run = (c & 0x7F) + 1;
+        }
+        if (in >= rle_size) {
+          ok = false;
+          break;
+        }
+        chunk[count++] = pgm_read_byte(&data[in]);
+        if (!repeat || run == 1)
+          in++;
+        run--;
+      } else {
+        chunk[count++] = pgm_read_byte(&data[in++]);
+      }
+      left--;
+    }
+    if (!count)
+      break;
+    if (wire) { // I2C
+      wire->beginTransmission(i2caddr);
+      WIRE_WRITE((uint8_t)0x40);
+      WIRE_WRITE(chunk, count);
+      wire->endTransmission();
+    } else { // SPI
+      SSD1306_MODE_DATA
+      for (uint16_t i = 0; i < count; i++)
+        SPIwrite(chunk[i]);
+    }
+  }
+  TRANSACTION_END
+  return ok;
+}
+
 // SCROLLING FUNCTIONS -----------------------------------------------------
 
 /*!
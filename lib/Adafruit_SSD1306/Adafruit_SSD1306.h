@@ -74,6 +74,10 @@ typedef uint32_t PortMask;
 #define SSD1306_WHITE 1   ///< Draw 'on' pixels
 #define SSD1306_INVERSE 2 ///< Invert pixels
 
+#define SSD1306_BLIT_COPY 0 ///< blit(): replace the covered pixels
+#define SSD1306_BLIT_OR 1   ///< blit(): set the source's set pixels
+#define SSD1306_BLIT_AND 2  ///< blit(): clear the source's clear pixels
+
 #define SSD1306_MEMORYMODE 0x20          ///< See datasheet
 #define SSD1306_COLUMNADDR 0x21          ///< See datasheet
 #define SSD1306_PAGEADDR 0x22            ///< See datasheet
@@ -124,6 +128,8 @@ typedef uint32_t PortMask;
 #define SSD1306_LCDHEIGHT 16 ///< DEPRECATED: height w/SSD1306_96_16 defined
 #endif
 
+class Adafruit_SSD1306Canvas;
+
 /*!
     @brief  Class that stores state and functions for interacting with
             SSD1306 OLED displays.
@@ -164,6 +170,17 @@ public:
   void ssd1306_command(uint8_t c);
   bool getPixel(int16_t x, int16_t y);
   uint8_t *getBuffer(void);
+  void blit(const Adafruit_SSD1306Canvas &canvas, int16_t x, int16_t y,
+            uint8_t op = SSD1306_BLIT_COPY);
+  void blit(const uint8_t *pages, int16_t w, int16_t h, int16_t x, int16_t y,
+            uint8_t op = SSD1306_BLIT_COPY);
+  int16_t drawPageText(int16_t x, int16_t y, const GFXpageFont *font,
+                       const char *text);
+  static int16_t pageTextWidth(const GFXpageFont *font, const char *text);
+  bool streamImage(uint8_t x, uint8_t page, const uint8_t *pages, uint8_t w,
+                   uint8_t h);
+  bool streamImageRLE(uint8_t x, uint8_t page, const uint8_t *rle,
+                      uint16_t size, uint8_t w, uint8_t h);
 
 protected:
   inline void SPIwrite(uint8_t d) __attribute__((always_inline));
@@ -171,6 +188,8 @@ protected:
   void drawFastVLineInternal(int16_t x, int16_t y, int16_t h, uint16_t color);
   void ssd1306_command1(uint8_t c);
   void ssd1306_commandList(const uint8_t *c, uint8_t n);
+  bool streamPages(uint8_t x, uint8_t page, uint8_t w, uint8_t h,
+                   const uint8_t *data, uint16_t rle_size);
 
   SPIClass *spi;   ///< Initialized during construction when using SPI. See
                    ///< SPI.cpp, SPI.h
@@ -0,0 +1,347 @@
+/*!
+ * @file Adafruit_SSD1306Canvas.cpp
+ *
+ * Page-major 1-bit canvas and the word-wise blit shared with
+ * Adafruit_SSD1306::blit().
+ *
+ * BSD license, all text above must be included in any redistribution.
+ */
+
+#include "Adafruit_SSD1306Canvas.h"
+
+/*!
+   @brief    Instantiate a canvas in the SSD1306 page layout
+   @param    w   Width, in pixels
+   @param    h   Height, in pixels, rounded up to whole pages in memory
+   @param    allocate_buffer If true, a buffer is allocated with malloc. If
+   false, the subclass must initialize the buffer before any drawing operation,
+   and free it in the destructor.
+*/
+Adafruit_SSD1306Canvas::Adafruit_SSD1306Canvas(uint16_t w, uint16_t h,
+                                               bool allocate_buffer)
+    : Adafruit_GFX(w, h), buffer_owned(allocate_buffer) {
+  if (allocate_buffer) {
+    uint32_t bytes = w * ((h + 7) / 8);
+    if ((buffer = (uint8_t *)malloc(bytes))) {
+      memset(buffer, 0, bytes);
+    }
+  } else {
+    buffer = nullptr;
+  }
+}
+
+/*!
+   @brief    Delete the canvas, free memory
+*/
+Adafruit_SSD1306Canvas::~Adafruit_SSD1306Canvas(void) {
+  if (buffer && buffer_owned)
+    free(buffer);
+}
+
+/*!
+    @brief  Draw a pixel to the canvas framebuffer
+    @param  x      x coordinate
+    @param  y      y coordinate
+    @param  color  SSD1306_WHITE, SSD1306_BLACK or SSD1306_INVERSE
+*/
+void Adafruit_SSD1306Canvas::drawPixel(int16_t x, int16_t y, uint16_t color) {
+  fillRect(x, y, 1, 1, color);
+}
+
+/*!
+    @brief  Fill the canvas
+    @param  color  SSD1306_WHITE or SSD1306_BLACK (SSD1306_INVERSE inverts)
+*/
+void Adafruit_SSD1306Canvas::fillScreen(uint16_t color) {
+  if (buffer) {
+    fillRawRect(0, 0, WIDTH, HEIGHT, color);
+  }
+}
+
+/*!
+    @brief  Draw a vertical line
+    @param  x      Column
+    @param  y      Topmost row
+    @param  h      Height in pixels, negative draws upwards
+    @param  color  SSD1306_WHITE, SSD1306_BLACK or SSD1306_INVERSE
+*/
+void Adafruit_SSD1306Canvas::drawFastVLine(int16_t x, int16_t y, int16_t h,
+                                           uint16_t color) {
+  fillRect(x, y, 1, h, color);
+}
+
+/*!
+    @brief  Draw a horizontal line
+    @param  x      Leftmost column
+    @param  y      Row
+    @param  w      Width in pixels, negative draws to the left
+    @param  color  SSD1306_WHITE, SSD1306_BLACK or SSD1306_INVERSE
+*/
+void Adafruit_SSD1306Canvas::drawFastHLine(int16_t x, int16_t y, int16_t w,
+                                           uint16_t color) {
+  fillRect(x, y, w, 1, color);
+}
+
+/*!
+    @brief  Fill a rectangle, clipped to the canvas
+    @param  x      Leftmost column
+    @param  y      Topmost row
+    @param  w      Width in pixels, negative extends to the left
+    @param  h      Height in pixels, negative extends upwards
+    @param  color  SSD1306_WHITE, SSD1306_BLACK or SSD1306_INVERSE
+*/
+void Adafruit_SSD1306Canvas::fillRect(int16_t x, int16_t y, int16_t w,
+                                      int16_t h, uint16_t color) {
+  if (!buffer)
+    return;
+  if (w < 0) {
+    x += w + 1;
+    w = -w;
+  }
+  if (h < 0) {
+    y += h + 1;
+    h = -h;
+  }
+  if (x < 0) {
+    w += x;
+    x = 0;
+  }
+  if (y < 0) {
+    h += y;
+    y = 0;
+  }
+  if (x + w > _width)
+    w = _width - x;
+  if (y + h > _height)
+    h = _height - y;
+  if (w <= 0 || h <= 0)
+    return;
+
+  switch (rotation) {
+  case 1:
+    fillRawRect(WIDTH - y - h, x, h, w, color);
+    break;
+  case 2:
+    fillRawRect(WIDTH - x - w, HEIGHT - y - h, w, h, color);
+    break;
+  case 3:
+    fillRawRect(y, HEIGHT - x - w, h, w, color);
+    break;
+  default:
+    fillRawRect(x, y, w, h, color);
+    break;
+  }
+}
+
+/*!
+    @brief  Get the pixel color value at a given coordinate
+    @param  x  x coordinate
+    @param  y  y coordinate
+    @returns True if the pixel is set, false if clear or out of bounds
+*/
+bool Adafruit_SSD1306Canvas::getPixel(int16_t x, int16_t y) const {
+  if (!buffer || (x < 0) || (y < 0) || (x >= _width) || (y >= _height))
+    return false;
+  int16_t t;
+  switch (rotation) {
+  case 1:
+    t = x;
+    x = WIDTH - 1 - y;
+    y = t;
+    break;
+  case 2:
+    x = WIDTH - 1 - x;
+    y = HEIGHT - 1 - y;
+    break;
+  case 3:
+    t = x;
+    x = y;
+    y = HEIGHT - 1 - t;
+    break;
+  }
+  return buffer[x + (y / 8) * WIDTH] & (1 << (y & 7));
+}
+
+/*!
+    @brief  Copy another canvas into this one, see the static blit()
+    @param  canvas  Source canvas
+    @param  x       Column of its left edge, unrotated
+    @param  y       Row of its top edge, unrotated, any value
+    @param  op      SSD1306_BLIT_COPY, SSD1306_BLIT_OR or SSD1306_BLIT_AND
+*/
+void Adafruit_SSD1306Canvas::blit(const Adafruit_SSD1306Canvas &canvas,
+                                  int16_t x, int16_t y, uint8_t op) {
+  if (buffer && canvas.buffer) {
+    blit(buffer, WIDTH, HEIGHT, canvas.buffer, canvas.WIDTH, canvas.HEIGHT, x,
+         y, op);
+  }
+}
+
+/*!
+    @brief  Scroll the whole canvas sideways by whole columns, e.g. to append
+            to a chart. A column is one byte per page, so this is a memmove()
+            per page. The vacated columns are cleared.
+    @param  n  Columns, unrotated: positive moves the contents left (towards
+               column 0), negative right
+*/
+void Adafruit_SSD1306Canvas::shiftColumns(int16_t n) {
+  if (!buffer || !n)
+    return;
+  int16_t keep = WIDTH - abs(n);
+  if (keep < 0)
+    keep = 0;
+  for (uint8_t *row = buffer; row < buffer + WIDTH * ((HEIGHT + 7) / 8);
+       row += WIDTH) {
+    if (n > 0) {
+      memmove(row, row + WIDTH - keep, keep);
+      memset(row + keep, 0, WIDTH - keep);
+    } else {
+      memmove(row + WIDTH - keep, row, keep);
+      memset(row, 0, WIDTH - keep);
+    }
+  }
+}
+
+/*!
+    @brief  Fill a rectangle in unrotated coordinates, already clipped, one
+            page at a time with the same mask for every column
+*/
+void Adafruit_SSD1306Canvas::fillRawRect(int16_t x, int16_t y, int16_t w,
+                                         int16_t h, uint16_t color) {
+  uint8_t *row = &buffer[x + (y / 8) * WIDTH];
+  int16_t end = y + h;
+  while (y < end) {
+    uint8_t mask = 0xFF << (y & 7);
+    int16_t next = (y | 7) + 1;
+    if (next > end) {
+      mask &= 0xFF >> (next - end);
+      next = end;
+    }
+    uint8_t *p = row;
+    uint8_t *stop = row + w;
+    switch (color) {
+    case SSD1306_WHITE:
+      while (p < stop)
+        *p++ |= mask;
+      break;
+    case SSD1306_BLACK:
+      while (p < stop)
+        *p++ &= ~mask;
+      break;
+    case SSD1306_INVERSE:
+      while (p < stop)
+        *p++ ^= mask;
+      break;
+    }
+    row += WIDTH;
+    y = next;
+  }
+}
+
+// Up to 4 page bytes (columns) at a time, one per byte lane of a word. The
+// lanes never interact, so byte order doesn't matter, and memcpy() of a
+// constant 4 compiles to a single (unaligned capable) load or store once
+// inlined, also at -Os.
+static inline uint32_t loadLanes(const uint8_t *p, uint8_t n)
+    __attribute__((always_inline));
+static inline void blitLanes(uint8_t *dst, const uint8_t *lo,
+                             const uint8_t *hi, uint8_t n, uint8_t shift,
+                             uint32_t mask, uint8_t op)
+    __attribute__((always_inline));
+
+static inline uint32_t loadLanes(const uint8_t *p, uint8_t n) {
+  uint32_t v = 0;
+  if (p)
+    memcpy(&v, p, n);
+  return v;
+}
+
+static inline void blitLanes(uint8_t *dst, const uint8_t *lo,
+                             const uint8_t *hi, uint8_t n, uint8_t shift,
+                             uint32_t mask, uint8_t op) {
+  // rows of the destination page: the top from the source page 'lo' shifted
+  // down, the rest from the next source page 'hi' shifted up. Each shift
+  // spills into the neighbouring lane, the lane masks drop that.
+  uint32_t v = loadLanes(lo, n);
+  if (shift) {
+    v = ((v >> shift) & (0x01010101UL * (0xFF >> shift))) |
+        ((loadLanes(hi, n) << (8 - shift)) &
+         (0x01010101UL * (uint8_t)(0xFF << (8 - shift))));
+  }
+  uint32_t d = 0;
+  memcpy(&d, dst, n);
+  switch (op) {
+  case SSD1306_BLIT_OR:
+    d |= v & mask;
+    break;
+  case SSD1306_BLIT_AND:
+    d &= v | ~mask;
+    break;
+  default:
+    d = (d & ~mask) | (v & mask);
+    break;
+  }
+  memcpy(dst, &d, n);
+}
+
+/*!
+    @brief  Combine a page-major bitmap into a page-major framebuffer. Both
+            are pages of 8 rows, one byte per column, LSB at the top. The
+            source lands at any y: each destination page is built from two
+            source pages shifted and merged, 4 columns per 32-bit word.
+    @param  dst    Destination buffer (framebuffer or canvas)
+    @param  dst_w  Destination width, bytes per page
+    @param  dst_h  Destination height in rows
+    @param  src    Source bitmap
+    @param  src_w  Source width, bytes per page
+    @param  src_h  Source height in rows, rows past it in its last page are
+                   ignored
+    @param  x      Destination column of the source's left edge
+    @param  y      Destination row of the source's top edge
+    @param  op     SSD1306_BLIT_COPY replaces the covered pixels,
+                   SSD1306_BLIT_OR sets the source's set pixels,
+                   SSD1306_BLIT_AND clears the source's clear pixels
+*/
+void Adafruit_SSD1306Canvas::blit(uint8_t *dst, int16_t dst_w, int16_t dst_h,
+                                  const uint8_t *src, int16_t src_w,
+                                  int16_t src_h, int16_t x, int16_t y,
+                                  uint8_t op) {
+  int16_t sx = 0, w = src_w;
+  if (x < 0) {
+    sx = -x;
+    w += x;
+    x = 0;
+  }
+  if (x + w > dst_w)
+    w = dst_w - x;
+  int16_t top = max(y, (int16_t)0);
+  int16_t bottom = min((int16_t)(y + src_h), dst_h);
+  if (w <= 0 || top >= bottom)
+    return;
+  int16_t src_pages = (src_h + 7) / 8;
+
+  for (int16_t page = top / 8; page <= (bottom - 1) / 8; page++) {
+    int16_t first = max(top, (int16_t)(page * 8));
+    int16_t last = min(bottom, (int16_t)(page * 8 + 8));
+    uint8_t rows = (0xFF << (first & 7)) & (0xFF >> (page * 8 + 8 - last));
+    uint32_t mask = 0x01010101UL * rows;
+    // source row on this page's top row, -7 at the lowest
+    int16_t row = page * 8 - y;
+    int16_t sp = (row + 8) / 8 - 1;
+    uint8_t shift = (row + 8) % 8;
+    const uint8_t *lo = sp >= 0 ? &src[sp * src_w + sx] : NULL;
+    const uint8_t *hi =
+        (shift && sp + 1 < src_pages) ? &src[(sp + 1) * src_w + sx] : NULL;
+    uint8_t *d = &dst[page * dst_w + x];
+
+    int16_t i = 0;
+    for (; i + 4 <= w; i += 4) {
+      blitLanes(d + i, lo ? lo + i : NULL, hi ? hi + i : NULL, 4, shift, mask,
+                op);
+    }
+    if (i < w) {
+      blitLanes(d + i, lo ? lo + i : NULL, hi ? hi + i : NULL, w - i, shift,
+                mask, op);
+    }
+  }
+}
@@ -0,0 +1,64 @@
+/*!
+ * @file Adafruit_SSD1306Canvas.h
+ *
+ * Off-screen 1-bit canvas in the SSD1306 framebuffer layout: pages of 8 rows,
+ * one byte per column per page, LSB at the top. Anything drawn here can be
+ * copied into an Adafruit_SSD1306 framebuffer (or another canvas) with
+ * blit(), a few columns per 32-bit word at any y offset, instead of going
+ * through drawBitmap() one pixel at a time. Widgets that don't change can be
+ * drawn once and blitted every frame.
+ *
+ * BSD license, all text above must be included in any redistribution.
+ */
+
+#ifndef _Adafruit_SSD1306Canvas_H_
+#define _Adafruit_SSD1306Canvas_H_
+
+#include <Adafruit_SSD1306.h>
+
+/*!
+    @brief  A GFX 1-bit canvas in the SSD1306 page layout.
+*/
+class Adafruit_SSD1306Canvas : public Adafruit_GFX {
+public:
+  Adafruit_SSD1306Canvas(uint16_t w, uint16_t h, bool allocate_buffer = true);
+  ~Adafruit_SSD1306Canvas(void);
+  void drawPixel(int16_t x, int16_t y, uint16_t color);
+  void fillScreen(uint16_t color);
+  void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
+  void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+  bool getPixel(int16_t x, int16_t y) const;
+  void blit(const Adafruit_SSD1306Canvas &canvas, int16_t x, int16_t y,
+            uint8_t op = SSD1306_BLIT_COPY);
+  void shiftColumns(int16_t n);
+
+  static void blit(uint8_t *dst, int16_t dst_w, int16_t dst_h,
+                   const uint8_t *src, int16_t src_w, int16_t src_h, int16_t x,
+                   int16_t y, uint8_t op);
+
+  /*!
+    @brief    Get a pointer to the internal buffer memory
+    @returns  A pointer to the allocated buffer, rawHeight() / 8 (rounded
+              up) pages of rawWidth() bytes
+  */
+  uint8_t *getBuffer(void) const { return buffer; }
+  /*!
+    @brief    Unrotated width, the number of bytes in a page
+    @returns  Width in pixels
+  */
+  int16_t rawWidth(void) const { return WIDTH; }
+  /*!
+    @brief    Unrotated height
+    @returns  Height in pixels
+  */
+  int16_t rawHeight(void) const { return HEIGHT; }
+
+protected:
+  void fillRawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+  uint8_t *buffer;   ///< Page-major raster data
+  bool buffer_owned; ///< If true, destructor will free buffer, else it will do
+                     ///< nothing
+};
+
+#endif // _Adafruit_SSD1306Canvas_H_
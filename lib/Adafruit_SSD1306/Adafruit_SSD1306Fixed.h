@@ -0,0 +1,284 @@
+/*!
+ * @file Adafruit_SSD1306Fixed.h
+ *
+ * Fixed geometry variant of Adafruit_SSD1306. Width, height and rotation are
+ * template parameters, so the framebuffer is allocated statically (no malloc()
+ * in begin()) and the pixel, line, rectangle and clear paths compile down to
+ * constant shifts and masks instead of testing the geometry and rotation per
+ * pixel.
+ * Everything else (begin(), display(), scrolling...) is the regular driver.
+ *
+ * BSD license, all text above must be included in any redistribution.
+ */
+
+#ifndef _Adafruit_SSD1306Fixed_H_
+#define _Adafruit_SSD1306Fixed_H_
+
+#include <Adafruit_SSD1306.h>
+
+/*!
+    @brief  SSD1306 driver for one display geometry, known at compile time.
+    @tparam W         Panel width in pixels (up to 128)
+    @tparam H         Panel height in pixels, a multiple of 8 (up to 64)
+    @tparam ROTATION  GFX rotation 0-3, setRotation() has no effect
+*/
+template <uint8_t W, uint8_t H, uint8_t ROTATION = 0>
+class Adafruit_SSD1306Fixed : public Adafruit_SSD1306 {
+  static_assert(W > 0 && W <= 128, "SSD1306 width is 1 to 128 pixels");
+  static_assert(H > 0 && H <= 64 && (H % 8) == 0,
+                "SSD1306 height is 8 to 64 pixels, whole pages");
+  static_assert(ROTATION < 4, "rotation is 0 to 3");
+
+public:
+  static const uint16_t BUFFER_SIZE = W * (H / 8); ///< Framebuffer bytes
+  static const int16_t LOGICAL_WIDTH = (ROTATION & 1) ? H : W;  ///< width()
+  static const int16_t LOGICAL_HEIGHT = (ROTATION & 1) ? W : H; ///< height()
+
+  /*!
+      @brief  Constructor for I2C-interfaced SSD1306 displays.
+      @param  twi        Pointer to an existing TwoWire instance.
+      @param  rst_pin    Reset pin, or -1 if not used.
+      @param  clkDuring  Speed (in Hz) for Wire transmissions in SSD1306
+                         library calls.
+      @param  clkAfter   Speed (in Hz) for Wire transmissions following
+                         SSD1306 library calls.
+  */
+  Adafruit_SSD1306Fixed(TwoWire *twi = &Wire, int8_t rst_pin = -1,
+                        uint32_t clkDuring = 400000UL,
+                        uint32_t clkAfter = 100000UL)
+      : Adafruit_SSD1306(W, H, twi, rst_pin, clkDuring, clkAfter) {
+    frame[0] = 0x40; // same layout as the allocated buffer, control byte first
+    buffer = &frame[1];
+    Adafruit_GFX::setRotation(ROTATION);
+  }
+
+  /*!
+      @brief  Destructor, the framebuffer is static so the base class must
+              not free it.
+  */
+  ~Adafruit_SSD1306Fixed(void) { buffer = NULL; }
+
+  /*!
+      @brief  Rotation is a template parameter, this keeps it.
+      @param  r  Ignored.
+  */
+  void setRotation(uint8_t r) override { (void)r; }
+
+  /*!
+      @brief  Set/clear/invert a single pixel.
+      @param  x      Column, 0 at left, in the rotated coordinate system.
+      @param  y      Row, 0 at top.
+      @param  color  SSD1306_WHITE, SSD1306_BLACK or SSD1306_INVERSE.
+  */
+  void drawPixel(int16_t x, int16_t y, uint16_t color) override {
+    if ((uint16_t)x >= LOGICAL_WIDTH || (uint16_t)y >= LOGICAL_HEIGHT) {
+      return;
+    }
+    int16_t bx, by;
+    toPanel(x, y, &bx, &by);
+    apply(buffer[bx + (by >> 3) * W], 1 << (by & 7), color);
+  }
+
+  /*!
+      @brief  Draw a horizontal line, clipped to the display.
+      @param  x      Leftmost column.
+      @param  y      Row.
+      @param  w      Width in pixels, negative draws to the left.
+      @param  color  SSD1306_WHITE, SSD1306_BLACK or SSD1306_INVERSE.
+  */
+  void drawFastHLine(int16_t x, int16_t y, int16_t w,
+                     uint16_t color) override {
+    fill(x, y, w, 1, color);
+  }
+
+  /*!
+      @brief  Draw a vertical line, clipped to the display.
+      @param  x      Column.
+      @param  y      Topmost row.
+      @param  h      Height in pixels, negative draws upwards.
+      @param  color  SSD1306_WHITE, SSD1306_BLACK or SSD1306_INVERSE.
+  */
+  void drawFastVLine(int16_t x, int16_t y, int16_t h,
+                     uint16_t color) override {
+    fill(x, y, 1, h, color);
+  }
+
+  /*!
+      @brief  Fill a rectangle, clipped to the display. GFX also draws
+              scaled text (setTextSize() > 1) with this.
+      @param  x      Leftmost column.
+      @param  y      Topmost row.
+      @param  w      Width in pixels, negative extends to the left.
+      @param  h      Height in pixels, negative extends upwards.
+      @param  color  SSD1306_WHITE, SSD1306_BLACK or SSD1306_INVERSE.
+  */
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h,
+                uint16_t color) override {
+    fill(x, y, w, h, color);
+  }
+
+  /*!
+      @brief  Fill the whole framebuffer with a color.
+      @param  color  SSD1306_WHITE or SSD1306_BLACK (SSD1306_INVERSE inverts).
+  */
+  void fillScreen(uint16_t color) override {
+    if (color == SSD1306_INVERSE) {
+      for (uint16_t i = 0; i < BUFFER_SIZE; i++) {
+        buffer[i] ^= 0xFF;
+      }
+    } else {
+      memset(buffer, color ? 0xFF : 0x00, BUFFER_SIZE);
+    }
+  }
+
+  /*!
+      @brief  Clear the framebuffer (all pixels off).
+  */
+  void clearDisplay(void) { memset(buffer, 0, BUFFER_SIZE); }
+
+  /*!
+      @brief  Return the color of a single pixel in the framebuffer.
+      @param  x  Column, in the rotated coordinate system.
+      @param  y  Row.
+      @return true if the pixel is set, false if clear or out of bounds.
+  */
+  bool getPixel(int16_t x, int16_t y) {
+    if ((uint16_t)x >= LOGICAL_WIDTH || (uint16_t)y >= LOGICAL_HEIGHT) {
+      return false;
+    }
+    int16_t bx, by;
+    toPanel(x, y, &bx, &by);
+    return buffer[bx + (by >> 3) * W] & (1 << (by & 7));
+  }
+
+protected:
+  uint8_t frame[1 + BUFFER_SIZE]; ///< I2C control byte + framebuffer
+
+  /*!
+      @brief  fillRect() and the lines, without the virtual call.
+  */
+  inline void fill(int16_t x, int16_t y, int16_t w, int16_t h,
+                   uint16_t color) {
+    if (w < 0) {
+      x += w + 1;
+      w = -w;
+    }
+    if (h < 0) {
+      y += h + 1;
+      h = -h;
+    }
+    if (!clip(&x, &w, LOGICAL_WIDTH) || !clip(&y, &h, LOGICAL_HEIGHT)) {
+      return;
+    }
+    switch (ROTATION) {
+    case 0:
+      panelFill(x, y, w, h, color);
+      break;
+    case 1:
+      panelFill(W - y - h, x, h, w, color);
+      break;
+    case 2:
+      panelFill(W - x - w, H - y - h, w, h, color);
+      break;
+    case 3:
+      panelFill(y, H - x - w, h, w, color);
+      break;
+    }
+  }
+
+  /*!
+      @brief  Map rotated coordinates to panel (framebuffer) coordinates.
+  */
+  static inline void toPanel(int16_t x, int16_t y, int16_t *bx, int16_t *by) {
+    switch (ROTATION) {
+    case 0:
+      *bx = x;
+      *by = y;
+      break;
+    case 1:
+      *bx = W - 1 - y;
+      *by = x;
+      break;
+    case 2:
+      *bx = W - 1 - x;
+      *by = H - 1 - y;
+      break;
+    case 3:
+      *bx = y;
+      *by = H - 1 - x;
+      break;
+    }
+  }
+
+  /*!
+      @brief  Clip a run [*start, *start + *length) to [0, limit).
+      @return false if nothing is left.
+  */
+  static inline bool clip(int16_t *start, int16_t *length, int16_t limit) {
+    if (*start < 0) {
+      *length += *start;
+      *start = 0;
+    }
+    if (*start + *length > limit) {
+      *length = limit - *start;
+    }
+    return *length > 0;
+  }
+
+  /*!
+      @brief  Apply a color to the masked bits of one framebuffer byte.
+  */
+  static inline void apply(uint8_t &byte, uint8_t mask, uint16_t color) {
+    switch (color) {
+    case SSD1306_WHITE:
+      byte |= mask;
+      break;
+    case SSD1306_BLACK:
+      byte &= ~mask;
+      break;
+    case SSD1306_INVERSE:
+      byte ^= mask;
+      break;
+    }
+  }
+
+  /*!
+      @brief  Fill a rectangle in panel coordinates, one page (8 rows) at a
+              time with the same mask for every column.
+  */
+  void panelFill(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    uint8_t *row = &buffer[x + (y >> 3) * W];
+    int16_t end = y + h;
+    while (y < end) {
+      uint8_t mask = 0xFF << (y & 7);
+      int16_t next = (y | 7) + 1;
+      if (next > end) {
+        mask &= 0xFF >> (next - end);
+        next = end;
+      }
+      uint8_t *p = row;
+      uint8_t *stop = row + w;
+      switch (color) {
+      case SSD1306_WHITE:
+        while (p < stop) {
+          *p++ |= mask;
+        }
+        break;
+      case SSD1306_BLACK:
+        while (p < stop) {
+          *p++ &= ~mask;
+        }
+        break;
+      case SSD1306_INVERSE:
+        while (p < stop) {
+          *p++ ^= mask;
+        }
+        break;
+      }
+      row += W;
+      y = next;
+    }
+  }
+};
+
+#endif // _Adafruit_SSD1306Fixed_H_
@@ -4,14 +4,77 @@
 import sys
 from PIL import Image
 
-def main(fn, id):
+def pages(image):
+  # SSD1306 GDDRAM order: pages of 8 rows, one byte per column, LSB at the top
+  data = []
+  for page in range(0, (image.height + 7)//8):
+    for x in range(0, image.width):
+      byte = 0
+      for bit in range(0, 8):
+        y = page * 8 + bit
+        if y < image.height and image.getpixel((x,y)) != 0:
+          byte |= 1 << bit
+      data.append(byte)
+  return data
+
+def rle(data):
+  # Blocks of 1-128 bytes, as decoded by Adafruit_SSD1306::streamImageRLE():
+  #   0x00-0x7F  n+1 literal bytes follow
+  #   0x80-0xFF  the next byte is repeated (n & 0x7F)+1 times
+  out = []
+  literal = []
+  def flush():
+    if literal:
+      out.append(len(literal) - 1)
+      out.extend(literal)
+      del literal[:]
+  i = 0
+  while i < len(data):
+    run = 1
+    while i + run < len(data) and run < 128 and data[i + run] == data[i]:
+      run += 1
+    if run >= 3:
+      flush()
+      out.extend([0x80 | (run - 1), data[i]])
+      i += run
+    else:
+      literal.append(data[i])
+      if len(literal) == 128:
+        flush()
+      i += 1
+  flush()
+  return out
+
+def print_bytes(data):
+  for i in range(0, len(data), 16):
+    print("  " + "".join("0x{:02x},".format(b) for b in data[i:i+16]))
+
+def main(fn, id, paged=False, compressed=False):
   image = Image.open(fn)
   print("\n"
         "#define {id}_width  {w}\n"
         "#define {id}_height {h}\n"
-        "\n"
-        "const uint8_t PROGMEM {id}_data[] = {{\n"
         .format(id=id, w=image.width, h=image.height), end='')
+
+  if paged:
+    data = pages(image)
+    if compressed:
+      data = rle(data)
+      print("\n"
+            "// SSD1306 page order, run-length encoded ({n} of {r} bytes)\n"
+            .format(n=len(data), r=image.width * ((image.height + 7)//8)), end='')
+    else:
+      print("\n"
+            "// SSD1306 page order, {p} pages of {w} bytes\n"
+            .format(p=(image.height + 7)//8, w=image.width), end='')
+    print("const uint8_t PROGMEM {id}_data[] = {{".format(id=id))
+    print_bytes(data)
+    print("};")
+    return
+
+  print("\n"
+        "const uint8_t PROGMEM {id}_data[] = {{\n"
+        .format(id=id), end='')
   for y in range(0, image.height):
     for x in range(0, (image.width + 7)//8 * 8):
       if x == 0:
@@ -30,9 +93,15 @@ def main(fn, id):
   print("};")
 
 if __name__ == '__main__':
-    if len(sys.argv) < 3:
-      print("Usage: {} <imagefile> <id>\n".format(sys.argv[0]), file=sys.stderr);
+    args = [a for a in sys.argv[1:] if not a.startswith('--')]
+    flags = [a for a in sys.argv[1:] if a.startswith('--')]
+    if len(args) < 2 or any(f not in ('--pages', '--rle') for f in flags):
+      print("Usage: {} <imagefile> <id> [--pages [--rle]]\n"
+            "  --pages  SSD1306 page order, for drawing with blit() or\n"
+            "           streamImage()\n"
+            "  --rle    run-length encode it, for streamImageRLE()\n"
+            .format(sys.argv[0]), file=sys.stderr);
       sys.exit(1)
-    fn = sys.argv[1]
-    id = sys.argv[2]
-    main(fn, id)
+    fn = args[0]
+    id = args[1]
+    main(fn, id, '--pages' in flags or '--rle' in flags, '--rle' in flags)
@@ -188,6 +188,9 @@ status_t LSM6DS3Core::readRegisterRegion(uint8_t* outputPointer, uint8_t offset,
                     outputPointer++;
                     i++;
                 }
+                if (i < length) {
+                    returnError = IMU_HW_ERROR; // short read
+                }
             }
             break;
 
@@ -0,0 +1,70 @@
+#include "accelFifo.h"
+
+#define fifoModeContinuous 0x06
+#define fifoOverrun 0x40  // FIFO_STATUS2 bits
+#define fifoLevelMask 0x0F
+#define fifoPatternMask 0x03  // FIFO_STATUS4
+
+void AccelFifo::begin() {
+  // Accelerometer only, no decimation, FIFO ODR matching the accelerometer ODR
+  uint8_t rate;
+  switch (imu.settings.accelSampleRate) {
+    case 13:   rate = LSM6DS3_ACC_GYRO_ODR_FIFO_10Hz; break;
+    case 26:   rate = LSM6DS3_ACC_GYRO_ODR_FIFO_25Hz; break;
+    case 52:   rate = LSM6DS3_ACC_GYRO_ODR_FIFO_50Hz; break;
+    case 104:  rate = LSM6DS3_ACC_GYRO_ODR_FIFO_100Hz; break;
+    default:
+    case 208:  rate = LSM6DS3_ACC_GYRO_ODR_FIFO_200Hz; break;
+    case 416:  rate = LSM6DS3_ACC_GYRO_ODR_FIFO_400Hz; break;
+    case 833:  rate = LSM6DS3_ACC_GYRO_ODR_FIFO_800Hz; break;
+    case 1660: rate = LSM6DS3_ACC_GYRO_ODR_FIFO_1600Hz; break;
+    case 3330: rate = LSM6DS3_ACC_GYRO_ODR_FIFO_3300Hz; break;
+    case 6660: rate = LSM6DS3_ACC_GYRO_ODR_FIFO_6600Hz; break;
+  }
+  // bypass first to flush anything left from a previous configuration
+  imu.writeRegister(LSM6DS3_ACC_GYRO_FIFO_CTRL5, 0);
+  imu.writeRegister(LSM6DS3_ACC_GYRO_FIFO_CTRL1, 0);
+  imu.writeRegister(LSM6DS3_ACC_GYRO_FIFO_CTRL2, 0);
+  imu.writeRegister(LSM6DS3_ACC_GYRO_FIFO_CTRL3, LSM6DS3_ACC_GYRO_DEC_FIFO_XL_NO_DECIMATION);
+  imu.writeRegister(LSM6DS3_ACC_GYRO_FIFO_CTRL4, 0);
+  imu.writeRegister(LSM6DS3_ACC_GYRO_FIFO_CTRL5, rate | fifoModeContinuous);
+}
+
+uint16_t AccelFifo::read(accelSample *samples, uint16_t maxSamples) {
+  // FIFO_STATUS1..4: unread words, flags and the pattern index of the next word
+  uint8_t status[4];
+  if (imu.readRegisterRegion(status, LSM6DS3_ACC_GYRO_FIFO_STATUS1, 4) != IMU_SUCCESS) {
+    imu.nonSuccessCounter++;
+    return 0;
+  }
+  if ((status[0] & status[1] & status[2] & status[3]) == 0xFF) {
+    imu.allOnesCounter++;  // nobody drove SDA, the read is garbage
+    return 0;
+  }
+  uint16_t words = status[0] | (uint16_t)(status[1] & fifoLevelMask) << 8;
+  uint16_t pattern = status[2] | (uint16_t)(status[3] & fifoPatternMask) << 8;
+  if (status[1] & fifoOverrun) {
+    overruns++;
+  }
+
+  // after an overrun the next word may not be an X, skip to the next whole sample
+  if (pattern && words >= 3 - pattern) {
+    uint8_t discard[4];
+    imu.readRegisterRegion(discard, LSM6DS3_ACC_GYRO_FIFO_DATA_OUT_L, 2 * (3 - pattern));
+    words -= 3 - pattern;
+  }
+
+  uint16_t count = words / 3;
+  if (count > maxSamples) {
+    count = maxSamples;
+  }
+  // FIFO_DATA_OUT wraps back to _L on every word, so one read returns consecutive words
+  for (uint16_t done = 0; done < count; done += accelFifoBurst) {
+    uint8_t burst = count - done < accelFifoBurst ? count - done : accelFifoBurst;
+    if (imu.readRegisterRegion((uint8_t *)&samples[done], LSM6DS3_ACC_GYRO_FIFO_DATA_OUT_L, burst * sizeof(accelSample)) != IMU_SUCCESS) {
+      imu.nonSuccessCounter++;
+      return done;
+    }
+  }
+  return count;
+}
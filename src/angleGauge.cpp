@@ -0,0 +1,151 @@
+#include "angleGauge.h"
+#include <math.h>
+#include <string.h>
+
+// Sparkline (and pitch bar) full scale steps in degrees, the smallest that fits the history is used
+static const uint8_t gaugeRanges[] = { 5, 10, 20, 45, 90, 180 };
+
+static int16_t tenths(float degrees) {
+  if (degrees != degrees) {
+    return 0;  // NaN (a failed IMU read) would make the conversion undefined, plot it level
+  }
+  float value = degrees * 10 + (degrees < 0 ? -0.5 : 0.5);
+  if (value > 32767) {
+    return 32767;
+  }
+  if (value < -32767) {
+    return -32767;
+  }
+  return value;
+}
+
+void AngleHistory::add(float roll, float pitch) {
+  rolls[head] = tenths(roll);
+  pitches[head] = tenths(pitch);
+  head = (head + 1) % gaugeHistorySize;
+  if (count < gaugeHistorySize) {
+    count++;
+  }
+  total++;
+}
+
+int16_t AngleHistory::peak() const {
+  int16_t largest = 0;
+  uint16_t shown = count < gaugeColumns ? count : gaugeColumns;
+  for (uint16_t age = 0; age < shown; age++) {
+    int16_t r = abs(roll(age));
+    int16_t p = abs(pitch(age));
+    if (r > largest) {
+      largest = r;
+    }
+    if (p > largest) {
+      largest = p;
+    }
+  }
+  return largest;
+}
+
+int16_t AngleGauge::row(int16_t tenths) const {
+  // 0 on the middle row, +range at the top, clipped to the sparkline
+  int32_t y = gaugeSparkHeight / 2 - (int32_t)tenths * (gaugeSparkHeight / 2) / (shownRange * 10);
+  if (y < 0) {
+    return 0;
+  }
+  if (y > gaugeSparkHeight - 1) {
+    return gaugeSparkHeight - 1;
+  }
+  return y;
+}
+
+void AngleGauge::drawColumn(int16_t x, uint16_t age) {
+  uint32_t reading = history.added() - age;  // the column pattern scrolls with the data
+  if (reading % 8 == 0) {
+    sparkline.drawPixel(x, row(0), SSD1306_WHITE);  // dotted zero line
+  }
+  // roll: solid, joined to the previous reading with a vertical run in this column
+  int16_t y = row(history.roll(age));
+  int16_t previous = age + 1 < history.size() ? row(history.roll(age + 1)) : y;
+  sparkline.drawFastVLine(x, min(y, previous), abs(y - previous) + 1, SSD1306_WHITE);
+  // pitch: dotted, every other reading
+  if (reading % 2 == 0) {
+    sparkline.drawPixel(x, row(history.pitch(age)), SSD1306_WHITE);
+  }
+}
+
+void AngleGauge::updateSparkline() {
+  int16_t peak = history.peak();
+  uint8_t range = gaugeRanges[sizeof(gaugeRanges) - 1];
+  for (uint8_t i = 0; i < sizeof(gaugeRanges); i++) {
+    if (gaugeRanges[i] * 10 >= peak) {
+      range = gaugeRanges[i];
+      break;
+    }
+  }
+  uint32_t fresh = history.added() - drawnTotal;
+  if (range != shownRange || fresh >= gaugeColumns) {
+    // rescaled (or too far behind): redraw every column from the history
+    shownRange = range;
+    sparkline.fillScreen(SSD1306_BLACK);
+    fresh = history.size() < gaugeColumns ? history.size() : gaugeColumns;
+  }
+  else {
+    sparkline.shiftColumns(fresh);
+  }
+  for (uint16_t age = 0; age < fresh; age++) {
+    drawColumn(gaugeColumns - 1 - age, age);
+  }
+  drawnTotal = history.added();
+}
+
+void AngleGauge::draw(Adafruit_SSD1306 &display, float roll, float pitch, const char *rollText, const char *pitchText) {
+  updateSparkline();
+  display.blit(sparkline, 0, gaugeSparkTop);
+  // scale legend over the oldest columns
+  display.setTextSize(1);
+  display.setTextColor(SSD1306_WHITE, SSD1306_BLACK);
+  display.setCursor(0, gaugeSparkTop);
+  display.print(shownRange);
+  display.print((char)247);  // degree symbol
+
+  // roll dial: a horizon line turned by the roll angle, positive counterclockwise,
+  // with a short mark on its upper side so upside down reads differently
+  float angle = roll * (float)(M_PI / 180);
+  float c = cosf(angle);
+  float s = sinf(angle);
+  int16_t dx = lroundf(c * (gaugeDialRadius - 2));
+  int16_t dy = lroundf(s * (gaugeDialRadius - 2));
+  display.drawCircle(gaugeDialX, gaugeDialY, gaugeDialRadius, SSD1306_WHITE);
+  display.drawFastVLine(gaugeDialX, gaugeDialY - gaugeDialRadius, 3, SSD1306_WHITE);  // level mark
+  display.drawLine(gaugeDialX - dx, gaugeDialY + dy, gaugeDialX + dx, gaugeDialY - dy, SSD1306_WHITE);
+  display.drawLine(gaugeDialX, gaugeDialY, gaugeDialX - lroundf(s * gaugeDialRadius / 2), gaugeDialY - lroundf(c * gaugeDialRadius / 2), SSD1306_WHITE);
+  display.fillCircle(gaugeDialX, gaugeDialY, 1, SSD1306_WHITE);
+
+  // pitch bar: filled from the centre, full at the sparkline range
+  int16_t bar = lroundf(pitch * gaugeDialRadius / shownRange);
+  if (bar > gaugeDialRadius - 1) {
+    bar = gaugeDialRadius - 1;
+  }
+  if (bar < 1 - gaugeDialRadius) {
+    bar = 1 - gaugeDialRadius;
+  }
+  display.drawRect(gaugeBarX, gaugeDialY - gaugeDialRadius, gaugeBarWidth, gaugeDialRadius * 2 + 1, SSD1306_WHITE);
+  if (bar > 0) {
+    display.fillRect(gaugeBarX + 1, gaugeDialY - bar, gaugeBarWidth - 2, bar, SSD1306_WHITE);
+  }
+  else if (bar < 0) {
+    display.fillRect(gaugeBarX + 1, gaugeDialY + 1, gaugeBarWidth - 2, -bar, SSD1306_WHITE);
+  }
+  display.drawFastHLine(gaugeBarX - 1, gaugeDialY, gaugeBarWidth + 2, SSD1306_WHITE);  // zero mark
+
+  // values, right justified (12 pixel cells at size 2)
+  display.setTextColor(SSD1306_WHITE);
+  display.setCursor(gaugeTextX, 5);
+  display.print('R');
+  display.setCursor(gaugeTextX, 25);
+  display.print('P');
+  display.setTextSize(2);
+  display.setCursor(gaugeTextRight - 12 * strlen(rollText), 1);
+  display.print(rollText);
+  display.setCursor(gaugeTextRight - 12 * strlen(pitchText), 21);
+  display.print(pitchText);
+}
@@ -0,0 +1,65 @@
+#include "batteryCharge.h"
+
+// Resting voltage of a typical 1s lipo at 0, 5, 10 ... 100% charge (mV)
+static const uint16_t lipoTable[] = {
+  3270, 3610, 3690, 3710, 3730, 3750, 3770, 3790, 3800, 3820, 3840,
+  3850, 3870, 3910, 3950, 3980, 4020, 4080, 4110, 4150, 4200
+};
+#define lipoSteps (sizeof(lipoTable) / sizeof(lipoTable[0]) - 1)
+#define lipoStepCharge (10000 / lipoSteps)
+static_assert(lipoSteps * lipoStepCharge == 10000, "lipoTable must split 100% evenly");
+
+uint16_t BatteryCharge::ocvToCharge(uint16_t millivolts) {
+  if (millivolts <= lipoTable[0]) {
+    return 0;
+  }
+  if (millivolts >= lipoTable[lipoSteps]) {
+    return 10000;
+  }
+  uint8_t step = 0;
+  while (millivolts >= lipoTable[step + 1]) {
+    step++;
+  }
+  // linear between the two table points
+  uint16_t span = lipoTable[step + 1] - lipoTable[step];
+  return step * lipoStepCharge + ((uint32_t)(millivolts - lipoTable[step]) * lipoStepCharge + span / 2) / span;
+}
+
+bool BatteryCharge::update(uint32_t now, uint16_t millivolts, uint16_t loadMilliamps) {
+  if (started && now - lastUpdate < batteryChargePeriod) {
+    return false;
+  }
+  started = true;
+  lastUpdate = now;
+
+  // the terminal voltage sags by I*R under load, add it back to get the resting voltage
+  uint16_t restingVoltage = millivolts + (uint32_t)loadMilliamps * batteryResistance / 1000;
+  charge = ocvToCharge(restingVoltage);
+
+  history[historyHead] = charge;
+  historyHead = (historyHead + 1) % batteryHistorySize;
+  if (historyCount < batteryHistorySize) {
+    historyCount++;
+  }
+
+  // least squares slope of the history, then smoothed, single readings are too noisy on the flat part of the curve
+  remaining = batteryUnknownTime;
+  if (historyCount < 4) {
+    return true;
+  }
+  float sumX = 0, sumY = 0, sumXY = 0, sumXX = 0;
+  for (uint8_t i = 0; i < historyCount; i++) {
+    float y = history[(historyHead + batteryHistorySize - historyCount + i) % batteryHistorySize];
+    sumX += i;
+    sumY += y;
+    sumXY += i * y;
+    sumXX += (float)i * i;
+  }
+  float slope = (historyCount * sumXY - sumX * sumY) / (historyCount * sumXX - sumX * sumX);
+  dischargeRate += (-slope - dischargeRate) / 4;
+  if (dischargeRate > 0.01) {
+    float minutes = charge / dischargeRate * batteryChargePeriod / 60000;
+    remaining = minutes < batteryUnknownTime ? minutes : batteryUnknownTime - 1;
+  }
+  return true;
+}
@@ -0,0 +1,90 @@
+#include "batteryMonitor.h"
+
+#if defined(NRF52840_XXAA)
+#include <nrf.h>
+#endif
+
+#define adcFullScale 3600  // mV, 0.6V internal reference with 1/6 gain
+#define adcCounts 4096     // 12 bit
+#define rtcTickRate 8      // Hz, RTC2 prescaler 4095
+
+uint16_t BatteryMonitor::resultToMillivolts(int16_t result) {
+  // pin mV scaled up by the divider, rounded
+  if (result < 0) {
+    result = 0;  // single ended inputs can read slightly below zero
+  }
+  uint32_t scale = (uint32_t)adcCounts * batteryDividerLow;
+  return ((uint64_t)result * adcFullScale * batteryDividerHigh + scale / 2) / scale;
+}
+
+void BatteryMonitor::addReading(uint16_t millivolts) {
+  // Exponential average, the first reading is taken as is
+  uint32_t reading = (uint32_t)millivolts << 4;
+  if (!primed) {
+    filtered = reading;
+    primed = true;
+    return;
+  }
+  if (reading > filtered) {
+    filtered += (reading - filtered) >> batteryFilterShift;
+  }
+  else {
+    filtered -= (filtered - reading) >> batteryFilterShift;
+  }
+}
+
+#if defined(NRF52840_XXAA)
+void BatteryMonitor::begin(uint8_t ain, uint16_t periodMs) {
+  // SAADC: one channel, 12 bit, burst oversampling, long acquisition for the high impedance divider
+  NRF_SAADC->ENABLE = 0;
+  NRF_SAADC->RESOLUTION = SAADC_RESOLUTION_VAL_12bit;
+  NRF_SAADC->OVERSAMPLE = batteryOversample;
+  for (uint8_t i = 0; i < 8; i++) {
+    NRF_SAADC->CH[i].PSELP = SAADC_CH_PSELP_PSELP_NC;
+  }
+  NRF_SAADC->CH[0].CONFIG = (SAADC_CH_CONFIG_GAIN_Gain1_6 << SAADC_CH_CONFIG_GAIN_Pos)
+                          | (SAADC_CH_CONFIG_REFSEL_Internal << SAADC_CH_CONFIG_REFSEL_Pos)
+                          | (SAADC_CH_CONFIG_TACQ_40us << SAADC_CH_CONFIG_TACQ_Pos)
+                          | (SAADC_CH_CONFIG_BURST_Enabled << SAADC_CH_CONFIG_BURST_Pos);
+  NRF_SAADC->CH[0].PSELP = SAADC_CH_PSELP_PSELP_AnalogInput0 + ain;
+  NRF_SAADC->RESULT.PTR = (uint32_t)&result;
+  NRF_SAADC->RESULT.MAXCNT = 1;
+  NRF_SAADC->INTENCLR = 0xFFFFFFFF;  // polled from loop()
+  NRF_SAADC->ENABLE = 1;
+
+  // offset calibration once at startup (a few hundred usec)
+  NRF_SAADC->EVENTS_CALIBRATEDONE = 0;
+  NRF_SAADC->TASKS_CALIBRATEOFFSET = 1;
+  while (!NRF_SAADC->EVENTS_CALIBRATEDONE) {}
+  NRF_SAADC->EVENTS_CALIBRATEDONE = 0;
+
+  // RTC2 runs from the 32kHz clock, so the timer costs next to nothing between readings
+  uint32_t ticks = (uint32_t)periodMs * rtcTickRate / 1000;
+  NRF_RTC2->TASKS_STOP = 1;
+  NRF_RTC2->PRESCALER = 4095;
+  NRF_RTC2->CC[0] = ticks ? ticks : 1;
+  NRF_RTC2->EVTENSET = RTC_EVTEN_COMPARE0_Msk;
+  NRF_RTC2->TASKS_CLEAR = 1;
+
+  NRF_PPI->CH[batteryPpiStart].EEP = (uint32_t)&NRF_RTC2->EVENTS_COMPARE[0];
+  NRF_PPI->CH[batteryPpiStart].TEP = (uint32_t)&NRF_SAADC->TASKS_START;
+  NRF_PPI->FORK[batteryPpiStart].TEP = (uint32_t)&NRF_RTC2->TASKS_CLEAR;
+  NRF_PPI->CH[batteryPpiSample].EEP = (uint32_t)&NRF_SAADC->EVENTS_STARTED;
+  NRF_PPI->CH[batteryPpiSample].TEP = (uint32_t)&NRF_SAADC->TASKS_SAMPLE;
+  NRF_PPI->CHENSET = (1 << batteryPpiStart) | (1 << batteryPpiSample);
+
+  NRF_SAADC->EVENTS_END = 0;
+  NRF_RTC2->TASKS_START = 1;
+  NRF_SAADC->TASKS_START = 1;  // first reading now, PPI triggers the sample
+}
+
+bool BatteryMonitor::update() {
+  if (!NRF_SAADC->EVENTS_END) {
+    return false;
+  }
+  NRF_SAADC->EVENTS_END = 0;
+  NRF_SAADC->EVENTS_STARTED = 0;
+  addReading(resultToMillivolts(result));
+  return true;
+}
+#endif
@@ -0,0 +1,82 @@
+#include "bleLinks.h"
+#include <string.h>
+
+bleLink *BleLinks::find(const char *address) {
+  for (uint8_t i = 0; i < bleMaxLinks; i++) {
+    if (table[i].used && strcmp(table[i].address, address) == 0) {
+      return &table[i];
+    }
+  }
+  return nullptr;
+}
+
+bool BleLinks::connect(const char *address, uint32_t now) {
+  bleLink *link = find(address);
+  if (!link) {
+    for (uint8_t i = 0; i < bleMaxLinks && !link; i++) {
+      if (!table[i].used) {
+        link = &table[i];
+      }
+    }
+    if (!link) {
+      return false;
+    }
+    links++;
+  }
+  link->used = true;
+  copyAddress(link->address, address);
+  link->connectedMillis = now;
+  return true;
+}
+
+void BleLinks::disconnect(const char *address) {
+  bleLink *link = find(address);
+  if (link) {
+    link->used = false;
+    links--;
+  }
+}
+
+const char *BleLinks::newest() const {
+  const bleLink *latest = nullptr;
+  for (uint8_t i = 0; i < bleMaxLinks; i++) {
+    if (table[i].used && (!latest || table[i].connectedMillis - latest->connectedMillis < 0x80000000)) {
+      latest = &table[i];
+    }
+  }
+  return latest ? latest->address : "";
+}
+
+void BleLinks::update(uint16_t channels, uint32_t now) {
+  if (!dirty) {
+    updateMillis = now;
+  }
+  dirty |= channels;
+}
+
+int8_t BleLinks::next(uint8_t *budget, uint16_t notifying, uint32_t now) {
+  for (uint8_t n = 0; n < bleMaxChannels && dirty; n++) {
+    uint8_t channel = (cursor + n) % bleMaxChannels;
+    if (!(dirty & (1 << channel))) {
+      continue;
+    }
+    // an unsubscribed write only updates the value for reads, it costs no packets
+    uint8_t cost = notifying & (1 << channel) ? links : 0;
+    if (cost > *budget) {
+      return bleNoChannel;  // wait for the next loop
+    }
+    *budget -= cost;
+    dirty &= ~(1 << channel);
+    cursor = channel + 1;
+    if (!dirty) {
+      latency = now - updateMillis;
+    }
+    return channel;
+  }
+  return bleNoChannel;
+}
+
+uint16_t bleChannelsDue(uint16_t all, uint16_t notifying, bool refreshDue, uint16_t unchanged) {
+  uint16_t channels = refreshDue ? all : all & notifying;
+  return channels & ~unchanged;
+}
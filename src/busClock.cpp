@@ -0,0 +1,22 @@
+#include "busClock.h"
+
+bool BusClock::update(uint16_t errors, uint32_t now) {
+  if (!started || now - windowStart >= busClockPeriod) {
+    started = true;
+    windowErrors = errors;
+    windowStart = now;
+    return false;
+  }
+  if ((uint16_t)(errors - windowErrors) < busClockMaxErrors) {
+    return false;
+  }
+  // too many for this speed, the next window starts at the new one
+  windowErrors = errors;
+  windowStart = now;
+  if (current == busClockStandard) {
+    return false;
+  }
+  current--;
+  stepDowns++;
+  return true;
+}
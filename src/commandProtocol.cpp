@@ -0,0 +1,127 @@
+#include "commandProtocol.h"
+#include <string.h>
+
+#define requestHeader 3
+#define responseHeader 4
+
+// payload bytes of each request, by opcode
+static const uint8_t payloadLength[commandOpcodeCount] = { 0, 2, 2, 1, 3, 1, 1, 0 };
+
+static const uint16_t imuRates[] = { 13, 26, 52, 104, 208, 416, 833, 1660, 3330, 6660 };
+
+static uint16_t readWord(const uint8_t *data) {
+  return data[0] | (uint16_t)data[1] << 8;
+}
+
+static bool validRate(uint16_t rate) {
+  for (uint8_t i = 0; i < sizeof(imuRates) / sizeof(imuRates[0]); i++) {
+    if (imuRates[i] == rate) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool validRange(uint8_t range) {
+  return range == 2 || range == 4 || range == 8 || range == 16;
+}
+
+static bool validStream(uint8_t stream) {
+  return stream == 0 || stream == 2 || stream == 3;  // off, telemetryFrameRaw, telemetryFrameAngles
+}
+
+bool validConfig(const commandConfig &config) {
+  return config.window >= 1 && config.window <= 1000
+      && config.filter < filterTypeCount
+      && validRate(config.imuRate)
+      && validRange(config.imuRange)
+      && validStream(config.stream)
+      && config.capture <= captureOn;
+}
+
+uint8_t handleCommand(const uint8_t *request, uint8_t length, commandConfig &config,
+                      uint8_t *response, uint8_t *responseLength) {
+  // Response header first, the status is filled in below
+  response[0] = commandVersion;
+  response[1] = length > 1 ? request[1] : 0;
+  response[2] = length > 2 ? request[2] : 0;
+  response[3] = commandOk;
+  *responseLength = responseHeader;
+
+  if (length < requestHeader) {
+    response[3] = commandBadLength;
+    return 0;
+  }
+  if (request[0] != commandVersion) {
+    response[3] = commandBadVersion;
+    return 0;
+  }
+  uint8_t opcode = request[2];
+  if (opcode >= commandOpcodeCount) {
+    response[3] = commandBadOpcode;
+    return 0;
+  }
+  if (length != requestHeader + payloadLength[opcode]) {
+    response[3] = commandBadLength;
+    return 0;
+  }
+
+  // Work on a copy, config only changes if the request is valid
+  const uint8_t *payload = &request[requestHeader];
+  commandConfig updated = config;
+  uint8_t actions = 0;
+  switch (opcode) {
+    case commandGetConfig:
+      break;
+    case commandSetWindow:
+      updated.window = readWord(payload);
+      break;
+    case commandSetOutput:
+      updated.outputPeriod = readWord(payload);
+      break;
+    case commandSetFilter:
+      updated.filter = payload[0];
+      break;
+    case commandSetImu:
+      updated.imuRate = readWord(payload);
+      updated.imuRange = payload[2];
+      break;
+    case commandSetStream:
+      updated.stream = payload[0];
+      break;
+    case commandSetCapture:
+      if (payload[0] == captureReset) {
+        actions = commandActionReset;
+      }
+      else {
+        updated.capture = payload[0];
+      }
+      break;
+    case commandPersist:
+      actions = commandActionPersist;
+      break;
+  }
+  if (!validConfig(updated)) {
+    response[3] = commandBadValue;
+    return 0;
+  }
+  // only what really changed needs applying, a repeated request doesn't restart the IMU
+  if (updated.imuRate != config.imuRate || updated.imuRange != config.imuRange) {
+    actions |= commandActionImu;
+  }
+  if (updated.window != config.window) {
+    actions |= commandActionWindow;
+  }
+  if (updated.stream != config.stream) {
+    actions |= commandActionStream;
+  }
+  if (updated.capture != config.capture) {
+    actions |= commandActionCapture;
+  }
+  config = updated;
+
+  // every accepted request answers with the resulting config
+  memcpy(&response[responseHeader], &config, sizeof(config));
+  *responseLength = responseHeader + sizeof(config);
+  return actions;
+}
@@ -0,0 +1,254 @@
+#include "dfuEngine.h"
+#include <string.h>
+
+#if defined(NRF52840_XXAA)
+#include <nrf.h>
+#endif
+
+#define dfuChunkHeader 4  // uint32 offset
+#define dfuRamStart 0x20000000  // nRF52840 data RAM, 256kB
+#define dfuRamEnd 0x20040000
+
+DfuEngine::DfuEngine(SettingsFlash &flash, uint32_t slotBase, uint32_t slotSize, uint32_t pageSize, uint32_t appBase, uint32_t codeEnd)
+  : flash(flash), slotBase(slotBase), slotSize(slotSize), pageSize(pageSize), appBase(appBase), codeEnd(codeEnd) {}
+
+uint32_t DfuEngine::crc32(const void *data, uint32_t length, uint32_t crc) {
+  // same crc32 as the settings store (no final xor, so it can be continued)
+  const uint8_t *bytes = (const uint8_t *)data;
+  while (length--) {
+    crc ^= *bytes++;
+    for (uint8_t bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+  }
+  return crc;
+}
+
+void DfuEngine::begin(const dfuProgress *resume) {
+  if (!resume || !resume->size || resume->size > slotSize || resume->offset > resume->size || codeEnd > slotBase) {
+    return;
+  }
+  // chunks after the checkpoint may have been written before the reset, so restart
+  // from the top of the page and redo the crc from what is in flash
+  transfer = *resume;
+  transfer.offset -= transfer.offset % pageSize;
+  transfer.runningCrc = 0xFFFFFFFF;
+  uint8_t buffer[64];
+  for (uint32_t done = 0; done < transfer.offset; done += sizeof(buffer)) {
+    flash.read(slotBase + done, buffer, sizeof(buffer));
+    transfer.runningCrc = crc32(buffer, sizeof(buffer), transfer.runningCrc);
+  }
+  saved = transfer;
+  startErase();
+}
+
+void DfuEngine::startErase() {
+  // the pages from the transfer offset to the end of the image, the rest of the slot isn't used
+  eraseAddress = slotBase + (transfer.offset + pageSize - 1) / pageSize * pageSize;
+  eraseEnd = slotBase + (transfer.size + pageSize - 1) / pageSize * pageSize;
+  current = dfuErasing;
+}
+
+bool DfuEngine::blank(uint32_t page) {
+  uint32_t buffer[16];
+  for (uint32_t done = 0; done < pageSize; done += sizeof(buffer)) {
+    flash.read(page + done, buffer, sizeof(buffer));
+    for (uint8_t i = 0; i < 16; i++) {
+      if (buffer[i] != 0xFFFFFFFF) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool DfuEngine::erase() {
+  if (current != dfuErasing) {
+    return false;
+  }
+  // reading a page back is far quicker than erasing it, blank ones are skipped
+  while (eraseAddress < eraseEnd && blank(eraseAddress)) {
+    eraseAddress += pageSize;
+  }
+  if (eraseAddress < eraseEnd) {
+    flash.erase(eraseAddress);
+    eraseAddress += pageSize;
+    return false;
+  }
+  current = dfuReceiving;
+  return true;
+}
+
+void DfuEngine::status(uint8_t opcode, uint8_t result, dfuResponse *response) const {
+  response->opcode = opcode | 0x80;
+  response->result = result;
+  response->state = current;
+  response->offset = transfer.offset;
+  response->size = transfer.size;
+}
+
+void DfuEngine::control(const uint8_t *request, uint8_t length, dfuResponse *response) {
+  uint8_t opcode = length ? request[0] : 0;
+  uint8_t result = dfuOk;
+  switch (opcode) {
+    case dfuStart: {
+      if (length != 9) {
+        result = dfuBadLength;
+        break;
+      }
+      uint32_t size, crc;
+      memcpy(&size, &request[1], 4);
+      memcpy(&crc, &request[5], 4);
+      if (codeEnd > slotBase) {
+        result = dfuSlotInUse;  // erasing the slot would erase the running code
+        break;
+      }
+      if (!size || size > slotSize) {
+        result = dfuTooLarge;
+        break;
+      }
+      if (current != dfuIdle && size == transfer.size && crc == transfer.crc) {
+        break;  // same image, carry on from transfer.offset (once erased)
+      }
+      transfer = { size, crc, 0, 0xFFFFFFFF };
+      saved = transfer;
+      savePending = true;
+      startErase();
+      break;
+    }
+    case dfuStatus:
+      if (length != 1) {
+        result = dfuBadLength;
+      }
+      break;
+    case dfuInstall:
+      if (length != 1) {
+        result = dfuBadLength;
+      }
+      else if (current == dfuIdle) {
+        result = dfuNotStarted;
+      }
+      else if (transfer.offset < transfer.size) {
+        result = dfuIncomplete;
+      }
+      else {
+        result = !verify() ? dfuCrcError : !bootable() ? dfuBadImage : dfuOk;
+        if (result == dfuOk) {
+          current = dfuVerified;
+        }
+        else {
+          transfer = {};
+          saved = transfer;
+          savePending = true;
+          current = dfuIdle;
+        }
+      }
+      break;
+    case dfuAbort:
+      transfer = {};
+      saved = transfer;
+      savePending = true;
+      current = dfuIdle;
+      break;
+    default:
+      result = dfuBadOpcode;
+      break;
+  }
+  status(opcode, result, response);
+}
+
+uint8_t DfuEngine::data(const uint8_t *chunk, uint8_t length) {
+  if (current != dfuReceiving) {
+    return dfuNotStarted;
+  }
+  if (length <= dfuChunkHeader || length > dfuChunkHeader + dfuMaxChunk) {
+    return dfuBadLength;
+  }
+  uint32_t offset;
+  memcpy(&offset, chunk, 4);
+  const uint8_t *bytes = &chunk[dfuChunkHeader];
+  uint8_t count = length - dfuChunkHeader;
+  if (offset != transfer.offset) {
+    return dfuBadOffset;  // a resend of something already written, or a gap
+  }
+  bool last = offset + count == transfer.size;
+  if (offset + count > transfer.size || (count % 4 && !last)) {
+    return dfuBadLength;
+  }
+
+  // word aligned copy, the last chunk is padded with erased bytes
+  uint32_t words[dfuMaxChunk / 4];
+  memset(words, 0xFF, sizeof(words));
+  memcpy(words, bytes, count);
+  uint32_t wordCount = (count + 3) / 4;
+  flash.program(slotBase + offset, words, wordCount);  // erased before the dfuStart was answered
+
+  transfer.runningCrc = crc32(bytes, count, transfer.runningCrc);
+  uint32_t previous = transfer.offset;
+  transfer.offset += count;
+  // checkpoint once per page
+  if (transfer.offset / pageSize != previous / pageSize || last) {
+    saved = transfer;
+    savePending = true;
+  }
+  return dfuOk;
+}
+
+bool DfuEngine::progressDue() {
+  bool due = savePending;
+  savePending = false;
+  return due;
+}
+
+bool DfuEngine::verify() {
+  // read back what actually ended up in flash
+  uint32_t crc = 0xFFFFFFFF;
+  uint8_t buffer[64];
+  for (uint32_t done = 0; done < transfer.size; done += sizeof(buffer)) {
+    uint32_t length = transfer.size - done < sizeof(buffer) ? transfer.size - done : sizeof(buffer);
+    flash.read(slotBase + done, buffer, length);
+    crc = crc32(buffer, length, crc);
+  }
+  return crc == transfer.crc;
+}
+
+bool DfuEngine::bootable() {
+  // the crc only says the bytes arrived as sent: a .hex, a .uf2 or another board's build
+  // would pass it too, and installing one leaves the board for USB recovery
+  uint32_t vectors[2];  // initial stack pointer, reset handler
+  if (transfer.size < sizeof(vectors)) {
+    return false;
+  }
+  flash.read(slotBase, vectors, sizeof(vectors));
+  uint32_t reset = vectors[1] & ~1;
+  return vectors[0] > dfuRamStart && vectors[0] <= dfuRamEnd && vectors[0] % 4 == 0
+    && (vectors[1] & 1) && reset >= appBase && reset < appBase + transfer.size;
+}
+
+#if defined(NRF52840_XXAA)
+__attribute__((noinline, long_call, section(".data")))
+void dfuInstallImage(uint32_t from, uint32_t to, uint32_t size, uint32_t pageSize) {
+  // nothing in here may call into flash, NVMC registers only
+  __disable_irq();
+  for (uint32_t done = 0; done < size; done += pageSize) {
+    NRF_NVMC->CONFIG = NVMC_CONFIG_WEN_Een << NVMC_CONFIG_WEN_Pos;
+    while (!NRF_NVMC->READY) {}
+    NRF_NVMC->ERASEPAGE = to + done;
+    while (!NRF_NVMC->READY) {}
+    NRF_NVMC->CONFIG = NVMC_CONFIG_WEN_Wen << NVMC_CONFIG_WEN_Pos;
+    while (!NRF_NVMC->READY) {}
+    volatile uint32_t *destination = (volatile uint32_t *)(to + done);
+    const volatile uint32_t *source = (const volatile uint32_t *)(from + done);
+    for (uint32_t i = 0; i < pageSize / 4 && done + i * 4 < size; i++) {
+      destination[i] = source[i];
+      while (!NRF_NVMC->READY) {}
+    }
+    NRF_NVMC->CONFIG = NVMC_CONFIG_WEN_Ren << NVMC_CONFIG_WEN_Pos;
+  }
+  // NVIC_SystemReset() is inline, but spell it out in case it isn't
+  __DSB();
+  SCB->AIRCR = (0x5FAUL << SCB_AIRCR_VECTKEY_Pos) | SCB_AIRCR_SYSRESETREQ_Msk;
+  __DSB();
+  while (1) {}
+}
+#endif
@@ -0,0 +1,287 @@
+#include "i2cQueue.h"
+#include <string.h>
+
+#if defined(NRF52840_XXAA)
+#include <Arduino.h>
+#include <nrf.h>
+#endif
+
+bool I2cQueue::submit(i2cTransaction &transaction) {
+  if (count >= i2cQueueLength) {
+    return false;
+  }
+  for (uint8_t i = 0; i < count; i++) {
+    if (queue[i] == &transaction) {
+      return false;
+    }
+  }
+  transaction.sent = 0;
+  transaction.order = nextOrder++;
+  transaction.status = i2cQueued;
+  queue[count++] = &transaction;
+  return true;
+}
+
+bool I2cQueue::setBus(I2cBus &newBus) {
+  if (count) {
+    return false;
+  }
+  bus = &newBus;
+  return true;
+}
+
+int8_t I2cQueue::pick() const {
+  // highest priority first, then the oldest (orders wrap, so compare the difference)
+  int8_t best = -1;
+  for (uint8_t i = 0; i < count; i++) {
+    if (best < 0 || queue[i]->priority > queue[best]->priority
+        || (queue[i]->priority == queue[best]->priority && (int16_t)(queue[i]->order - queue[best]->order) < 0)) {
+      best = i;
+    }
+  }
+  return best;
+}
+
+void I2cQueue::finish(uint8_t slot, uint8_t status) {
+  // out of the queue before the callback, so it can submit again
+  i2cTransaction &transaction = *queue[slot];
+  count--;
+  for (uint8_t i = slot; i < count; i++) {
+    queue[i] = queue[i + 1];
+  }
+  completed++;
+  if (status == i2cFailed) {
+    failed++;
+  }
+  transaction.status = status;
+  if (transaction.done) {
+    transaction.done(transaction);
+  }
+}
+
+void I2cQueue::service() {
+  if (active >= 0) {
+    uint8_t status = bus->poll();
+    if (status == i2cRunning) {
+      return;
+    }
+    uint8_t slot = active;
+    i2cTransaction &transaction = *queue[slot];
+    active = -1;
+    transaction.sent += activeLength;
+    if (status != i2cDone) {
+      finish(slot, i2cFailed);
+    }
+    else if (transaction.sent >= transaction.length) {
+      finish(slot, i2cDone);
+    }
+    else {
+      transaction.status = i2cQueued;  // more chunks, something more urgent may go first
+    }
+  }
+
+  int8_t slot = pick();
+  if (slot < 0) {
+    return;
+  }
+  i2cTransaction &transaction = *queue[slot];
+  if (transaction.prefixed && !transaction.sent) {
+    // prefix and data in one zero-copy transfer, if the bus can reach them
+    const uint8_t *run = transaction.data - transaction.prefixLength;
+    uint16_t runLength = transaction.prefixLength + transaction.length;
+    if (runLength <= bus->maxDirect(run)) {
+      transaction.status = i2cRunning;
+      if (!bus->startDirect(transaction.address, run, runLength, transaction.readData, transaction.readLength)) {
+        finish(slot, i2cFailed);
+        return;
+      }
+      active = slot;
+      activeLength = transaction.length;
+      return;
+    }
+  }
+  uint16_t remaining = transaction.length - transaction.sent;
+  uint16_t chunk = bus->maxTransfer(transaction.prefixLength);
+  if (transaction.chunkSize && transaction.chunkSize < chunk) {
+    chunk = transaction.chunkSize;
+  }
+  if (remaining < chunk) {
+    chunk = remaining;
+  }
+  bool last = chunk == remaining;
+  if ((!chunk && remaining) || (last && transaction.readLength > bus->maxTransfer(0))) {
+    finish(slot, i2cFailed);  // can never fit the bus
+    return;
+  }
+  transaction.status = i2cRunning;
+  if (!bus->start(transaction.address, transaction.prefix, transaction.prefixLength,
+                 transaction.data + transaction.sent, chunk,
+                 last ? transaction.readData : nullptr, last ? transaction.readLength : 0)) {
+    finish(slot, i2cFailed);
+    return;
+  }
+  active = slot;
+  activeLength = chunk;
+}
+
+#if defined(ARDUINO)
+bool WireI2cBus::start(uint8_t address, const uint8_t *prefix, uint8_t prefixLength,
+                       const uint8_t *data, uint16_t length, uint8_t *readData, uint16_t readLength) {
+  result = i2cFailed;
+  if (prefixLength + length > i2cWireBuffer || readLength > 255) {
+    return false;
+  }
+  if (prefixLength + length) {
+    wire.beginTransmission(address);
+    wire.write(prefix, prefixLength);
+    wire.write(data, length);
+    if (wire.endTransmission(!readLength) != 0) {
+      return true;  // NACK, reported by poll()
+    }
+  }
+  if (readLength) {
+    if (wire.requestFrom(address, (uint8_t)readLength) != readLength) {
+      return true;
+    }
+    for (uint16_t i = 0; i < readLength; i++) {
+      readData[i] = wire.read();
+    }
+  }
+  result = i2cDone;
+  return true;
+}
+
+void WireI2cBus::setClock(uint32_t hz) {
+  wire.setClock(hz);
+}
+#endif
+
+#if defined(NRF52840_XXAA)
+#define TWIM ((NRF_TWIM_Type *)twim)
+
+bool TwimI2cBus::begin(uint32_t sdaPin, uint32_t sclPin, uint32_t hz) {
+  // TWI0/TWIM0 and TWI1/TWIM1 share their registers, find the one Wire set up on these pins
+  NRF_TWIM_Type *instances[] = { NRF_TWIM0, NRF_TWIM1 };
+  for (NRF_TWIM_Type *instance : instances) {
+    if (instance->ENABLE != 0 && instance->PSEL.SDA == sdaPin && instance->PSEL.SCL == sclPin) {
+      twim = instance;
+      setClock(hz);
+      return true;
+    }
+  }
+  return false;
+}
+
+void TwimI2cBus::setClock(uint32_t hz) {
+  clock = hz;
+  frequency = hz >= 400000 ? TWIM_FREQUENCY_FREQUENCY_K400
+            : hz >= 250000 ? TWIM_FREQUENCY_FREQUENCY_K250
+            : TWIM_FREQUENCY_FREQUENCY_K100;
+}
+
+bool TwimI2cBus::start(uint8_t address, const uint8_t *prefix, uint8_t prefixLength,
+                       const uint8_t *data, uint16_t length, uint8_t *readData, uint16_t readLength) {
+  if (prefixLength + length > twimBufferSize || running) {
+    result = i2cFailed;
+    return false;
+  }
+  memcpy(buffer, prefix, prefixLength);
+  memcpy(&buffer[prefixLength], data, length);
+  return startDirect(address, buffer, prefixLength + length, readData, readLength);
+}
+
+uint16_t TwimI2cBus::maxDirect(const uint8_t *run) {
+  // EasyDMA only reaches data RAM, MAXCNT is 16 bits on the nRF52840
+  uint32_t start = (uint32_t)run;
+  if (start < 0x20000000 || start >= 0x20040000) {
+    return 0;
+  }
+  return 0x20040000 - start < 0xFFFF ? 0x20040000 - start : 0xFFFF;
+}
+
+bool TwimI2cBus::startDirect(uint8_t address, const uint8_t *run, uint16_t length, uint8_t *readData, uint16_t readLength) {
+  txLength = length;
+  rxLength = readLength;
+  if (!twim || running || (!txLength && !rxLength)) {
+    result = i2cFailed;
+    return false;
+  }
+
+  // borrow the instance from the Wire driver, without its interrupts
+  savedEnable = TWIM->ENABLE;
+  savedInterrupts = TWIM->INTEN;
+  savedFrequency = TWIM->FREQUENCY;
+  TWIM->INTENCLR = 0xFFFFFFFF;
+  TWIM->ENABLE = TWIM_ENABLE_ENABLE_Disabled;
+  TWIM->ENABLE = TWIM_ENABLE_ENABLE_Enabled;
+  TWIM->FREQUENCY = frequency;
+  TWIM->ADDRESS = address;
+  TWIM->EVENTS_STOPPED = 0;
+  TWIM->EVENTS_ERROR = 0;
+  TWIM->ERRORSRC = TWIM->ERRORSRC;  // write 1 to clear
+  TWIM->TXD.PTR = (uint32_t)run;
+  TWIM->TXD.MAXCNT = txLength;
+  TWIM->TXD.LIST = 0;
+  TWIM->RXD.PTR = (uint32_t)readData;
+  TWIM->RXD.MAXCNT = rxLength;
+  TWIM->RXD.LIST = 0;
+  if (!txLength) {
+    TWIM->SHORTS = TWIM_SHORTS_LASTRX_STOP_Msk;
+    TWIM->TASKS_STARTRX = 1;
+  }
+  else if (rxLength) {
+    TWIM->SHORTS = TWIM_SHORTS_LASTTX_STARTRX_Msk | TWIM_SHORTS_LASTRX_STOP_Msk;
+    TWIM->TASKS_STARTTX = 1;
+  }
+  else {
+    TWIM->SHORTS = TWIM_SHORTS_LASTTX_STOP_Msk;
+    TWIM->TASKS_STARTTX = 1;
+  }
+  started = millis();
+  timeout = i2cTimeout + (uint32_t)(txLength + rxLength + 2) * 9 * 1000 / clock;
+  running = true;
+  result = i2cRunning;
+  return true;
+}
+
+uint8_t TwimI2cBus::poll() {
+  if (!running) {
+    return result;
+  }
+  if (TWIM->EVENTS_ERROR) {
+    // NACK or overrun, the shortcuts don't stop the bus on errors
+    TWIM->EVENTS_ERROR = 0;
+    TWIM->TASKS_STOP = 1;
+    result = i2cFailed;
+  }
+  if (!TWIM->EVENTS_STOPPED) {
+    if (millis() - started < timeout) {
+      return i2cRunning;
+    }
+    result = i2cFailed;  // SCL held low or no STOP, disabling aborts the transfer
+  }
+  else if (result == i2cRunning) {
+    result = TWIM->TXD.AMOUNT == txLength && TWIM->RXD.AMOUNT == rxLength ? i2cDone : i2cFailed;
+  }
+  release();
+  return result;
+}
+
+void TwimI2cBus::release() {
+  // back to the Wire driver as it was, with none of our events left to interrupt it
+  TWIM->SHORTS = 0;
+  TWIM->EVENTS_STOPPED = 0;
+  TWIM->EVENTS_ERROR = 0;
+  TWIM->EVENTS_SUSPENDED = 0;
+  TWIM->EVENTS_RXSTARTED = 0;
+  TWIM->EVENTS_TXSTARTED = 0;
+  TWIM->EVENTS_LASTRX = 0;
+  TWIM->EVENTS_LASTTX = 0;
+  TWIM->ERRORSRC = TWIM->ERRORSRC;
+  TWIM->ENABLE = TWIM_ENABLE_ENABLE_Disabled;
+  TWIM->FREQUENCY = savedFrequency;
+  TWIM->ENABLE = savedEnable;
+  TWIM->INTENSET = savedInterrupts;
+  running = false;
+}
+#endif
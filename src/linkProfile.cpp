@@ -0,0 +1,173 @@
+#include "linkProfile.h"
+#include <string.h>
+
+#if defined(NRF52840_XXAA)
+#include <ArduinoBLE.h>
+#include <utility/ATT.h>
+#include <utility/HCI.h>
+#endif
+
+const linkSettings LinkManager::settings[linkProfileCount] = {
+  // interval min/max, latency, timeout
+  { 80, 160, 4, 600 },  // low power: 100-200ms, skip up to 4 events, 6s timeout
+  { 6, 12, 0, 200 }     // low latency: 7.5-15ms, 2s timeout
+};
+
+#if defined(NRF52840_XXAA)
+#define hciLeConnectionUpdate 0x2013
+#define hciLeSetDataLength 0x2022
+#define hciLeSetPhy 0x2032
+
+uint16_t HciLinkControl::handle(const char *address) {
+  // "xx:xx:xx:xx:xx:xx" is printed most significant byte first, the stack keeps it little endian
+  uint8_t bytes[6];
+  for (uint8_t i = 0; i < 6; i++) {
+    char high = address[i * 3];
+    char low = address[i * 3 + 1];
+    uint8_t value = (high <= '9' ? high - '0' : (high | 0x20) - 'a' + 10) << 4;
+    value |= low <= '9' ? low - '0' : (low | 0x20) - 'a' + 10;
+    bytes[5 - i] = value;
+  }
+  // phones mostly use random addresses, try both address types
+  uint16_t handle = ATT.connectionHandle(0x01, bytes);
+  if (handle == linkNoHandle) {
+    handle = ATT.connectionHandle(0x00, bytes);
+  }
+  return handle;
+}
+
+uint8_t HciLinkControl::setParameters(uint16_t handle, const linkSettings &settings) {
+  struct __attribute__((packed)) {
+    uint16_t handle;
+    uint16_t intervalMin;
+    uint16_t intervalMax;
+    uint16_t latency;
+    uint16_t timeout;
+    uint16_t eventLengthMin;
+    uint16_t eventLengthMax;
+  } command = { handle, settings.intervalMin, settings.intervalMax, settings.latency, settings.timeout, 0, 0 };
+  return HCI.sendCommand(hciLeConnectionUpdate, sizeof(command), &command);
+}
+
+uint8_t HciLinkControl::setPhy(uint16_t handle, uint8_t phy) {
+  uint8_t phyBits = phy == linkPhy2M ? 0x02 : 0x01;
+  struct __attribute__((packed)) {
+    uint16_t handle;
+    uint8_t allPhys;
+    uint8_t txPhys;
+    uint8_t rxPhys;
+    uint16_t options;
+  } command = { handle, 0, phyBits, phyBits, 0 };
+  return HCI.sendCommand(hciLeSetPhy, sizeof(command), &command);
+}
+
+uint8_t HciLinkControl::setDataLength(uint16_t handle, uint16_t length) {
+  struct __attribute__((packed)) {
+    uint16_t handle;
+    uint16_t txOctets;
+    uint16_t txTime;
+  } command = { handle, length, (uint16_t)((length + 14) * 8) };  // 1M PHY airtime, the worst case
+  return HCI.sendCommand(hciLeSetDataLength, sizeof(command), &command);
+}
+#endif
+
+LinkManager::linkState *LinkManager::find(const char *address) {
+  for (uint8_t i = 0; i < bleMaxLinks; i++) {
+    if (links[i].used && strcmp(links[i].address, address) == 0) {
+      return &links[i];
+    }
+  }
+  return nullptr;
+}
+
+void LinkManager::connect(const char *address, uint32_t now) {
+  linkState *link = find(address);
+  for (uint8_t i = 0; i < bleMaxLinks && !link; i++) {
+    if (!links[i].used) {
+      link = &links[i];
+    }
+  }
+  if (!link) {
+    return;
+  }
+  *link = linkState();
+  link->used = true;
+  copyAddress(link->address, address);
+  link->handle = control.handle(address);
+  link->steps = linkStepParameters | linkStepPhy | linkStepDataLength;
+  link->lastRequest = now;  // give the central a moment to finish its own setup first
+  newest = link - links;
+}
+
+void LinkManager::disconnect(const char *address) {
+  linkState *link = find(address);
+  if (link) {
+    link->used = false;
+    if (newest == link - links) {
+      newest = -1;
+    }
+  }
+}
+
+void LinkManager::setProfile(uint8_t profile) {
+  if (profile == current || profile >= linkProfileCount) {
+    return;
+  }
+  current = profile;
+  for (uint8_t i = 0; i < bleMaxLinks; i++) {
+    if (links[i].used) {
+      links[i].steps |= linkStepParameters;
+      links[i].parameterStatus = linkNotRequested;
+    }
+  }
+}
+
+bool LinkManager::service(uint32_t now) {
+  for (uint8_t i = 0; i < bleMaxLinks; i++) {
+    linkState &link = links[i];
+    if (!link.used || !link.steps || now - link.lastRequest < requestGap) {
+      continue;
+    }
+    if (link.handle == linkNoHandle) {
+      link.handle = control.handle(link.address);
+      if (link.handle == linkNoHandle) {
+        continue;
+      }
+    }
+    if (link.steps & linkStepParameters) {
+      link.parameterStatus = control.setParameters(link.handle, settings[current]);
+      link.steps &= ~linkStepParameters;
+    }
+    else if (link.steps & linkStepPhy) {
+      link.phyStatus = control.setPhy(link.handle, linkPhy);
+      link.steps &= ~linkStepPhy;
+    }
+    else {
+      link.dataLengthStatus = control.setDataLength(link.handle, linkDataLength);
+      link.steps &= ~linkStepDataLength;
+    }
+    link.lastRequest = now;
+    return true;  // one request per call
+  }
+  return false;
+}
+
+void LinkManager::diagnostics(linkDiagnostics *report) const {
+  const linkSettings &wanted = settings[current];
+  report->version = 1;
+  report->profile = current;
+  report->links = 0;
+  for (uint8_t i = 0; i < bleMaxLinks; i++) {
+    report->links += links[i].used;
+  }
+  report->intervalMin = wanted.intervalMin;
+  report->intervalMax = wanted.intervalMax;
+  report->latency = wanted.latency;
+  report->timeout = wanted.timeout;
+  report->phy = linkPhy;
+  report->dataLength = linkDataLength;
+  const linkState *link = newest >= 0 ? &links[newest] : nullptr;
+  report->parameterStatus = link ? link->parameterStatus : linkNotRequested;
+  report->phyStatus = link ? link->phyStatus : linkNotRequested;
+  report->dataLengthStatus = link ? link->dataLengthStatus : linkNotRequested;
+}
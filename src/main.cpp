@@ -13,6 +13,8 @@
 // Subscribe to the roll (1001) and pitch (1002) sensors ("down/line arrow" buttons).
 // Configure the data as "UTF-8" ("quote" buttons).
 // To zero both axis, send a true boolean (or 1) to the tare service (1003) (up arrow on sensor w/ long uuid), or push the tare button.
+// Taring is instant when the sensor is still (it waits for the reading to settle otherwise), and 1003 notifies 0 when done.
+// The tare is saved to flash and restored at power up.
 // If using a battery for power via the battery pads, subscribe to the battery service (1004) to read battery volts.
 // Roll axis goes into the usb, pitch is across the usb.
 // LEDs indicate status: Blue = BLE connected, Green flash = Data updated, Red flash = Taring
@@ -35,15 +37,43 @@
 #include "LSM6DS3.h"
 #include "Wire.h"
 #include <nrf52840.h>
-#include <nrfx_saadc.h>
-#include <AnalogIn.h>
 #include <pinDefinitions.h>
-#include <avr/dtostrf.h>
-#include <Adafruit_SSD1306.h>
+#include <Adafruit_SSD1306Fixed.h>
+#include <Adafruit_SSD1306Canvas.h>
+#include "settingsStore.h"
+#include "splashScreen.h"
+#include "bigDigitsFont.h"
+#include "angleGauge.h"
+#include "textFormat.h"
+#include "telemetry.h"
+#include "accelFifo.h"
+#include "batteryMonitor.h"
+#include "batteryCharge.h"
+#include "tareEngine.h"
+#include "settleDetector.h"
+#include "throwCapture.h"
+#include "bleLinks.h"
+#include "linkProfile.h"
+#include "commandProtocol.h"
+#include "dfuEngine.h"
+#include "i2cQueue.h"
+#include "busClock.h"
 
-// User configuration
-#define sampleCount 100 // # of samples between readings
-#define tareLEDtime 2000   // msec wait while taring angles (longer than time required to collect sampleCount data points)
+// User configuration (the ones marked * are defaults, they can be changed at runtime through the BLE command characteristic 100A)
+#define sampleCount 100 // * # of samples between readings
+#define readingPeriod 0  // * msec minimum between readings sent to BLE & the OLED (0 = every reading)
+#define readingFilter filterAverage  // * filterAverage (lowest latency) or filterSmooth (readings are also smoothed, lowest noise)
+#define smoothFactor 0.25  // weight of each new reading with filterSmooth
+#define accelOdr 208  // * Hz accelerometer ODR: 13, 26, 52, 104, 208, 416, 833, 1660, 3330, 6660
+#define accelFullScale 2  // * max G force readable: 2, 4, 8, 16
+#define tareTimeout 2000   // msec max wait for a steady reading when taring, then the current average is used
+#define tareTolerance 0.02 // degrees, max uncertainty of the averaged angle for an instant tare
+#define tareFlash 200   // msec minimum tare led flash
+#define settleNoise 0.1  // degrees, max standard deviation of a settled reading
+#define settleTime 300  // msec the angle must hold still to be settled
+//#define displayHold // uncomment to hold the OLED on the last settled reading while the angle is moving
+#define captureFilter 20  // msec time constant of the throw capture noise filter (0 = none)
+//#define displayThrow // uncomment to alternate the OLED bluetooth line with the captured throw
 #define dataFlash 50   // msec to flash when data is sent
 #define chargeCurrent LOW // Built in battery charger: HIGH = 50mA, LOW = 100mA
 #define ledColorData LED_GREEN  // LED indicator colors, choose one each (LED_GREEN, LED_RED, LED_BLUE)
@@ -52,13 +82,60 @@
 #define tareButtonPin 11  // Pin connected to tare button (11 is IO, 10 is MOSI :P)
 //#define oledFormatBig // uncomment for a larger degree display on the OLED (nice for single color screens, not so great with Y/B screens)
 #define displayAlternatePeriod 2500 // msec to alternate between info when using oledFormatBig
+//#define oledFormatGauge // uncomment for a graphical OLED display: roll dial, pitch bar and a scrolling history of both angles (replaces oledFormatBig)
+#define telemetryLevel telemetryData // USB serial output: telemetryOff, telemetryInfo (status only), telemetryData (status + readings)
+#define telemetryPeriod 0 // msec minimum between serial readings (0 = every update)
+//#define telemetryBinary // uncomment to send readings as COBS framed binary structs (telemetryDataFrame) instead of text
+//#define usbStream telemetryFrameRaw // * uncomment to stream every IMU sample over USB: telemetryFrameRaw (accel counts) or telemetryFrameAngles (tared roll/pitch), decode with tools/streamDecode.py
+#define streamSampleRate 1660 // Hz accelerometer ODR when usbStream is on at boot (13 - 6660)
+#define imuWarmupTime 20  // msec to discard accelerometer data after power up
+#define imuBusProfile busClockFast  // IMU I2C clock: busClockStandard (100kHz), busClockFast (400kHz), busClockFastPlus (1MHz, runs at 400kHz on the nRF52840)
+#define oledBusProfile busClockFast  // OLED I2C clock, steps down by itself if the harness gives errors
+#define settingsFlashBase 0xEC000 // 2 flash pages (8kB) for saved settings, must stay clear of the sketch and the bootloader
+#define dfuAppBase 0x27000  // start of the sketch in flash (mbed Xiao boards), where BLE updates are installed
+#define dfuSlotBase 0x89000  // flash slot BLE updates are received into, up to the settings pages
+#define dfuSlotSize 0x62000  // max image size (392kB), the sketch must also fit below dfuSlotBase
+
+static_assert(dfuAppBase < dfuSlotBase && dfuSlotBase + dfuSlotSize <= settingsFlashBase, "the update slot must sit between the sketch and the settings pages");
+static_assert(dfuSlotBase % 4096 == 0 && dfuSlotSize % 4096 == 0, "the update slot must be whole flash pages");
+static_assert(dfuSlotSize <= dfuSlotBase - dfuAppBase, "an image that fills the slot must also fit where it is installed");
 
 // END User configuration
 
+#define streamMaxBatch 13  // samples per stream frame, angles, also the size of the readData() batch
+#define streamRawBatch 9  // samples per stream frame, raw counts
+#define streamMaxValues (streamMaxBatch * 2 > streamRawBatch * 3 ? streamMaxBatch * 2 : streamRawBatch * 3)  // int16 values in the largest frame
+#define readBatch (accelFifoBurst * 2) // samples per FIFO read pass when not streaming
+static_assert(sizeof(telemetrySamplesHeader) + streamMaxBatch * 4 <= telemetryMaxFrame, "angle stream frames must fit telemetryMaxFrame");
+static_assert(sizeof(telemetrySamplesHeader) + streamRawBatch * 6 <= telemetryMaxFrame, "raw stream frames must fit telemetryMaxFrame");
+static_assert(streamRawBatch <= streamMaxBatch && readBatch <= streamMaxBatch, "readData() reads at most streamMaxBatch samples per pass");
+
 #define chargePin P0_13
 #define batteryReadPin P0_14
 #define batteryAnalogPin P0_31
+#define batteryAin 7  // SAADC input of batteryAnalogPin (P0.31 = AIN7)
+#define batteryPeriod 1000  // msec between battery readings (taken in the background)
+#define loadBaseCurrent 6  // mA estimated battery load for charge estimates: board, IMU and BLE
+#define loadOledCurrent 10  // extra mA with an OLED
+#define loadConnectedCurrent 1  // extra mA per connected central
+#define blePacketsPerLoop 8  // max notifications sent per loop, the rest of a reading goes out on the next loops
+#define bleRefreshPeriod 5000  // msec between updates of characteristics nobody is subscribed to (for plain reads)
+#define bleTextValues // UTF-8 string characteristics (1001, 1002, 1004, 1006, 1007) for NRF Connect & older apps, comment out to only send the binary ones
+//#define bleLinkProfile linkProfileLowLatency // uncomment to fix the BLE link profile (linkProfileLowPower or linkProfileLowLatency), automatic otherwise
 LSM6DS3 myIMU(I2C_MODE, 0x6A);    //I2C device address 0x6A
+AccelFifo accelFifo(myIMU);  // samples are queued by the IMU and read in bursts
+TareEngine tareEngine;  // sliding window tare
+SettleDetector settleDetector;  // settled reading flag
+ThrowCapture throwCapture;  // min/max of every sample, for surface throw
+BatteryMonitor batteryMonitor;  // SAADC battery readings, timer triggered
+BatteryCharge batteryCharge;  // state of charge & time remaining
+NvmcFlash settingsFlash;  // internal flash storage for tare & settings
+SettingsStore settings(settingsFlash, settingsFlashBase, 4096);
+// End of the running sketch in flash, from the mbed core's linker script: code and
+// constants end at __etext, followed by the initial values of .data
+extern "C" uint32_t __etext, __data_start__, __data_end__;
+#define sketchEnd ((uint32_t)&__etext + ((uint32_t)&__data_end__ - (uint32_t)&__data_start__))
+DfuEngine dfu(settingsFlash, dfuSlotBase, dfuSlotSize, 4096, dfuAppBase, sketchEnd);  // BLE firmware updates
 
 // Characteristic UUID's
 #define BLE_UUID_ANGLE_MONITOR_SERVICE "8acafa20-26e9-4d16-a792-cf7de147c01c"  // v4 random uuid
@@ -66,41 +143,151 @@ LSM6DS3 myIMU(I2C_MODE, 0x6A);    //I2C device address 0x6A
 #define BLE_UUID_PITCH_DEGREES  "1002"
 #define BLE_UUID_TARE_SWITCH  "1003"
 #define BLE_UUID_BATTERY_VOLTS  "1004"
+#define BLE_UUID_SETTLED  "1005"
+#define BLE_UUID_ROLL_THROW  "1006"
+#define BLE_UUID_PITCH_THROW  "1007"
+#define BLE_UUID_THROW_RESET  "1008"
+#define BLE_UUID_LINK_DIAGNOSTICS  "1009"
+#define BLE_UUID_ROLL_BINARY  "1011"  // binary versions of 1001 - 1007, with presentation format descriptors
+#define BLE_UUID_PITCH_BINARY  "1012"
+#define BLE_UUID_BATTERY_VOLTS_BINARY  "1014"
+#define BLE_UUID_ROLL_THROW_BINARY  "1016"
+#define BLE_UUID_PITCH_THROW_BINARY  "1017"
+#define BLE_UUID_COMMAND  "100A"
+#define BLE_UUID_DFU_CONTROL  "100B"
+#define BLE_UUID_DFU_DATA  "100C"
 //#define BLE_UUID_BATTERY_VOLTS  "5726c19a-8a75-5d7a-845d-aadf6734d7e7"  // V5 uuid's
 //#define BLE_UUID_ROLL_DEGREES  "a68e1ad6-8c88-56f4-b9d5-792af19cfb19"
 //#define BLE_UUID_PITCH_DEGREES  "d9bc177b-1fbe-5724-867a-558e397f2401"
 //#define BLE_UUID_TARE_SWITCH  "f7a73029-a679-5de1-8448-ba3d23450f75"
 
-// Bluetooth® Low Energy Battery Service
+// Bluetooth® Low Energy Angle Monitor Service
 BLEService angleMonitorService(BLE_UUID_ANGLE_MONITOR_SERVICE);
+// Standard Battery Service, shown by most phones and BLE tools without any setup
+BLEService batteryService("180F");
+BLEUnsignedCharCharacteristic batteryLevel("2A19", BLERead | BLENotify); // percent
 
 // Bluetooth® Low Energy Characteristics & Descriptors
 BLEStringCharacteristic batteryVolts(BLE_UUID_BATTERY_VOLTS, BLERead | BLENotify, 20);
 BLEStringCharacteristic rollDegrees(BLE_UUID_ROLL_DEGREES, BLERead | BLENotify, 20);
 BLEStringCharacteristic pitchDegrees(BLE_UUID_PITCH_DEGREES, BLERead | BLENotify, 20);
-BLEByteCharacteristic tareChar(BLE_UUID_TARE_SWITCH, BLERead | BLEWrite);
+BLEByteCharacteristic tareChar(BLE_UUID_TARE_SWITCH, BLERead | BLEWrite | BLENotify);  // notifies 0 when a tare is done
+BLEByteCharacteristic settledChar(BLE_UUID_SETTLED, BLERead | BLENotify);  // 1 while the angles hold still
+BLEStringCharacteristic rollThrow(BLE_UUID_ROLL_THROW, BLERead | BLENotify, 20);  // max - min since the last reset
+BLEStringCharacteristic pitchThrow(BLE_UUID_PITCH_THROW, BLERead | BLENotify, 20);
+BLEByteCharacteristic throwResetChar(BLE_UUID_THROW_RESET, BLERead | BLEWrite);  // write 1 to restart the capture
+BLECharacteristic linkDiagnosticsChar(BLE_UUID_LINK_DIAGNOSTICS, BLERead | BLENotify, sizeof(linkDiagnostics));  // link profile & request status
+BLECharacteristic commandChar(BLE_UUID_COMMAND, BLEWrite | BLEWriteWithoutResponse | BLENotify, commandMaxLength);  // see include/commandProtocol.h
+BLECharacteristic dfuControlChar(BLE_UUID_DFU_CONTROL, BLEWrite | BLENotify, sizeof(dfuResponse));  // firmware update, see include/dfuEngine.h
+BLECharacteristic dfuDataChar(BLE_UUID_DFU_DATA, BLEWriteWithoutResponse, dfuMaxChunk + 4);
+BLEShortCharacteristic rollBinary(BLE_UUID_ROLL_BINARY, BLERead | BLENotify);  // 0.01 degrees
+BLEShortCharacteristic pitchBinary(BLE_UUID_PITCH_BINARY, BLERead | BLENotify);
+BLEUnsignedShortCharacteristic batteryVoltsBinary(BLE_UUID_BATTERY_VOLTS_BINARY, BLERead | BLENotify);  // mV
+BLEUnsignedShortCharacteristic rollThrowBinary(BLE_UUID_ROLL_THROW_BINARY, BLERead | BLENotify);  // 0.01 degrees
+BLEUnsignedShortCharacteristic pitchThrowBinary(BLE_UUID_PITCH_THROW_BINARY, BLERead | BLENotify);
 
 // BLE Descriptors (not read by NRF connect app unfortunately, but here in case some app does)
 BLEDescriptor pitchDegreesDescriptor("2901", "Pitch Degrees");
 BLEDescriptor rollDegreesDescriptor("2901", "Roll Degrees");
 BLEDescriptor batteryVoltsDescriptor("2901", "Batt Volts");
 BLEDescriptor tareCharDescriptor("2901", "Tare");
+BLEDescriptor settledCharDescriptor("2901", "Settled");
+BLEDescriptor rollThrowDescriptor("2901", "Roll Throw");
+BLEDescriptor pitchThrowDescriptor("2901", "Pitch Throw");
+BLEDescriptor throwResetDescriptor("2901", "Throw Reset");
+BLEDescriptor linkDiagnosticsDescriptor("2901", "Link Diagnostics");
+BLEDescriptor commandDescriptor("2901", "Command");
+BLEDescriptor dfuControlDescriptor("2901", "Firmware Update");
+BLEDescriptor dfuDataDescriptor("2901", "Firmware Data");
+BLEDescriptor rollBinaryDescriptor("2901", "Roll");
+BLEDescriptor pitchBinaryDescriptor("2901", "Pitch");
+BLEDescriptor batteryVoltsBinaryDescriptor("2901", "Battery");
+BLEDescriptor rollThrowBinaryDescriptor("2901", "Roll Throw");
+BLEDescriptor pitchThrowBinaryDescriptor("2901", "Pitch Throw");
+
+// Characteristic Presentation Format (2904): format, exponent, unit (little endian), namespace, description
+// so generic BLE tools can scale and label the binary values without knowing this device
+const uint8_t angleFormat[7] = { 0x0E, 0xFE, 0x63, 0x27, 0x01, 0x00, 0x00 };  // sint16, 10^-2, degree (2763)
+const uint8_t throwFormat[7] = { 0x06, 0xFE, 0x63, 0x27, 0x01, 0x00, 0x00 };  // uint16, 10^-2, degree
+const uint8_t voltsFormat[7] = { 0x06, 0xFD, 0x28, 0x27, 0x01, 0x00, 0x00 };  // uint16, 10^-3, volt (2728)
+BLEDescriptor rollFormatDescriptor("2904", angleFormat, sizeof(angleFormat));
+BLEDescriptor pitchFormatDescriptor("2904", angleFormat, sizeof(angleFormat));
+BLEDescriptor batteryVoltsFormatDescriptor("2904", voltsFormat, sizeof(voltsFormat));
+BLEDescriptor rollThrowFormatDescriptor("2904", throwFormat, sizeof(throwFormat));
+BLEDescriptor pitchThrowFormatDescriptor("2904", throwFormat, sizeof(throwFormat));
+
+// Characteristics written with every reading, scheduled by bleLinks (bit per channel)
+enum bleChannels : uint8_t {
+  bleChannelRoll,
+  bleChannelPitch,
+  bleChannelBatteryVolts,
+  bleChannelRollThrow,
+  bleChannelPitchThrow,
+  bleChannelBatteryLevel,
+  bleChannelRollBinary,
+  bleChannelPitchBinary,
+  bleChannelBatteryVoltsBinary,
+  bleChannelRollThrowBinary,
+  bleChannelPitchThrowBinary,
+  bleChannelCount
+};
+BLECharacteristic *bleChannel[bleChannelCount] = { &rollDegrees, &pitchDegrees, &batteryVolts, &rollThrow, &pitchThrow, &batteryLevel,
+                                                   &rollBinary, &pitchBinary, &batteryVoltsBinary, &rollThrowBinary, &pitchThrowBinary };
+#define bleTextChannels ((1 << bleChannelRoll) | (1 << bleChannelPitch) | (1 << bleChannelBatteryVolts) \
+                       | (1 << bleChannelRollThrow) | (1 << bleChannelPitchThrow))
+#define bleBinaryChannels ((1 << bleChannelRollBinary) | (1 << bleChannelPitchBinary) | (1 << bleChannelBatteryVoltsBinary) \
+                         | (1 << bleChannelRollThrowBinary) | (1 << bleChannelPitchThrowBinary))
+BleLinks bleLinks;  // connected centrals & notification scheduler
+HciLinkControl linkControl;  // connection parameter, PHY & DLE requests
+LinkManager linkManager(linkControl);  // link profile per connection
+#if blePacketsPerLoop < bleMaxLinks
+  #error "blePacketsPerLoop must cover one notification to every link"
+#endif
 
 // SSD1306 OLED display parameters
 #define SCREEN_WIDTH 128
 #define SCREEN_HEIGHT 64
 #define OLED_RESET    -1
+#define oledAddress 0x3C  // 0x3C is common I2C address
 
 // I²C pins used by the SSD1306
 // Xiao nRF52840 Sense: pin 4 and pin 5
-Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET);
+// Geometry fixed at compile time: static framebuffer, constant-folded drawing
+Adafruit_SSD1306Fixed<SCREEN_WIDTH, SCREEN_HEIGHT> display(&Wire, OLED_RESET, busClockRate(oledBusProfile), busClockRate(oledBusProfile));
+// Corner status icons, drawn once in startOLED() and blitted into every frame
+#define oledIconX 122  // left edge, panel coordinates
+Adafruit_SSD1306Canvas settledIcon(6, 8);  // filled dot
+Adafruit_SSD1306Canvas movingIcon(6, 8);   // ring
+Adafruit_SSD1306Canvas holdIcon(6, 8);     // H
+#ifdef oledFormatGauge
+  AngleGauge gauge;  // angle history and sparkline, kept between frames
+#endif
+// Frames go out in the background after boot, the loop keeps reading the IMU meanwhile
+TwimI2cBus oledTwim;  // EasyDMA
+WireI2cBus oledWire(Wire);  // fallback, one Wire buffer per loop
+I2cQueue oledQueue(oledTwim);
+const uint8_t oledWindow[6] = { SSD1306_PAGEADDR, 0, 0xFF, SSD1306_COLUMNADDR, 0, SCREEN_WIDTH - 1 };  // whole screen
+i2cTransaction oledAddressing;  // commands, then the framebuffer
+i2cTransaction oledFrame;
+uint32_t oledErrors = 0;  // frames that failed to send
+BusClock oledBus(oledBusProfile);  // clock fallback on errors
+BusClock imuBus(imuBusProfile);
 
 float battery = 0.0;  // battery voltage
-char batteryBuffer[20]; // printable byte array
+char batteryBuffer[formatBufferSize]; // printable byte array
 float roll = 0;  // roll angle
-char rollBuffer[20]; // printable byte array
+char rollBuffer[formatBufferSize]; // printable byte array
 float pitch = 0;  // pitch angle
-char pitchBuffer[20]; // printable byte array
+char pitchBuffer[formatBufferSize]; // printable byte array
+char heldRollBuffer[formatBufferSize]; // last settled readings, for displayHold
+char heldPitchBuffer[formatBufferSize];
+float heldRoll = 0;
+float heldPitch = 0;
+char batteryLine[22]; // OLED battery line, volts, charge and time remaining
+char throwLine[22]; // OLED throw line
+uint8_t batteryLength = 0;  // printable lengths
+uint8_t rollLength = 0;
+uint8_t pitchLength = 0;
 float rollRaw = 0.0;  // raw calculated roll
 float pitchRaw = 0.0;  // raw calculated pitch
 float accX = 0.0; // accelerator sums
@@ -112,93 +299,168 @@ long currentMillis = 0; // global timer
 long previousData = 0;  // msec since data was sent
 long previousTare = 0;  // msec timer for data led flash
 long previousDisplay = 0;  // msec timer for data led flash
+long previousRefresh = 0;  // msec timer for unsubscribed BLE characteristics
+long previousOutput = 0;  // msec timer for readingPeriod
+bool smoothFlag = 0;  // filterSmooth has a previous reading
+float smoothX = 0.0;  // filterSmooth state, averaged acceleration
+float smoothY = 0.0;
+float smoothZ = 0.0;
+// Runtime settings, defaults from the user configuration, then flash, then BLE commands
+commandConfig runtimeConfig = {
+  sampleCount, readingPeriod, readingFilter,
+  #ifdef usbStream
+    streamSampleRate, accelFullScale, usbStream,
+  #else
+    accelOdr, accelFullScale, 0,
+  #endif
+  captureOn
+};
 u_int8_t displayIndex = 0; // display index for alternating displays
 bool dataLedFlag = 0;  // flag for data led flash
-bool tareFlag = 0;  // flag for tare routine
 bool tareLedFlag = 0; // flag for tare led timer
-bool centralFlag = 0; // flag if BLE is connected
-String centralAddress = "0"; // array to store MAC address of connected BLE device
-u_int8_t samples = 0;  // sample count storage
-
-#define SPLASH_HEIGHT   64
-#define SPLAST_WIDTH    128
-
-static const unsigned char splashScreen[] = { // Size 128x64 pixels
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xc0, 0x00, 0x00, 0x1f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xc0, 0x00, 0x00, 0x1f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xe0, 0x13, 0xf8, 0x1f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xe7, 0x93, 0xf1, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xe7, 0x93, 0xf3, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xe4, 0x13, 0xf2, 0x1f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xe4, 0x13, 0xf2, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xe7, 0x93, 0xf1, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xe0, 0x10, 0x38, 0x1f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xe0, 0x30, 0x1c, 0x1f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xc0, 0x00, 0x00, 0x0f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xe0, 0x00, 0x00, 0x1f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-    0xff, 0xfc, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff,
-    0xff, 0xfc, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff,
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-    0xff, 0xfc, 0xe0, 0xf8, 0x27, 0xce, 0x0f, 0x03, 0xc0, 0x0e, 0x04, 0x03, 0x02, 0x01, 0xff, 0xff,
-    0xff, 0xfc, 0xc4, 0x71, 0xe7, 0xcc, 0x46, 0x31, 0x98, 0xcc, 0x7f, 0x1e, 0x3e, 0x31, 0xff, 0xff,
-    0xff, 0xfc, 0x9f, 0x27, 0xe7, 0xc9, 0xf2, 0x79, 0x98, 0xcc, 0xff, 0x9e, 0x7e, 0x78, 0xff, 0xff,
-    0xff, 0xfc, 0x9f, 0x27, 0xe7, 0xc9, 0xf2, 0x79, 0xbd, 0xed, 0x8f, 0x9e, 0x42, 0x61, 0xff, 0xff,
-    0xff, 0xfc, 0x9f, 0x27, 0xe7, 0xc9, 0xf2, 0x79, 0x99, 0xec, 0x8f, 0x9e, 0x46, 0x41, 0xff, 0xff,
-    0xff, 0xfc, 0x9f, 0x23, 0xe7, 0xc9, 0xf2, 0x39, 0x99, 0xec, 0xff, 0x9e, 0x3e, 0x71, 0xff, 0xff,
-    0xff, 0xfc, 0x9f, 0x30, 0x20, 0x49, 0xf3, 0x03, 0x18, 0xc6, 0x07, 0x9f, 0x02, 0x78, 0xff, 0xff,
-    0xff, 0xfc, 0x9f, 0x38, 0x20, 0x49, 0xf3, 0x87, 0xbd, 0xef, 0x07, 0x9f, 0x82, 0x7c, 0xff, 0xff,
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-    0xff, 0xfc, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff,
-    0xff, 0xfc, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff,
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-    0xff, 0xff, 0xff, 0xc0, 0x60, 0x1b, 0xfe, 0x01, 0xbf, 0xe0, 0x18, 0x07, 0xc0, 0x30, 0x1f, 0xff,
-    0xff, 0xef, 0xff, 0x80, 0x20, 0x1b, 0xf6, 0x01, 0xbf, 0xc0, 0x18, 0x02, 0x00, 0x20, 0x1f, 0xff,
-    0xff, 0xef, 0xff, 0xf3, 0xe7, 0x9b, 0xf6, 0x7f, 0xbf, 0xcf, 0xd9, 0xf2, 0x79, 0xe7, 0xff, 0xff,
-    0xff, 0xe3, 0x67, 0xfb, 0xe0, 0x1b, 0xf6, 0x7f, 0xbf, 0xcf, 0xdb, 0xfa, 0x7b, 0xe7, 0xff, 0xff,
-    0xff, 0xe9, 0x6f, 0xfb, 0xe0, 0x1b, 0xf6, 0xc1, 0xbf, 0xcf, 0xdb, 0xfa, 0x7b, 0xe0, 0x1f, 0xff,
-    0xff, 0xed, 0xaf, 0xfb, 0xe1, 0xfb, 0xf6, 0xc1, 0xbf, 0xcf, 0xdb, 0xf2, 0x7b, 0xe0, 0x1f, 0xff,
-    0xff, 0xed, 0x9f, 0xfb, 0xe0, 0x78, 0x06, 0x01, 0x80, 0x40, 0x18, 0x06, 0x7b, 0xe0, 0x1f, 0xff,
-    0xff, 0xe1, 0x9f, 0xfb, 0xef, 0x18, 0x06, 0x01, 0x80, 0x40, 0x18, 0x0e, 0x7b, 0xe0, 0x1f, 0xff,
-    0xff, 0xff, 0xdf, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-    0xff, 0xff, 0xbf, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff
+bool tareButtonFlag = 0; // flag for tare button held
+bool oledFlag = 0; // flag if the OLED was found
+bool settledFlag = 0; // flag if the angles are settled
+bool holdFlag = 0; // flag to hold the display on the last settled reading
+bool dfuRewindFlag = 0; // flag if the firmware sender was already told to rewind
+bool dfuStartFlag = 0; // flag if a dfuStart is waiting for the slot to be erased
+uint16_t samples = 0;  // sample count storage
+uint8_t telemetrySequence = 0; // binary telemetry frame counter
+uint32_t sampleIndex = 0; // IMU samples read since boot
+long imuReadyMillis = 0;  // msec when the accelerometer has settled after power up (0 once running)
+long bootAdvertiseMillis = 0;  // boot timeline, msec since reset
+long bootFirstAngleMillis = 0;
+
+// Startup stages run by startupTask()
+enum bootStages : u_int8_t {
+  bootIMU,  // first, so the accelerometer warms up while everything else starts
+  bootBLE,  // start advertising
+  bootOLED, // splash screen shows while the first averaging window fills
+  bootDone
 };
+u_int8_t bootState = bootIMU;
+
+void sampleAngles(const accelSample &sample, float *sampleRoll, float *samplePitch) {
+  // Tared angles of a single IMU sample
+  float y = sample.y;
+  float z = sample.z;
+  *sampleRoll = atan2(y, z) * 57.2958 - tareRoll;
+  *samplePitch = atan2(-sample.x, sqrt(y * y + z * z)) * 57.2958 - tarePitch;
+}
+
+uint8_t streamBatch() {
+  // samples per FIFO read pass, a whole stream frame when streaming
+  if (runtimeConfig.stream == telemetryFrameRaw) {
+    return streamRawBatch;
+  }
+  if (runtimeConfig.stream == telemetryFrameAngles) {
+    return streamMaxBatch;
+  }
+  return readBatch;
+}
+
+void streamSamples(const accelSample *batch, uint8_t count) {
+  // Sends a run of samples over USB as one frame, dropped (never waited on) if the PC falls behind
+  int16_t values[streamMaxValues];
+  for (uint8_t i = 0; i < count; i++) {
+    if (runtimeConfig.stream == telemetryFrameRaw) {
+      values[i * 3] = batch[i].x;
+      values[i * 3 + 1] = batch[i].y;
+      values[i * 3 + 2] = batch[i].z;
+    }
+    else {
+      float sampleRoll, samplePitch;
+      sampleAngles(batch[i], &sampleRoll, &samplePitch);
+      values[i * 2] = sampleRoll * 100;
+      values[i * 2 + 1] = samplePitch * 100;
+    }
+  }
+  uint8_t valuesSize = count * (runtimeConfig.stream == telemetryFrameRaw ? 6 : 4);
+  uint8_t frame[telemetryMaxFrame];
+  telemetrySamplesHeader header = { runtimeConfig.stream, count, sampleIndex };
+  memcpy(frame, &header, sizeof(header));
+  memcpy(&frame[sizeof(header)], values, valuesSize);
+  telemetry.sendFrame(frame, sizeof(header) + valuesSize);
+}
 
 void readData()  {
-  // Reads samples from the IMU and analog sensor, calculates the voltage and angles, and adds values to averaging sums
-  int batteryADC = analogRead(batteryAnalogPin); // read battery adc
-  battery += float(batteryADC); // calc actual battery volts w/ 3v3 reg and 10bit adc
+  // Reads samples from the IMU FIFO and adds values to averaging sums
+  // Drain the FIFO up to the end of the averaging window, a burst at a time
+  accelSample batch[streamMaxBatch];
+  uint8_t batchSize = streamBatch();
+  uint8_t count;
+  do {
+    uint8_t wanted = runtimeConfig.window - samples < batchSize ? runtimeConfig.window - samples : batchSize;
+    count = accelFifo.read(batch, wanted);
+    for (uint8_t i = 0; i < count; i++) {
+      float sampleRoll, samplePitch;
+      sampleAngles(batch[i], &sampleRoll, &samplePitch);
+      settleDetector.add(sampleRoll, samplePitch);
+      if (runtimeConfig.capture == captureOn) {
+        throwCapture.add(sampleRoll, samplePitch);
+      }
+      tareEngine.addSample(batch[i]);
+      accX += myIMU.calcAccel(batch[i].x);
+      accY += myIMU.calcAccel(batch[i].y);
+      accZ += myIMU.calcAccel(batch[i].z);
+    }
+    if (count && runtimeConfig.stream) {
+      streamSamples(batch, count);
+    }
+    samples += count;
+    sampleIndex += count;
+  } while (count == batchSize && samples < runtimeConfig.window);
+}
+
+uint16_t loadCurrent() {
+  // Estimated battery load in mA, for the state of charge voltage sag correction
+  uint16_t load = loadBaseCurrent;
+  if (oledFlag) {
+    load += loadOledCurrent;
+  }
+  load += bleLinks.count() * loadConnectedCurrent;
+  return load;
+}
+
+void formatBatteryLine() {
+  // "Bat: 3.91V  85% 2h15" (21 characters, one OLED line), time is "--" until the discharge rate is known
+  uint8_t length = 0;
+  memcpy(batteryLine, "Bat: ", 5);
+  length += 5;
+  memcpy(&batteryLine[length], batteryBuffer, batteryLength);
+  length += batteryLength;
+  batteryLine[length++] = 'V';
+  length += formatFixed(&batteryLine[length], sizeof(batteryLine) - length, batteryCharge.percent(), 4, 0);
+  batteryLine[length++] = '%';
+  batteryLine[length++] = ' ';
+  uint16_t minutes = batteryCharge.minutesRemaining();
+  if (minutes == batteryUnknownTime) {
+    batteryLine[length++] = '-';
+    batteryLine[length++] = '-';
+  }
+  else if (minutes >= 100 * 60) {
+    memcpy(&batteryLine[length], ">99h", 4);
+    length += 4;
+  }
+  else {
+    length += formatFixed(&batteryLine[length], sizeof(batteryLine) - length, minutes / 60, 0, 0);
+    batteryLine[length++] = 'h';
+    batteryLine[length++] = '0' + minutes % 60 / 10;
+    batteryLine[length++] = '0' + minutes % 10;
+  }
+  batteryLine[length] = 0;
+}
 
-  // Read angle between X and Z accelerometer axis
-  accX += myIMU.readFloatAccelX();
-  accY += myIMU.readFloatAccelY();
-  accZ += myIMU.readFloatAccelZ();
+void formatThrowLine() {
+  // "Throw R 180.0 P  45.5" (21 characters, one OLED line)
+  uint8_t length = 0;
+  memcpy(throwLine, "Throw R", 7);
+  length += 7;
+  length += formatFixed(&throwLine[length], sizeof(throwLine) - length, throwCapture.roll().span(), 6, 1);
+  memcpy(&throwLine[length], " P", 2);
+  length += 2;
+  length += formatFixed(&throwLine[length], sizeof(throwLine) - length, throwCapture.pitch().span(), 6, 1);
+  throwLine[length] = 0;
 }
 
 void updateDataBuffers() {
@@ -207,183 +469,599 @@ void updateDataBuffers() {
   accX = accX / samples;
   accY = accY / samples;
   accZ = accZ / samples;
+  if (runtimeConfig.filter == filterSmooth) {
+    // smooth the acceleration vector rather than the angles, so +-180 roll doesn't wrap
+    if (smoothFlag) {
+      accX = smoothX + (accX - smoothX) * smoothFactor;
+      accY = smoothY + (accY - smoothY) * smoothFactor;
+      accZ = smoothZ + (accZ - smoothZ) * smoothFactor;
+    }
+    smoothX = accX;
+    smoothY = accY;
+    smoothZ = accZ;
+    smoothFlag = 1;
+  }
+  else {
+    smoothFlag = 0;
+  }
   rollRaw = atan2(accY, accZ) * 57.2958;
   pitchRaw = atan2(-accX, sqrt(accY * accY + accZ * accZ)) * 57.2958;
   roll = ( rollRaw ) - tareRoll;
   pitch = ( pitchRaw ) - tarePitch;
-  // Calculate averaged battery voltage
-  battery = battery / samples;
-  battery = (battery * 3.3) / 1024 * 1510.0 / 510.0; // calc actual battery volts w/ 3v3 reg and 10bit adc
+  // Latest filtered battery voltage (measured in the background)
+  battery = batteryMonitor.millivolts() / 1000.0;
+  if (batteryMonitor.ready()) {
+    batteryCharge.update(currentMillis, batteryMonitor.millivolts(), loadCurrent());
+  }
 
   // Stringify float angles to 1 decimal place
-  dtostrf(roll, 5, 1, rollBuffer);
-  dtostrf(pitch, 5, 1, pitchBuffer);
+  rollLength = formatFixed(rollBuffer, roll, 5, 1);
+  pitchLength = formatFixed(pitchBuffer, pitch, 5, 1);
   // Stringify float voltage to 2 decimal places
-  dtostrf(battery, 4, 2, batteryBuffer);
+  batteryLength = formatFixed(batteryBuffer, battery, 4, 2);
+  formatBatteryLine();
+  // Captured throw (max - min of the filtered samples)
+  formatThrowLine();
+  // Keep the settled reading for displayHold
+  if (settledFlag) {
+    heldRoll = settleDetector.roll();
+    heldPitch = settleDetector.pitch();
+    formatFixed(heldRollBuffer, heldRoll, 5, 1);
+    formatFixed(heldPitchBuffer, heldPitch, 5, 1);
+  }
 
-  // Print debug
-  Serial.print("Roll/Pitch/Battery: ");
-  Serial.print(rollBuffer);
-  Serial.print(", ");
-  Serial.print(pitchBuffer);
-  Serial.print(", ");
-  Serial.println(batteryBuffer);
+  // Print debug, rate limited and queued so a slow USB host can't hold up sampling
+  if (telemetry.dataDue(currentMillis)) {
+    if (telemetry.binary) {
+      telemetryDataFrame frame = { telemetryFrameData, telemetrySequence++, (uint32_t)currentMillis, roll, pitch, battery };
+      telemetry.sendFrame(&frame, sizeof(frame));
+    }
+    else {
+      telemetry.print("Roll/Pitch/Battery: ");
+      telemetry.print(rollBuffer);
+      telemetry.print(", ");
+      telemetry.print(pitchBuffer);
+      telemetry.print(", ");
+      telemetry.println(batteryBuffer);
+    }
+  }
 
   // rezero values
   samples = 0.0;
   accX = 0.0;
   accY = 0.0;
   accZ = 0.0;
-  battery = 0.0;
+}
+
+void writeText(BLECharacteristic &characteristic, const char *text, uint8_t length) {
+  // BLEStringCharacteristic::writeValue() wants a String, write the bytes directly to keep the heap out of it
+  characteristic.writeValue((const uint8_t *)text, length);
+}
+
+void writeChannel(uint8_t channel) {
+  // Writes the value of one channel, the stack notifies every subscribed central
+  // values only BLE uses are formatted here, so channels nobody listens to cost nothing
+  char text[formatBufferSize];
+  switch (channel) {
+    case bleChannelRoll:
+      writeText(rollDegrees, rollBuffer, rollLength);
+      break;
+    case bleChannelPitch:
+      writeText(pitchDegrees, pitchBuffer, pitchLength);
+      break;
+    case bleChannelBatteryVolts:
+      writeText(batteryVolts, batteryBuffer, batteryLength);
+      break;
+    case bleChannelRollThrow:
+      writeText(rollThrow, text, formatFixed(text, throwCapture.roll().span(), 5, 1));
+      break;
+    case bleChannelPitchThrow:
+      writeText(pitchThrow, text, formatFixed(text, throwCapture.pitch().span(), 5, 1));
+      break;
+    case bleChannelBatteryLevel:
+      batteryLevel.writeValue(batteryCharge.percent());
+      break;
+    // binary values are scaled integers, see the 2904 descriptors
+    case bleChannelRollBinary:
+      rollBinary.writeValue((int16_t)lroundf(roll * 100));
+      break;
+    case bleChannelPitchBinary:
+      pitchBinary.writeValue((int16_t)lroundf(pitch * 100));
+      break;
+    case bleChannelBatteryVoltsBinary:
+      batteryVoltsBinary.writeValue((uint16_t)batteryMonitor.millivolts());
+      break;
+    case bleChannelRollThrowBinary:
+      rollThrowBinary.writeValue((uint16_t)lroundf(throwCapture.roll().span() * 100));
+      break;
+    case bleChannelPitchThrowBinary:
+      pitchThrowBinary.writeValue((uint16_t)lroundf(throwCapture.pitch().span() * 100));
+      break;
+  }
+}
+
+uint16_t bleNotifying() {
+  // Channels whose characteristic has notifications on, the CCCDs are shared by every central
+  return bleSubscribedChannels(bleChannel, bleChannelCount);
+}
+
+uint16_t bleAllChannels() {
+  uint16_t channels = bleBinaryChannels;
+  #ifdef bleTextValues
+    channels |= bleTextChannels;
+  #endif
+  return channels | 1 << bleChannelBatteryLevel;
 }
 
 void sendBLE() {
-  // Sends data buffers to BLE
-  rollDegrees.writeValue(rollBuffer);
-  pitchDegrees.writeValue(pitchBuffer);
-  batteryVolts.writeValue(batteryBuffer);
+  // Queues the new reading for the subscribed characteristics, serviceBLE() writes them out
+  // everything else is only refreshed every bleRefreshPeriod, for apps that read without subscribing
+  bool refreshDue = currentMillis - previousRefresh >= bleRefreshPeriod;
+  if (refreshDue) {
+    previousRefresh = currentMillis;
+  }
+  uint16_t unchanged = batteryLevel.value() == batteryCharge.percent() ? 1 << bleChannelBatteryLevel : 0;
+  uint16_t channels = bleChannelsDue(bleAllChannels(), bleNotifying(), refreshDue, unchanged);
+  bleLinks.update(channels, currentMillis);
+}
+
+void serviceBLE() {
+  // Writes queued channels back to back, so a reading goes out in one connection event
+  // (up to blePacketsPerLoop notifications per loop, a notifying channel costs one per connected link)
+  uint8_t budget = blePacketsPerLoop;
+  uint16_t notifying = bleNotifying();
+  int8_t channel;
+  while ((channel = bleLinks.next(&budget, notifying, currentMillis)) != bleNoChannel) {
+    writeChannel(channel);
+  }
+}
+
+void bleConnected(BLEDevice central) {
+  char address[addressLength + 1];
+  copyAddress(address, central.address().c_str()); // String use is limited to these connection events
+  if (!bleLinks.connect(address, millis())) {
+    central.disconnect();  // table full, shouldn't happen since advertising stops
+    return;
+  }
+  linkManager.connect(address, millis());
+  digitalWrite(ledColorBLE, LOW); // Turn on led while connected
+  telemetry.print("Connected to central: ");
+  telemetry.println(address);
+  if (!bleLinks.full()) {
+    BLE.advertise();  // connecting stops advertising, keep accepting more centrals
+  }
+}
+
+void bleDisconnected(BLEDevice central) {
+  char address[addressLength + 1];
+  copyAddress(address, central.address().c_str());
+  bleLinks.disconnect(address);
+  linkManager.disconnect(address);
+  telemetry.print("Disconnected from central: ");
+  telemetry.println(address);
+  if (!bleLinks.count()) {
+    digitalWrite(ledColorBLE, HIGH);  // Turn off led while not connected
+  }
+  BLE.advertise();  // a link is free again
+}
+
+int8_t bleChannelOf(BLECharacteristic &characteristic) {
+  for (uint8_t channel = 0; channel < bleChannelCount; channel++) {
+    if (strcmp(characteristic.uuid(), bleChannel[channel]->uuid()) == 0) {
+      return channel;
+    }
+  }
+  return bleNoChannel;
+}
+
+void bleSubscription(BLEDevice central, BLECharacteristic characteristic, bool subscribed) {
+  // A new subscriber gets a fresh value, bleNotifying() reads the CCCDs for everything else
+  int8_t channel = bleChannelOf(characteristic);
+  if (channel == bleNoChannel) {
+    return;
+  }
+  if (subscribed) {
+    bleLinks.update(1 << channel, currentMillis);  // the value may be up to bleRefreshPeriod old, send a fresh one
+  }
+}
+
+void sendLinkDiagnostics() {
+  linkDiagnostics report;
+  linkManager.diagnostics(&report);
+  linkDiagnosticsChar.writeValue((const uint8_t *)&report, sizeof(report));
+}
+
+void serviceLinks() {
+  // Low latency while a central watches the live angles, low power otherwise
+  #ifdef bleLinkProfile
+    linkManager.setProfile(bleLinkProfile);
+  #else
+    bool watching = bleNotifying() & ((1 << bleChannelRoll) | (1 << bleChannelPitch)
+                                    | (1 << bleChannelRollBinary) | (1 << bleChannelPitchBinary));
+    watching |= dfu.state() == dfuReceiving;  // firmware transfers want throughput
+    linkManager.setProfile(watching ? linkProfileLowLatency : linkProfileLowPower);
+  #endif
+  if (linkManager.service(currentMillis)) {
+    sendLinkDiagnostics();
+  }
+}
+
+void bleSubscribed(BLEDevice central, BLECharacteristic characteristic) {
+  bleSubscription(central, characteristic, true);
+}
+
+void bleUnsubscribed(BLEDevice central, BLECharacteristic characteristic) {
+  bleSubscription(central, characteristic, false);
+}
+
+void printLinks() {
+  // BLE connections for the OLED "BT: " line
+  if (bleLinks.count() > 1) {
+    display.print(bleLinks.count());
+    display.println(" centrals");
+  }
+  else if (bleLinks.count()) {
+    display.println(bleLinks.newest());
+  }
+  else {
+    display.println("    disconnected");
+  }
+}
+
+void drawBigValue(int16_t y, const char *text) {
+  // Right justified against the settled icon, leading spaces from formatFixed() just add width
+  int16_t x = oledIconX - display.pageTextWidth(&DejaVuSans_Bold13ptPages, text)
+    - display.pageTextWidth(&DejaVuSans_Bold13ptPages, "\xB0");
+  x = display.drawPageText(x, y, &DejaVuSans_Bold13ptPages, text);
+  display.drawPageText(x, y, &DejaVuSans_Bold13ptPages, "\xB0");
+}
+
+void drawSettled() {
+  // Top right corner: filled dot = settled, ring = moving, H = holding the last settled reading
+  if (settledFlag) {
+    display.blit(settledIcon, oledIconX, 0, SSD1306_BLIT_OR);
+  }
+  else if (holdFlag) {
+    display.blit(holdIcon, oledIconX, 0, SSD1306_BLIT_OR);
+  }
+  else {
+    display.blit(movingIcon, oledIconX, 0, SSD1306_BLIT_OR);
+  }
+}
+
+void oledFlushed(i2cTransaction &transaction) {
+  // a frame that didn't make it is simply replaced by the next reading
+  if (transaction.status == i2cFailed) {
+    oledErrors++;
+  }
+}
+
+bool flushOLED() {
+  // Queues the framebuffer, the screen window is set first so every frame starts top left
+  if (!oledFlag || !oledQueue.idle()) {
+    return false;
+  }
+  oledQueue.submit(oledAddressing);
+  oledQueue.submit(oledFrame);
+  return true;
 }
 
 void sendOLED() {
   // Update the OLED
+  #ifdef oledFormatGauge
+    gauge.add(roll, pitch);  // every reading goes in the history, even when its frame is skipped
+  #endif
+  // the last frame is still being sent from the framebuffer, this one is skipped
+  if (!oledQueue.idle()) {
+    return;
+  }
+  // show the last settled reading instead of the live one while holding
+  const char *rollText = rollBuffer;
+  const char *pitchText = pitchBuffer;
+  float rollShown = roll;
+  float pitchShown = pitch;
+  if (holdFlag && !settledFlag) {
+    rollText = heldRollBuffer;
+    pitchText = heldPitchBuffer;
+    rollShown = heldRoll;
+    pitchShown = heldPitch;
+  }
   display.clearDisplay();
-  #ifdef oledFormatBig
+  #if defined(oledFormatGauge)
+    gauge.draw(display, rollShown, pitchShown, rollText, pitchText);
+  #elif defined(oledFormatBig)
     display.setTextSize(1);
     display.setTextColor(SSD1306_WHITE);
     display.setCursor(0, 0);
     display.print("R:");
-    display.setTextSize(3);
-    // right justify values
-    // strf() takes care of most of the work since values range +-180.0
-    if(roll > -100) { // add a space only if we have a value > -100
-      display.print(" ");
-    }
-    display.println(rollBuffer);
-    display.setTextSize(1);
+    drawBigValue(0, rollText);
+    display.setCursor(0, 24);
     display.print("P:");
-    display.setTextSize(3);
-    if(pitch > -100) { // add a space only if we have a value > -100
-      display.print(" ");
-    }
-    display.println(pitchBuffer);
-    display.setTextSize(1);
+    drawBigValue(24, pitchText);
     display.setCursor(0, 52);
     // update alternating display index when enough time has passed
     if ( currentMillis - previousDisplay > displayAlternatePeriod) {
       previousDisplay = currentMillis;
-      if (displayIndex == 0)  {
-        displayIndex = 1;
-      }
-      else {
-        displayIndex = 0;
-      }
+      displayIndex++;
+      #ifdef displayThrow
+        if (displayIndex > 2)  {
+          displayIndex = 0;
+        }
+      #else
+        if (displayIndex > 1)  {
+          displayIndex = 0;
+        }
+      #endif
     }
     // show alternating display based on the current index
     if (displayIndex == 0)
     {
-      display.print("Battery:      ");
-      display.print(batteryBuffer);
-      display.println(" V");
+      display.println(batteryLine);
+    }
+    else if (displayIndex == 2)
+    {
+      display.println(throwLine);
     }
     else {
       display.print("BT: ");
-      if (centralFlag) {   // show BLE connections
-        display.println(centralAddress);
-      }
-      else {
-        display.println("    disconnected");
-      }
+      printLinks();
     }
-  #endif
-  #ifndef oledFormatBig
+  #else
     display.setTextSize(2);
     display.setTextColor(SSD1306_WHITE);
     display.setCursor(0, 0);
     display.print("R: ");
     // right justify values
     // strf() takes care of most of the work since values range +-180.0
-    if(roll > -100) { // add a space only if we have a value > -100
+    if(rollShown > -100) { // add a space only if we have a value > -100
       display.print(" ");
     }
-    display.print(rollBuffer);
+    display.print(rollText);
     display.println((char)247); // degree symbol
     display.print("P: ");
-    if(pitch > -100) { // add a space only if we have a value > -100
+    if(pitchShown > -100) { // add a space only if we have a value > -100
       display.print(" ");
     }
-    display.print(pitchBuffer);
+    display.print(pitchText);
     display.println((char)247);
     
     display.setCursor(0, 38);
     display.setTextSize(1);
-    display.print("BT: ");
-    if (centralFlag) {   // show BLE connections
-      display.println(centralAddress);
-    }
-    else {
-      display.println("    disconnected");
-    }
+    #ifdef displayThrow
+      // alternate the bluetooth line with the captured throw
+      if ( currentMillis - previousDisplay > displayAlternatePeriod) {
+        previousDisplay = currentMillis;
+        displayIndex = !displayIndex;
+      }
+      if (displayIndex) {
+        display.println(throwLine);
+      }
+      else {
+    #endif
+        display.print("BT: ");
+        printLinks();
+    #ifdef displayThrow
+      }
+    #endif
     display.setCursor(0, 52);
-    display.print("Battery:      ");
-    display.print(batteryBuffer);
-    display.println(" V");
+    display.println(batteryLine);
   #endif
-  display.display();
+  drawSettled();
+  flushOLED();
 }
 
-void tareAxis() {
-  // Sets axis zeros at the current position
-  tareRoll = rollRaw;
-  tarePitch = pitchRaw;
+void tareAxis(float x, float y, float z) {
+  // Sets axis zeros at the position of the averaged accelerometer vector
+  tareRoll = atan2(y, z) * 57.2958;
+  tarePitch = atan2(-x, sqrt(y * y + z * z)) * 57.2958;
+  // Save to flash so the zero survives a power cycle
+  tareSettings tare = { tareRoll, tarePitch };
+  settings.put(settingsKeyTare, &tare, sizeof(tare));
 }
 
-void setup()
-{
-  Serial.begin(115200);    // initialize serial communication
-  delay(1000);    // give time for serial to startup
-
-  pinMode(tareButtonPin, INPUT_PULLUP); // init tare button
+void requestTare() {
+  // Starts a tare, the led stays on until it is done
+  previousTare = currentMillis; //start led timer
+  digitalWrite(ledColorTare, LOW); // turn on tare led flash
+  tareLedFlag = 1;
+  tareEngine.request(currentMillis);
+}
 
-  pinMode(LED_RED, OUTPUT); // initialize the built-in LEDs
-  pinMode(LED_BLUE, OUTPUT);
-  pinMode(LED_GREEN, OUTPUT);
+void resetThrow() {
+  // Restarts the min/max capture, on demand and after every tare (the zero moved)
+  throwCapture.reset();
+  formatThrowLine();
+  bleLinks.update(bleNotifying() & ((1 << bleChannelRollThrow) | (1 << bleChannelPitchThrow)
+                  | (1 << bleChannelRollThrowBinary) | (1 << bleChannelPitchThrowBinary)), currentMillis);
+}
 
-  pinMode (chargePin, OUTPUT);  // init charge current setting pin
-  pinMode (batteryReadPin, OUTPUT);  // init charge current setting pin
+void loadSettings() {
+  // Restores saved settings from flash
+  if (!settings.begin()) {
+    telemetry.println("Settings - formatted");
+    return;
+  }
+  tareSettings tare;
+  if (settings.get(settingsKeyTare, &tare, sizeof(tare))) {
+    tareRoll = tare.roll;
+    tarePitch = tare.pitch;
+  }
+  commandConfig saved;
+  if (settings.get(settingsKeyConfig, &saved, sizeof(saved)) && validConfig(saved)) {
+    runtimeConfig = saved;
+  }
+  dfuProgress transfer;
+  if (settings.get(settingsKeyDfu, &transfer, sizeof(transfer)) && transfer.size) {
+    dfu.begin(&transfer);  // a firmware update was interrupted, it resumes from here
+    if (dfu.state() != dfuIdle) {
+      telemetry.println("Firmware update pending");
+    }
+  }
+  telemetry.println("Settings - OK");
+}
 
-  Serial.println("BLE Inclinometer");
-  Serial.println("by: Truglodite");
-  // prepare I²C for the OLED
-  Wire.begin();
+void startIMU() {
+  // Configure IMU from the runtime settings (settings must be in place before begin())
+  // also used to restart it when the ODR or range is changed
+  myIMU.settings.gyroEnabled = 0;  //Can be 0 or 1
+  myIMU.settings.accelEnabled = 1;
+  myIMU.settings.accelRange = runtimeConfig.imuRange;      //Max G force readable.  Can be: 2, 4, 8, 16
+  myIMU.settings.accelSampleRate = runtimeConfig.imuRate;  //Hz.  Can be: 13, 26, 52, 104, 208, 416, 833, 1660, 3330, 6660
+  // anti-alias bandwidth ~1/4 of the ODR: 50Hz for slow-precise 208Hz, 400Hz for bench streaming at 1660Hz
+  uint16_t bandwidth = runtimeConfig.imuRate / 4;
+  myIMU.settings.accelBandWidth = bandwidth >= 400 ? 400 : bandwidth >= 200 ? 200 : bandwidth >= 100 ? 100 : 50;  //Hz.  Can be: 50, 100, 200, 400;
+  tareEngine.timeout = tareTimeout;
+  settleDetector.noise = settleNoise;
+  settleDetector.minSamples = (uint32_t)settleTime * myIMU.settings.accelSampleRate / 1000;
+  throwCapture.setFilter(captureFilter, myIMU.settings.accelSampleRate);
 
-  // Initialize SSD1306 OLED
-  if(!display.begin(SSD1306_SWITCHCAPVCC, 0x3C)) { // 0x3C is common I2C address
-    Serial.println("OLED failed!");
+  if (myIMU.begin() != 0) {
+      telemetry.println("IMU error!");
   } else {
-    Serial.println("OLED - OK");
+      telemetry.println("IMU - OK");
   }
+  Wire1.setClock(imuBus.hz());  // begin() restarts the bus at its default
+  // angle tolerance to accelerometer counts at 1g, for the steady window test
+  tareEngine.tolerance = max(1, (int)(tareTolerance / 57.2958 / myIMU.calcAccel(1)));
+  tareEngine.clear();  // counts from a previous range don't mix
+  imuReadyMillis = currentMillis + imuWarmupTime; // accelerometer settles while BLE and OLED start
+  if (!imuReadyMillis) {
+    imuReadyMillis = 1;  // 0 means running
+  }
+}
 
-  //Display Splashscreen
-  display.clearDisplay();
-  display.drawBitmap( 0, 0, splashScreen, SPLAST_WIDTH, SPLASH_HEIGHT, WHITE);
-  display.display();
-  delay(3000);
+void restartReading() {
+  // Drops the partial averaging window
+  samples = 0;
+  accX = 0.0;
+  accY = 0.0;
+  accZ = 0.0;
+}
 
-// …rest of setup()
-  // begin initialization
-  if (!BLE.begin()) 
-  {
-    Serial.println("BLE failed!");
+void dfuDataWritten(BLEDevice central, BLECharacteristic characteristic) {
+  // Called for every chunk (write without response, several can arrive in one BLE.poll())
+  uint8_t result = dfu.data(characteristic.value(), characteristic.valueLength());
+  if (result == dfuOk) {
+    dfuRewindFlag = 0;
   }
-  else  {
-    Serial.println("BLE - OK");
+  else if (!dfuRewindFlag) {
+    // tell the sender once where to continue, the chunks already in flight are dropped too
+    dfuResponse response;
+    dfu.status(0, result, &response);
+    dfuControlChar.writeValue((const uint8_t *)&response, sizeof(response));
+    dfuRewindFlag = 1;
   }
+  if (dfu.progressDue()) {
+    settings.put(settingsKeyDfu, &dfu.progress(), sizeof(dfuProgress));
+  }
+}
 
-  if (myIMU.begin() != 0) {
-      Serial.println("IMU error!");
-  } else {
-      Serial.println("IMU - OK");
+void sendDfuResponse(const dfuResponse &response) {
+  dfuControlChar.writeValue((const uint8_t *)&response, sizeof(response));
+  if (response.opcode == (dfuStart | 0x80)) {
+    if (response.result == dfuOk) {
+      telemetry.print("Firmware update at ");
+      telemetry.print(response.offset);
+      telemetry.print(" of ");
+      telemetry.println(response.size);
+    }
+    else if (response.result == dfuSlotInUse) {
+      telemetry.println("Firmware update refused, the sketch reaches dfuSlotBase");
+    }
+  }
+  else if (response.result == dfuBadImage) {
+    telemetry.println("Firmware update refused, not an nRF52840 image for this board");
+  }
+}
+
+void serviceDfu() {
+  // Erases the update slot a page per loop (~85ms each, the CPU stalls), outside the BLE
+  // write callbacks, then answers the dfuStart that was waiting for it
+  if (dfu.erase() && dfuStartFlag) {
+    dfuStartFlag = 0;
+    dfuResponse response;
+    dfu.status(dfuStart, dfuOk, &response);
+    sendDfuResponse(response);
+  }
+}
+
+void handleDfuControl() {
+  // Firmware update control requests, the image is installed once it has verified
+  dfuResponse response;
+  dfu.control(dfuControlChar.value(), dfuControlChar.valueLength(), &response);
+  dfuRewindFlag = 0;
+  if (dfu.progressDue()) {
+    settings.put(settingsKeyDfu, &dfu.progress(), sizeof(dfuProgress));
+  }
+  if (response.opcode == (dfuStart | 0x80) && dfu.state() == dfuErasing) {
+    dfuStartFlag = 1;  // answered by serviceDfu() once the slot is clear
+    telemetry.println("Firmware update, erasing the slot");
+    return;
+  }
+  if (dfu.state() != dfuErasing) {
+    dfuStartFlag = 0;  // aborted
+  }
+  sendDfuResponse(response);
+  if (dfu.state() == dfuVerified) {
+    telemetry.println("Firmware verified, installing");
+    uint32_t size = dfu.progress().size;
+    dfuProgress done = {};
+    settings.put(settingsKeyDfu, &done, sizeof(done));
+    // let the response and the log go out, then drop the links
+    uint32_t start = millis();
+    while (millis() - start < 200) {
+      BLE.poll();
+      telemetry.service(Serial);
+    }
+    BLE.disconnect();
+    dfuInstallImage(dfu.slot(), dfuAppBase, size, 4096);
+  }
+}
+
+void handleCommandWrite() {
+  // Runs a command from the BLE command characteristic and notifies the response
+  uint8_t response[commandMaxLength];
+  uint8_t responseLength;
+  uint8_t actions = handleCommand(commandChar.value(), commandChar.valueLength(), runtimeConfig, response, &responseLength);
+  if (actions & commandActionImu) {
+    startIMU();
+    restartReading();
+    telemetry.print("IMU ODR/range set to ");
+    telemetry.print(runtimeConfig.imuRate);
+    telemetry.print("Hz +-");
+    telemetry.print(runtimeConfig.imuRange);
+    telemetry.println("g");
+  }
+  if (actions & commandActionWindow) {
+    restartReading();
+  }
+  if (actions & commandActionStream) {
+    #ifdef telemetryBinary
+      telemetry.binary = 1;
+    #else
+      telemetry.binary = runtimeConfig.stream != 0;
+    #endif
+  }
+  if (actions & (commandActionCapture | commandActionReset)) {
+    resetThrow();
+  }
+  if (actions & commandActionPersist) {
+    if (!settings.put(settingsKeyConfig, &runtimeConfig, sizeof(runtimeConfig))) {
+      response[3] = commandFailed;
+    }
+    telemetry.println("Settings saved via BLE");
+  }
+  commandChar.writeValue(response, responseLength);
+}
+
+void startBLE() {
+  // begin initialization
+  if (!BLE.begin()) 
+  {
+    telemetry.println("BLE failed!");
+    return;
   }
+  telemetry.println("BLE - OK");
 
   // Set advertised local name and service
   BLE.setDeviceName( "Angle Monitor" );
@@ -395,86 +1073,264 @@ void setup()
   rollDegrees.addDescriptor(rollDegreesDescriptor);
   pitchDegrees.addDescriptor(pitchDegreesDescriptor);
   tareChar.addDescriptor(tareCharDescriptor);
+  settledChar.addDescriptor(settledCharDescriptor);
+  rollThrow.addDescriptor(rollThrowDescriptor);
+  pitchThrow.addDescriptor(pitchThrowDescriptor);
+  throwResetChar.addDescriptor(throwResetDescriptor);
+  commandChar.addDescriptor(commandDescriptor);
+  dfuControlChar.addDescriptor(dfuControlDescriptor);
+  dfuDataChar.addDescriptor(dfuDataDescriptor);
+  linkDiagnosticsChar.addDescriptor(linkDiagnosticsDescriptor);
+  rollBinary.addDescriptor(rollBinaryDescriptor);
+  rollBinary.addDescriptor(rollFormatDescriptor);
+  pitchBinary.addDescriptor(pitchBinaryDescriptor);
+  pitchBinary.addDescriptor(pitchFormatDescriptor);
+  batteryVoltsBinary.addDescriptor(batteryVoltsBinaryDescriptor);
+  batteryVoltsBinary.addDescriptor(batteryVoltsFormatDescriptor);
+  rollThrowBinary.addDescriptor(rollThrowBinaryDescriptor);
+  rollThrowBinary.addDescriptor(rollThrowFormatDescriptor);
+  pitchThrowBinary.addDescriptor(pitchThrowBinaryDescriptor);
+  pitchThrowBinary.addDescriptor(pitchThrowFormatDescriptor);
 
   // Add BLE characteristics
-  angleMonitorService.addCharacteristic( batteryVolts );
-  angleMonitorService.addCharacteristic( rollDegrees );
-  angleMonitorService.addCharacteristic( pitchDegrees );
+  #ifdef bleTextValues
+    angleMonitorService.addCharacteristic( batteryVolts );
+    angleMonitorService.addCharacteristic( rollDegrees );
+    angleMonitorService.addCharacteristic( pitchDegrees );
+  #endif
   angleMonitorService.addCharacteristic( tareChar );
+  angleMonitorService.addCharacteristic( settledChar );
+  #ifdef bleTextValues
+    angleMonitorService.addCharacteristic( rollThrow );
+    angleMonitorService.addCharacteristic( pitchThrow );
+  #endif
+  angleMonitorService.addCharacteristic( throwResetChar );
+  angleMonitorService.addCharacteristic( linkDiagnosticsChar );
+  angleMonitorService.addCharacteristic( commandChar );
+  angleMonitorService.addCharacteristic( dfuControlChar );
+  angleMonitorService.addCharacteristic( dfuDataChar );
+  angleMonitorService.addCharacteristic( rollBinary );
+  angleMonitorService.addCharacteristic( pitchBinary );
+  angleMonitorService.addCharacteristic( batteryVoltsBinary );
+  angleMonitorService.addCharacteristic( rollThrowBinary );
+  angleMonitorService.addCharacteristic( pitchThrowBinary );
+
+  // Connection and subscription events, several centrals can be connected at once
+  BLE.setEventHandler(BLEConnected, bleConnected);
+  BLE.setEventHandler(BLEDisconnected, bleDisconnected);
+  dfuDataChar.setEventHandler(BLEWritten, dfuDataWritten);
+  for (uint8_t channel = 0; channel < bleChannelCount; channel++) {
+    bleChannel[channel]->setEventHandler(BLESubscribed, bleSubscribed);
+    bleChannel[channel]->setEventHandler(BLEUnsubscribed, bleUnsubscribed);
+  }
 
   // Add Service
   BLE.addService( angleMonitorService );
+  batteryService.addCharacteristic( batteryLevel );
+  BLE.addService( batteryService );
 
-  // Write initial values
-  dtostrf(battery, 4, 2, batteryBuffer);
-  batteryVolts.writeValue(batteryBuffer);
-  dtostrf(roll, 5, 2, rollBuffer);
-  rollDegrees.writeValue(rollBuffer);
-  dtostrf(pitch, 5, 2, pitchBuffer);
-  pitchDegrees.writeValue(pitchBuffer);
+  // Write initial values, same precision as every later update
+  batteryLength = formatFixed(batteryBuffer, battery, 4, 2);
+  rollLength = formatFixed(rollBuffer, roll, 5, 1);
+  pitchLength = formatFixed(pitchBuffer, pitch, 5, 1);
+  resetThrow();
+  uint16_t channels = bleAllChannels();
+  for (uint8_t channel = 0; channel < bleChannelCount; channel++) {
+    if (channels & (1 << channel)) {
+      writeChannel(channel);
+    }
+  }
   tareChar.writeValue(0);
+  settledChar.writeValue(0);
+  throwResetChar.writeValue(0);
+  sendLinkDiagnostics();
 
   // start advertising
   BLE.advertise();
+  bootAdvertiseMillis = millis();
+  telemetry.println("Bluetooth® waiting for connections to 'Angle Monitor'");
+}
 
-  // Configure IMU for slow-precise angle measurement
-  myIMU.settings.gyroEnabled = 0;  //Can be 0 or 1
-  myIMU.settings.accelEnabled = 1;
-  myIMU.settings.accelRange = 2;      //Max G force readable.  Can be: 2, 4, 8, 16
-  myIMU.settings.accelSampleRate = 208;  //Hz.  Can be: 13, 26, 52, 104, 208, 416, 833, 1666, 3332, 6664, 13330
-  myIMU.settings.accelBandWidth = 50;  //Hz.  Can be: 50, 100, 200, 400;
+void startOLED() {
+  // prepare I²C for the OLED (the IMU has its own internal bus)
+  Wire.begin();
+
+  // Initialize SSD1306 OLED
+  if(!display.begin(SSD1306_SWITCHCAPVCC, oledAddress)) {
+    telemetry.println("OLED failed!");
+  } else {
+    telemetry.println("OLED - OK");
+    oledFlag = 1;
+  }
+
+  // Pre-render the corner icons, the dot and ring are centred 3 columns in
+  settledIcon.fillCircle(3, 2, 2, SSD1306_WHITE);
+  movingIcon.drawCircle(3, 2, 2, SSD1306_WHITE);
+  holdIcon.setTextColor(SSD1306_WHITE);
+  holdIcon.print('H');
+
+  //Display Splashscreen, it stays up until the first averaged reading replaces it
+  //decoded straight from flash into the display, the framebuffer is not used
+  display.streamImageRLE(0, 0, splashScreen_data, sizeof(splashScreen_data), splashScreen_width, splashScreen_height);
+
+  // Later frames go out in the background, on the TWI instance Wire set up
+  oledAddressing.address = oledAddress;
+  oledAddressing.prefix[0] = 0x00;  // Co = 0, D/C = 0: commands
+  oledAddressing.prefixLength = 1;
+  oledAddressing.data = oledWindow;
+  oledAddressing.length = sizeof(oledWindow);
+  oledFrame.address = oledAddress;
+  oledFrame.prefix[0] = 0x40;  // D/C = 1: display data
+  oledFrame.prefixLength = 1;
+  oledFrame.data = display.getBuffer();
+  oledFrame.length = SCREEN_WIDTH * SCREEN_HEIGHT / 8;
+  oledFrame.prefixed = true;  // the control byte sits just before the framebuffer, one 1025 byte DMA transfer
+  oledFrame.done = oledFlushed;
+  if (oledTwim.begin(digitalPinToPinName(PIN_WIRE_SDA), digitalPinToPinName(PIN_WIRE_SCL), oledBus.hz())) {
+    telemetry.println("OLED - EasyDMA");
+  }
+  else {
+    oledQueue.setBus(oledWire);
+  }
+  oledWire.setClock(oledBus.hz());
+}
+
+void serviceBusClocks() {
+  // Steps a bus down a clock profile when it keeps failing (long OLED harness, noise)
+  if (imuBus.update(myIMU.nonSuccessCounter + myIMU.allOnesCounter, currentMillis)) {
+    Wire1.setClock(imuBus.hz());
+    telemetry.print("IMU I2C errors, clock down to ");
+    telemetry.print(imuBus.hz() / 1000);
+    telemetry.println(" kHz");
+  }
+  if (oledFlag && oledBus.update(oledErrors, currentMillis)) {
+    oledTwim.setClock(oledBus.hz());
+    oledWire.setClock(oledBus.hz());
+    telemetry.print("OLED I2C errors, clock down to ");
+    telemetry.print(oledBus.hz() / 1000);
+    telemetry.println(" kHz");
+  }
+}
+
+void startupTask() {
+  // Runs one startup stage per loop, so no single step holds up the others for long
+  switch (bootState) {
+    case bootIMU:
+      startIMU();
+      bootState = bootBLE;
+      break;
+    case bootBLE:
+      startBLE();
+      bootState = bootOLED;
+      break;
+    case bootOLED:
+      startOLED();
+      bootState = bootDone;
+      break;
+    default:
+      break;
+  }
+}
+
+void reportBoot() {
+  // Prints the boot timeline once, when the first angle is ready
+  telemetry.print("Boot: advertising at ");
+  telemetry.print(bootAdvertiseMillis);
+  telemetry.print(" ms, first angle at ");
+  telemetry.print(bootFirstAngleMillis);
+  telemetry.println(" ms");
+}
+
+void setup()
+{
+  Serial.begin(115200);    // initialize serial communication, no waiting for a USB host
+
+  pinMode(tareButtonPin, INPUT_PULLUP); // init tare button
+
+  pinMode(LED_RED, OUTPUT); // initialize the built-in LEDs
+  pinMode(LED_BLUE, OUTPUT);
+  pinMode(LED_GREEN, OUTPUT);
+
+  pinMode (chargePin, OUTPUT);  // init charge current setting pin
+  pinMode (batteryReadPin, OUTPUT);  // init charge current setting pin
+  digitalWrite(batteryReadPin, LOW);  // configure battery measurement
+  batteryMonitor.begin(batteryAin, batteryPeriod);
 
   digitalWrite(ledColorBLE, HIGH);  // Ensure LEDs are off before looping
   digitalWrite(ledColorData, HIGH);
   digitalWrite(ledColorTare, HIGH);
 
-  Serial.println("Bluetooth® waiting for connections to 'Angle Monitor'");
+  #ifdef displayHold
+    holdFlag = 1;
+  #endif
+
+  telemetry.level = telemetryLevel;
+  telemetry.dataPeriod = telemetryPeriod;
+  #ifdef telemetryBinary
+    telemetry.binary = 1;
+  #endif
+
+  telemetry.println("BLE Inclinometer");
+  telemetry.println("by: Truglodite");
+  loadSettings();
+  if (runtimeConfig.stream) {
+    telemetry.binary = 1;  // stream frames replace the text output
+  }
+  // IMU, BLE and OLED are started from loop() by startupTask()
 }
 
 void loop()
 {
   digitalWrite(chargePin, chargeCurrent); // configure usb charger
   digitalWrite(batteryReadPin, LOW);  // configure battery measurement
+  batteryMonitor.update();  // pick up a finished battery reading, if any
   
   currentMillis = millis();
+  telemetry.service(Serial);  // send queued debug output, never blocks
+  oledQueue.service();  // next part of the OLED frame
 
-  BLEDevice central = BLE.central();
+  if (bootState != bootDone) {
+    startupTask();
+    return;
+  }
 
-  // Check BLE central if not connected
-  if (!central) {
-    if(centralFlag)  {
-      Serial.print("Disconnected from central: ");
-      Serial.println(central.address());
-      digitalWrite(ledColorBLE, HIGH);  // Turn off led while not connected
-      centralFlag = 0;
-    }
+  BLE.poll();  // connection, subscription and write events
+  serviceBusClocks();  // I2C clock fallback
+  serviceBLE();  // notifications still queued from the last reading
+  serviceLinks();  // connection parameter requests
+
+  // count more samples if needed, once the accelerometer has settled
+  if (imuReadyMillis && currentMillis >= imuReadyMillis) {
+    accelFifo.begin();  // start queuing samples, anything from the warm up is left out
+    imuReadyMillis = 0;
   }
-  // Central is connected
-  else  {
-    if (!centralFlag)  {
-      digitalWrite(ledColorBLE, LOW); // Turn on led while connected
-      centralAddress = central.address();
-      Serial.print("Connected to central: ");
-      Serial.println(centralAddress);
-      centralFlag = 1;
-    }
+  if (imuReadyMillis) {
+    // still warming up
   }
-
-  // count more samples if needed
-  if (samples < sampleCount)  {
+  else if (samples < runtimeConfig.window)  {
     readData();
-    samples++;
+    if (settledFlag != settleDetector.settled()) {
+      settledFlag = settleDetector.settled();
+      settledChar.writeValue(settledFlag); // notify subscribed apps
+    }
   }
   // enough samples, send data
   else  {
     previousData = currentMillis;
     updateDataBuffers();
-    if (central.connected())  {
-      sendBLE();
+    if (!bootFirstAngleMillis) {
+      bootFirstAngleMillis = currentMillis;
+      reportBoot();
+    }
+    if (currentMillis - previousOutput >= runtimeConfig.outputPeriod) {
+      previousOutput = currentMillis;
+      if (bleLinks.count())  {
+        sendBLE();
+      }
+      sendOLED();
+      digitalWrite(ledColorData, LOW); // turn on data led flash
+      dataLedFlag = 1;
     }
-    sendOLED();
-    digitalWrite(ledColorData, LOW); // turn on data led flash
-    dataLedFlag = 1;
   }
   // data led is on, and time to turn it off
   if (dataLedFlag && currentMillis - previousData >= dataFlash)  {
@@ -482,33 +1338,48 @@ void loop()
     dataLedFlag = 0;
   }
 
-  // Handle tare button, no debounce needed since taring takes a while
-  if (!digitalRead(tareButtonPin) && !tareFlag) {
-    // Button is pressed and tare hasn't started
-    previousTare = currentMillis; //start led timer
-    digitalWrite(ledColorTare, LOW); // turn on tare led flash
-    tareFlag = 1;
-    tareLedFlag = 1;
-    Serial.println("Tare axis via button");
+  // Handle tare button, one tare per press (the led flash covers any bounce)
+  bool tareButton = !digitalRead(tareButtonPin);
+  if (tareButton && !tareButtonFlag && !tareLedFlag && !tareEngine.pending()) {
+    requestTare();
+    telemetry.println("Tare axis via button");
   }
+  tareButtonFlag = tareButton;
 
-  // Tare recieved, turn on LED and set tare flag
-  if (tareChar.written() && !tareFlag) {
+  // Tare recieved, turn on LED and start the tare
+  if (tareChar.written() && !tareEngine.pending()) {
     if (tareChar.value()) {    // received a HIGH value
-      previousTare = currentMillis; //start led timer
-      digitalWrite(ledColorTare, LOW); // turn on tare led flash
-      tareFlag = 1;
-      tareLedFlag = 1;
-      Serial.println("Tare axis via BLE");
+      requestTare();
+      telemetry.println("Tare axis via BLE");
     }
   }
-  // We have a tare flag, and enough samples to tare
-  if (tareFlag && samples >= sampleCount) {
-    tareAxis();
-    tareFlag = 0;
+  // Tare completes as soon as the sliding window is steady
+  float tareX, tareY, tareZ;
+  if (tareEngine.poll(currentMillis, &tareX, &tareY, &tareZ)) {
+    tareAxis(tareX, tareY, tareZ);
+    resetThrow();  // min/max were relative to the old zero
+    tareChar.writeValue(0); // notify the app the tare is done
+    telemetry.print("Tare done in ");
+    telemetry.print(currentMillis - previousTare);
+    telemetry.println(" ms");
+  }
+  // Runtime configuration via BLE
+  if (commandChar.written()) {
+    handleCommandWrite();
+  }
+  if (dfuControlChar.written()) {
+    handleDfuControl();
+  }
+  serviceDfu();
+
+  // Throw capture reset via BLE (the tare button and BLE tare reset it too)
+  if (throwResetChar.written() && throwResetChar.value()) {
+    resetThrow();
+    throwResetChar.writeValue(0);
+    telemetry.println("Throw capture reset via BLE");
   }
   // tare led is on, and time to turn it off
-  if (tareLedFlag && currentMillis - previousTare >= tareLEDtime)  {
+  if (tareLedFlag && !tareEngine.pending() && currentMillis - previousTare >= tareFlash)  {
     digitalWrite(ledColorTare, HIGH);
     tareLedFlag = 0;
   }
@@ -0,0 +1,208 @@
+#include "settingsStore.h"
+#include <string.h>
+
+#if defined(NRF52840_XXAA)
+#include <nrf.h>
+#endif
+
+#define pageMagic 0x4C434E49  // "INCL"
+#define pageHeaderSize 12     // magic, sequence, committed words
+#define recordMagic 0xA5
+#define erasedWord 0xFFFFFFFF
+
+#if defined(NRF52840_XXAA)
+void NvmcFlash::read(uint32_t address, void *data, uint32_t length) {
+  // internal flash is memory mapped
+  memcpy(data, (const void *)address, length);
+}
+
+void NvmcFlash::program(uint32_t address, const uint32_t *words, uint32_t count) {
+  NRF_NVMC->CONFIG = NVMC_CONFIG_WEN_Wen << NVMC_CONFIG_WEN_Pos;
+  while (!NRF_NVMC->READY) {}
+  volatile uint32_t *destination = (volatile uint32_t *)address;
+  for (uint32_t i = 0; i < count; i++) {
+    destination[i] = words[i];
+    while (!NRF_NVMC->READY) {}
+  }
+  NRF_NVMC->CONFIG = NVMC_CONFIG_WEN_Ren << NVMC_CONFIG_WEN_Pos;
+}
+
+void NvmcFlash::erase(uint32_t pageAddress) {
+  NRF_NVMC->CONFIG = NVMC_CONFIG_WEN_Een << NVMC_CONFIG_WEN_Pos;
+  while (!NRF_NVMC->READY) {}
+  NRF_NVMC->ERASEPAGE = pageAddress;
+  while (!NRF_NVMC->READY) {}
+  NRF_NVMC->CONFIG = NVMC_CONFIG_WEN_Ren << NVMC_CONFIG_WEN_Pos;
+}
+#endif
+
+SettingsStore::SettingsStore(SettingsFlash &flash, uint32_t baseAddress, uint32_t pageSize)
+  : flash(flash), baseAddress(baseAddress), pageSize(pageSize) {}
+
+uint32_t SettingsStore::crc32(const void *data, uint32_t length, uint32_t crc) {
+  // bitwise crc32 (no table, only used when records are read or written)
+  const uint8_t *bytes = (const uint8_t *)data;
+  while (length--) {
+    crc ^= *bytes++;
+    for (uint8_t bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+  }
+  return crc;
+}
+
+bool SettingsStore::pageValid(uint8_t page, uint32_t *sequence) const {
+  // A page is usable once its header has been committed
+  uint32_t header[3];
+  flash.read(pageAddress(page), header, sizeof(header));
+  *sequence = header[1];
+  return header[0] == pageMagic && header[2] == 0;
+}
+
+void SettingsStore::formatPage(uint8_t page, uint32_t sequence) {
+  // Erase a page and write its header, left uncommitted until the caller is done copying
+  flash.erase(pageAddress(page));
+  uint32_t header[2] = { pageMagic, sequence };
+  flash.program(pageAddress(page), header, 2);
+}
+
+bool SettingsStore::begin() {
+  uint32_t sequence0, sequence1;
+  bool valid0 = pageValid(0, &sequence0);
+  bool valid1 = pageValid(1, &sequence1);
+
+  memset(index, 0, sizeof(index));
+  if (!valid0 && !valid1) {
+    // blank or unreadable flash, start over
+    formatPage(0, 1);
+    uint32_t committed = 0;
+    flash.program(pageAddress(0) + 8, &committed, 1);
+    activePage = 0;
+    pageSequence = 1;
+    writeOffset = pageHeaderSize;
+    return false;
+  }
+  // both pages are only valid if power was lost before the old page got erased, newest wins
+  if (valid0 && (!valid1 || sequence0 > sequence1)) {
+    activePage = 0;
+    pageSequence = sequence0;
+  }
+  else {
+    activePage = 1;
+    pageSequence = sequence1;
+  }
+  scanPage();
+  return true;
+}
+
+void SettingsStore::scanPage() {
+  // Walk the record log once, remembering the newest committed record of each key
+  uint32_t base = pageAddress(activePage);
+  uint32_t offset = pageHeaderSize;
+  while (offset + 4 <= pageSize) {
+    uint32_t headerWord;
+    flash.read(base + offset, &headerWord, 4);
+    if (headerWord == erasedWord) {
+      break;  // end of log
+    }
+    recordHeader header;
+    memcpy(&header, &headerWord, 4);
+    uint32_t words = recordWords(header.length);
+    if (header.magic != recordMagic || header.length > settingsMaxValueSize || offset + words * 4 > pageSize) {
+      // garbage, don't append after it, the next put() compacts into the other page
+      offset = pageSize;
+      break;
+    }
+    uint32_t record[recordWords(settingsMaxValueSize)];
+    flash.read(base + offset, record, words * 4);
+    bool committed = record[words - 1] == 0;
+    if (committed && header.key < settingsKeyCount && crc32(record, (words - 2) * 4) == record[words - 2]) {
+      index[header.key] = offset;
+    }
+    offset += words * 4;
+  }
+  writeOffset = offset;
+}
+
+bool SettingsStore::get(uint8_t key, void *value, uint8_t length) const {
+  if (key >= settingsKeyCount || index[key] == 0) {
+    return false;
+  }
+  uint32_t address = pageAddress(activePage) + index[key];
+  recordHeader header;
+  flash.read(address, &header, 4);
+  if (header.length != length) {
+    return false;
+  }
+  flash.read(address + 4, value, length);
+  return true;
+}
+
+bool SettingsStore::appendRecord(uint8_t key, const void *value, uint8_t length) {
+  uint32_t words = recordWords(length);
+  if (writeOffset + words * 4 > pageSize) {
+    return false;
+  }
+  uint32_t record[recordWords(settingsMaxValueSize)];
+  memset(record, 0, sizeof(record));
+  recordHeader header = { recordMagic, key, length, 0xFF };
+  memcpy(&record[0], &header, 4);
+  memcpy(&record[1], value, length);
+  record[words - 2] = crc32(record, (words - 2) * 4);
+
+  // header, payload and crc first, then the commit word makes the record live
+  uint32_t address = pageAddress(activePage) + writeOffset;
+  flash.program(address, record, words - 1);
+  uint32_t committed = 0;
+  flash.program(address + (words - 1) * 4, &committed, 1);
+
+  index[key] = writeOffset;
+  writeOffset += words * 4;
+  return true;
+}
+
+bool SettingsStore::compact() {
+  // Copy the newest value of every key into the spare page, then retire the full one
+  uint8_t oldPage = activePage;
+  uint16_t oldIndex[settingsKeyCount];
+  memcpy(oldIndex, index, sizeof(index));
+
+  activePage = 1 - oldPage;
+  formatPage(activePage, pageSequence + 1);
+  writeOffset = pageHeaderSize;
+  memset(index, 0, sizeof(index));
+
+  for (uint8_t key = 0; key < settingsKeyCount; key++) {
+    if (oldIndex[key] == 0) {
+      continue;
+    }
+    uint32_t address = pageAddress(oldPage) + oldIndex[key];
+    recordHeader header;
+    uint8_t value[settingsMaxValueSize];
+    flash.read(address, &header, 4);
+    flash.read(address + 4, value, header.length);
+    appendRecord(key, value, header.length);
+  }
+
+  // commit the new page, the old one is ignored from here on even if the erase is interrupted
+  uint32_t committed = 0;
+  flash.program(pageAddress(activePage) + 8, &committed, 1);
+  pageSequence++;
+  flash.erase(pageAddress(oldPage));
+  return true;
+}
+
+bool SettingsStore::put(uint8_t key, const void *value, uint8_t length) {
+  if (key >= settingsKeyCount || length > settingsMaxValueSize) {
+    return false;
+  }
+  // skip the write if nothing changed
+  uint8_t current[settingsMaxValueSize];
+  if (get(key, current, length) && memcmp(current, value, length) == 0) {
+    return true;
+  }
+  if (writeOffset + recordWords(length) * 4 > pageSize) {
+    compact();
+  }
+  return appendRecord(key, value, length);
+}
@@ -0,0 +1,35 @@
+#include "settleDetector.h"
+
+bool SettleDetector::isStep(const WelfordTracker &tracker, float value) const {
+  // compares squares, no sqrt per sample
+  if (tracker.count < 2) {
+    return false;
+  }
+  float spread = tracker.variance();
+  if (spread < noise * noise) {
+    spread = noise * noise;
+  }
+  float distance = value - tracker.mean;
+  return distance * distance > stepSigma * stepSigma * spread;
+}
+
+void SettleDetector::add(float roll, float pitch) {
+  if (isStep(rollTracker, roll) || isStep(pitchTracker, pitch)) {
+    rollTracker.reset();
+    pitchTracker.reset();
+  }
+  rollTracker.add(roll);
+  pitchTracker.add(pitch);
+  // still moving after a full stretch, start a fresh one so old motion doesn't linger in the variance
+  if (rollTracker.count >= minSamples && !settled()) {
+    rollTracker.reset();
+    pitchTracker.reset();
+  }
+}
+
+bool SettleDetector::settled() const {
+  float limit = noise * noise;
+  return rollTracker.count >= minSamples
+      && rollTracker.variance() <= limit
+      && pitchTracker.variance() <= limit;
+}
@@ -0,0 +1,65 @@
+#include "tareEngine.h"
+
+void TareEngine::addSample(const accelSample &sample) {
+  // replace the oldest sample in the running sums
+  const int16_t *in = &sample.x;
+  if (count == tareWindow) {
+    const int16_t *out = &window[head].x;
+    for (uint8_t axis = 0; axis < 3; axis++) {
+      sum[axis] -= out[axis];
+      sumSquares[axis] -= (int32_t)out[axis] * out[axis];
+    }
+  }
+  else {
+    count++;
+  }
+  for (uint8_t axis = 0; axis < 3; axis++) {
+    sum[axis] += in[axis];
+    sumSquares[axis] += (int32_t)in[axis] * in[axis];
+  }
+  window[head] = sample;
+  head = (head + 1) % tareWindow;
+}
+
+void TareEngine::clear() {
+  head = 0;
+  count = 0;
+  for (uint8_t axis = 0; axis < 3; axis++) {
+    sum[axis] = 0;
+    sumSquares[axis] = 0;
+  }
+}
+
+bool TareEngine::steady() const {
+  // variance of the mean = (n * sum(x^2) - sum(x)^2) / n^3, compared exactly in integers
+  if (count < tareWindow) {
+    return false;
+  }
+  int64_t limit = (int64_t)tolerance * tolerance * tareWindow * tareWindow * tareWindow;
+  for (uint8_t axis = 0; axis < 3; axis++) {
+    int64_t spread = tareWindow * sumSquares[axis] - (int64_t)sum[axis] * sum[axis];
+    if (spread > limit) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void TareEngine::request(uint32_t now) {
+  requested = true;
+  requestMillis = now;
+}
+
+bool TareEngine::poll(uint32_t now, float *x, float *y, float *z) {
+  if (!requested || !count) {
+    return false;
+  }
+  if (!steady() && now - requestMillis < timeout) {
+    return false;
+  }
+  requested = false;
+  *x = (float)sum[0] / count;
+  *y = (float)sum[1] / count;
+  *z = (float)sum[2] / count;
+  return true;
+}
@@ -0,0 +1,95 @@
+#include "telemetry.h"
+
+Telemetry telemetry;
+
+bool Telemetry::dataDue(uint32_t now) {
+  if (level < telemetryData && !binary) {
+    return false;
+  }
+  if (dataSent && now - lastData < dataPeriod) {
+    return false;
+  }
+  lastData = now;
+  dataSent = true;
+  return true;
+}
+
+void Telemetry::push(const uint8_t *data, uint16_t length) {
+  // caller has checked space()
+  for (uint16_t i = 0; i < length; i++) {
+    buffer[head] = data[i];
+    head = (head + 1) & (telemetryBufferSize - 1);
+  }
+}
+
+size_t Telemetry::write(uint8_t c) {
+  // Collect a line, then queue it whole or drop it whole
+  if (level == telemetryOff || binary) {
+    return 1;
+  }
+  if (lineLength < telemetryLineSize) {
+    line[lineLength++] = c;
+  }
+  else {
+    lineOverflow = true;
+  }
+  if (c == '\n') {
+    if (lineOverflow || lineLength > space()) {
+      dropped++;
+    }
+    else {
+      push((const uint8_t *)line, lineLength);
+    }
+    lineLength = 0;
+    lineOverflow = false;
+  }
+  return 1;
+}
+
+bool Telemetry::sendFrame(const void *data, uint8_t length) {
+  // COBS encode: zeros are replaced by the distance to the next zero, so 0x00 only marks frame ends
+  if (!binary || length > telemetryMaxFrame) {
+    return false;
+  }
+  uint8_t frame[telemetryMaxFrame + 2];
+  const uint8_t *bytes = (const uint8_t *)data;
+  uint8_t code = 1;
+  uint8_t codeIndex = 0;
+  uint8_t out = 1;
+  for (uint8_t i = 0; i < length; i++) {
+    if (bytes[i] == 0) {
+      frame[codeIndex] = code;
+      code = 1;
+      codeIndex = out++;
+    }
+    else {
+      frame[out++] = bytes[i];
+      code++;
+    }
+  }
+  frame[codeIndex] = code;
+  frame[out++] = 0;  // delimiter
+
+  if (out > space()) {
+    dropped++;
+    return false;
+  }
+  push(frame, out);
+  return true;
+}
+
+void Telemetry::service(Print &port) {
+  // Only hand the port what it can take right now
+  int writable = port.availableForWrite();
+  while (writable > 0 && tail != head) {
+    // largest contiguous chunk
+    uint16_t end = head > tail ? head : telemetryBufferSize;
+    uint16_t chunk = end - tail;
+    if (chunk > writable) {
+      chunk = writable;
+    }
+    port.write(&buffer[tail], chunk);
+    tail = (tail + chunk) & (telemetryBufferSize - 1);
+    writable -= chunk;
+  }
+}
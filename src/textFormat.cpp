@@ -0,0 +1,95 @@
+#include "textFormat.h"
+#include <string.h>
+
+static const uint32_t powersOf10[formatMaxDecimals + 1] = { 1, 10, 100, 1000, 10000, 100000, 1000000 };
+
+uint8_t formatFixed(char *buffer, size_t size, float value, int8_t width, uint8_t decimals) {
+  // Float is split into mantissa and exponent, then value * 10^decimals is rounded exactly
+  // (ties to even, like printf), so the text matches dtostrf() byte for byte
+  char digits[formatBufferSize]; // filled from the right
+  uint8_t start = sizeof(digits);
+  uint32_t bits;
+  memcpy(&bits, &value, 4);
+  bool negative = bits >> 31;
+  uint8_t exponentBits = (bits >> 23) & 0xFF;
+  uint32_t mantissa = bits & 0x7FFFFF;
+  if (decimals > formatMaxDecimals) {
+    decimals = formatMaxDecimals;
+  }
+
+  const char *special = nullptr;
+  if (exponentBits == 0xFF) {
+    special = mantissa ? "nan" : "inf";
+    negative = negative && !mantissa; // newlib prints nan without a sign
+  }
+  else if (exponentBits >= 127 + 32) {
+    special = "ovf"; // 2^32 and up, same limit as Print::printFloat()
+  }
+
+  if (special) {
+    uint8_t length = strlen(special);
+    start -= length;
+    memcpy(&digits[start], special, length);
+  }
+  else {
+    int16_t exponent;
+    if (exponentBits == 0) {
+      exponent = -149;  // subnormal
+    }
+    else {
+      mantissa |= 0x800000;
+      exponent = exponentBits - 150;
+    }
+    uint64_t scaled = (uint64_t)mantissa * powersOf10[decimals];
+    if (exponent >= 0) {
+      scaled <<= exponent;
+    }
+    else {
+      uint8_t shift = -exponent < 64 ? -exponent : 64;
+      uint64_t remainder = shift < 64 ? scaled & ((1ULL << shift) - 1) : scaled;
+      uint64_t half = 1ULL << (shift - 1);
+      scaled = shift < 64 ? scaled >> shift : 0;
+      if (shift < 64 && (remainder > half || (remainder == half && (scaled & 1)))) {
+        scaled++;
+      }
+    }
+
+    // digits right to left, with at least one integer digit
+    uint8_t count = 0;
+    while (scaled || count <= decimals) {
+      if (count == decimals && decimals) {
+        digits[--start] = '.';
+      }
+      if (scaled >> 32) {
+        digits[--start] = '0' + scaled % 10;
+        scaled /= 10;
+      }
+      else {
+        uint32_t low = scaled;  // 32 bit division is much cheaper on the M4
+        digits[--start] = '0' + low % 10;
+        scaled = low / 10;
+      }
+      count++;
+    }
+  }
+  if (negative) {
+    digits[--start] = '-';
+  }
+
+  // pad to width and copy out
+  uint8_t length = sizeof(digits) - start;
+  uint8_t fieldWidth = width < 0 ? -width : width;
+  uint8_t padding = fieldWidth > length ? fieldWidth - length : 0;
+  size_t out = 0;
+  for (uint8_t i = 0; width > 0 && i < padding && out + 1 < size; i++) {
+    buffer[out++] = ' ';
+  }
+  for (uint8_t i = start; i < sizeof(digits) && out + 1 < size; i++) {
+    buffer[out++] = digits[i];
+  }
+  for (uint8_t i = 0; width < 0 && i < padding && out + 1 < size; i++) {
+    buffer[out++] = ' ';
+  }
+  buffer[out] = 0;
+  return out;
+}
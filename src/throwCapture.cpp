@@ -0,0 +1,19 @@
+#include "throwCapture.h"
+
+void ThrowCapture::setFilter(uint16_t timeConstant, uint16_t sampleRate) {
+  // alpha = dt / (tau + dt)
+  float period = 1000.0 / sampleRate;
+  smoothing = period / (timeConstant + period);
+}
+
+void ThrowCapture::add(float roll, float pitch) {
+  if (empty) {
+    // seed the filter so the extremes start at the current angle, not at 0
+    rollAxis.start(roll);
+    pitchAxis.start(pitch);
+    empty = false;
+    return;
+  }
+  rollAxis.add(roll, smoothing);
+  pitchAxis.add(pitch, smoothing);
+}
@@ -0,0 +1,77 @@
+#ifndef STUB_ARDUINO_H
+#define STUB_ARDUINO_H
+
+// Host stand-ins for the parts of the Arduino core the firmware modules and the
+// vendored libraries use, just enough for the native unit tests. Time only moves
+// when a test sets hostMillis, pins and delays do nothing.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdio.h>
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t *)(addr))
+#define F(string) (reinterpret_cast<const __FlashStringHelper *>(string))
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define DEG_TO_RAD 0.017453292519943295
+#define RAD_TO_DEG 57.29577951308232
+
+enum BitOrder { LSBFIRST = 0, MSBFIRST = 1 };
+
+typedef uint8_t byte;
+typedef bool boolean;
+class __FlashStringHelper;
+
+using std::abs;
+using std::max;
+using std::min;
+
+inline unsigned long hostMillis = 0;  // the test's clock
+inline unsigned long millis() { return hostMillis; }
+inline unsigned long micros() { return hostMillis * 1000; }
+inline void delay(unsigned long) {}
+inline void delayMicroseconds(unsigned int) {}
+inline void yield() {}
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t, uint8_t) {}
+inline int digitalRead(uint8_t) { return LOW; }
+
+#include "Print.h"
+
+// Arduino String, only what the libraries touch
+class String : public std::string {
+  public:
+    String(const char *text = "") : std::string(text) {}
+    String(const std::string &text) : std::string(text) {}
+    unsigned int length() const { return size(); }
+};
+
+// Serial, output goes nowhere unless a test reads it back from 'output'
+class HostSerial : public Stream {
+  public:
+    std::string output;
+    void begin(unsigned long) {}
+    size_t write(uint8_t c) override {
+      output += (char)c;
+      return 1;
+    }
+    int availableForWrite() override { return 256; }
+    explicit operator bool() const { return true; }
+};
+
+inline HostSerial Serial;
+
+#endif
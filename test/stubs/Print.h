@@ -0,0 +1,64 @@
+#ifndef STUB_PRINT_H
+#define STUB_PRINT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef DEC
+#define DEC 10
+#define HEX 16
+#endif
+
+class __FlashStringHelper;
+
+// Arduino Print, numbers are formatted with snprintf()
+class Print {
+  public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *data, size_t length) {
+      size_t n = 0;
+      while (length--) {
+        n += write(*data++);
+      }
+      return n;
+    }
+    size_t write(const char *text) { return text ? write((const uint8_t *)text, strlen(text)) : 0; }
+    virtual int availableForWrite() { return 0; }
+    virtual void flush() {}
+
+    size_t print(const __FlashStringHelper *text) { return write((const char *)text); }
+    size_t print(const char *text) { return write(text); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(unsigned char value, int base = DEC) { return print((unsigned long)value, base); }
+    size_t print(int value, int base = DEC) { return print((long)value, base); }
+    size_t print(unsigned int value, int base = DEC) { return print((unsigned long)value, base); }
+    size_t print(long value, int base = DEC) { return format(base == DEC ? "%ld" : "%lX", value); }
+    size_t print(unsigned long value, int base = DEC) { return format(base == DEC ? "%lu" : "%lX", value); }
+    size_t print(double value, int digits = 2) {
+      char text[48];
+      snprintf(text, sizeof(text), "%.*f", digits, value);
+      return write(text);
+    }
+    size_t println() { return write("\r\n"); }
+    template <typename T> size_t println(T value) { return print(value) + println(); }
+    template <typename T> size_t println(T value, int format) { return print(value, format) + println(); }
+
+  private:
+    template <typename T> size_t format(const char *pattern, T value) {
+      char text[24];
+      snprintf(text, sizeof(text), pattern, value);
+      return write(text);
+    }
+};
+
+class Stream : public Print {
+  public:
+    virtual int available() { return 0; }
+    virtual int read() { return -1; }
+    virtual int peek() { return -1; }
+};
+
+#endif
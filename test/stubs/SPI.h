@@ -0,0 +1,34 @@
+#ifndef STUB_SPI_H
+#define STUB_SPI_H
+
+// Host SPI, the native tests never talk to an SPI device
+
+#include <Arduino.h>
+
+#define SPI_MODE0 0x00
+#define SPI_MODE1 0x04
+#define SPI_MODE2 0x08
+#define SPI_MODE3 0x0C
+
+class SPISettings {
+  public:
+    SPISettings() {}
+    SPISettings(uint32_t, BitOrder, uint8_t) {}
+};
+
+class SPIClass {
+  public:
+    void begin() {}
+    void end() {}
+    void beginTransaction(SPISettings) {}
+    void endTransaction() {}
+    uint8_t transfer(uint8_t) { return 0; }
+    void transfer(void *, size_t) {}
+    void setBitOrder(BitOrder) {}
+    void setDataMode(uint8_t) {}
+    void setClockDivider(uint8_t) {}
+};
+
+inline SPIClass SPI;
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef STUB_WIRE_H
+#define STUB_WIRE_H
+
+// Host Wire that records every write transaction (address first) and answers
+// reads from a queue the test fills, for counting and checking bus traffic. With
+// `registers` set it acts as a register file device instead: the first byte written
+// sets the register pointer, the rest are stored auto-incrementing, reads follow it.
+
+#include <Arduino.h>
+#include <deque>
+#include <vector>
+
+class TwoWire : public Stream {
+  public:
+    std::vector<std::vector<uint8_t>> transactions;  // address + bytes of each endTransmission()
+    std::deque<uint8_t> replies;  // bytes returned by read()
+    uint32_t clock = 100000;
+    uint32_t txBytes = 0;
+    uint8_t *registers = nullptr;  // 256 bytes, or nullptr to answer from `replies`
+    uint8_t pointer = 0;
+
+    void begin() {}
+    void end() {}
+    void setClock(uint32_t hz) { clock = hz; }
+    void beginTransmission(uint8_t address) { current.assign(1, address); }
+    size_t write(uint8_t c) override {
+      current.push_back(c);
+      txBytes++;
+      return 1;
+    }
+    size_t write(const uint8_t *data, size_t length) override {
+      for (size_t i = 0; i < length; i++) {
+        write(data[i]);
+      }
+      return length;
+    }
+    uint8_t endTransmission(bool stop = true) {
+      (void)stop;
+      transactions.push_back(current);
+      if (registers && current.size() > 1) {
+        pointer = current[1];
+        for (size_t i = 2; i < current.size(); i++) {
+          registers[pointer++] = current[i];
+        }
+      }
+      return 0;
+    }
+    uint8_t requestFrom(uint8_t address, size_t length, bool stop = true) {
+      (void)address;
+      (void)stop;
+      for (size_t i = 0; registers && i < length; i++) {
+        replies.push_back(registers[pointer++]);
+      }
+      return replies.size() < length ? replies.size() : length;
+    }
+    int available() override { return replies.size(); }
+    int read() override {
+      if (replies.empty()) {
+        return -1;
+      }
+      uint8_t c = replies.front();
+      replies.pop_front();
+      return c;
+    }
+    void reset() {
+      transactions.clear();
+      replies.clear();
+      txBytes = 0;
+    }
+
+  private:
+    std::vector<uint8_t> current;
+};
+
+inline TwoWire Wire;
+inline TwoWire Wire1;
+
+#endif
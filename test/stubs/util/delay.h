@@ -0,0 +1,4 @@
+#ifndef STUB_UTIL_DELAY_H
+#define STUB_UTIL_DELAY_H
+
+#endif
@@ -0,0 +1,188 @@
+// Angle gauge: the incrementally scrolled sparkline against a gauge redrawn from
+// scratch with the same history, frame by frame, and the history's edge cases
+
+#include <unity.h>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <Adafruit_SSD1306Fixed.h>
+#include "angleGauge.h"
+
+#define frameBytes (128 * 64 / 8)
+
+static uint32_t state;
+static uint32_t random32() {
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+static float roll, pitch;
+
+// A random walk with the occasional jump, so the auto scale goes up and down
+static void nextReading() {
+  roll += ((int32_t)(random32() % 201) - 100) / 100.0f;
+  pitch += ((int32_t)(random32() % 201) - 100) / 200.0f;
+  uint32_t event = random32() % 1000;
+  if (event < 5) {
+    roll = ((int32_t)(random32() % 3601) - 1800) / 10.0f;
+  }
+  else if (event < 10) {
+    roll = pitch = 0;
+  }
+  roll = roll > 180 ? 180 : roll < -180 ? -180 : roll;
+  pitch = pitch > 90 ? 90 : pitch < -90 ? -90 : pitch;
+}
+
+// A new gauge holding the last `size` readings of `source`, drawn once from scratch
+static void redraw(const AngleHistory &source, AngleGauge &fresh, Adafruit_SSD1306 &display, const char *rollText, const char *pitchText) {
+  for (int16_t age = source.size() - 1; age >= 0; age--) {
+    fresh.add(source.roll(age) / 10.0f, source.pitch(age) / 10.0f);
+  }
+  display.clearDisplay();
+  fresh.draw(display, roll, pitch, rollText, pitchText);
+}
+
+// Same readings since boot: the column pattern (dotted pitch and zero line) follows
+// the reading count, so the fresh gauge starts from the same count
+static void catchUp(AngleGauge &fresh, uint32_t added, uint16_t size) {
+  for (uint32_t i = size; i < added; i++) {
+    fresh.add(0, 0);
+  }
+}
+
+void setUp(void) {
+  state = 1;
+  roll = pitch = 0;
+}
+void tearDown(void) {}
+
+void test_incremental_matches_full_redraw(void) {
+  Adafruit_SSD1306Fixed<128, 64> display(&Wire), expected(&Wire);
+  AngleGauge gauge;
+  uint32_t frames = 0;
+  uint32_t rescales = 0;
+  uint8_t range = 0;
+  for (uint32_t i = 0; i < 4000; i++) {
+    nextReading();
+    gauge.add(roll, pitch);
+    if (random32() % 4 == 0 && i % 500 != 499) {
+      continue;  // the bus was busy, this frame is skipped
+    }
+    if (i % 500 == 499) {
+      // a long stall, more readings than columns
+      for (uint16_t j = 0; j < gaugeColumns + 10; j++) {
+        nextReading();
+        gauge.add(roll, pitch);
+      }
+    }
+    char rollText[8], pitchText[8];
+    snprintf(rollText, sizeof(rollText), "%.1f", roll);
+    snprintf(pitchText, sizeof(pitchText), "%.1f", pitch);
+    display.clearDisplay();
+    gauge.draw(display, roll, pitch, rollText, pitchText);
+    frames++;
+    if (gauge.range() != range) {
+      rescales++;
+      range = gauge.range();
+    }
+
+    AngleGauge fresh;
+    catchUp(fresh, gauge.readings().added(), gauge.readings().size());
+    redraw(gauge.readings(), fresh, expected, rollText, pitchText);
+    TEST_ASSERT_EQUAL_UINT8(fresh.range(), gauge.range());
+    if (memcmp(fresh.chart().getBuffer(), gauge.chart().getBuffer(), gaugeColumns * gaugeSparkHeight / 8)) {
+      char message[48];
+      snprintf(message, sizeof(message), "chart differs at reading %u", (unsigned)i);
+      TEST_FAIL_MESSAGE(message);
+    }
+    TEST_ASSERT_EQUAL_MEMORY(expected.getBuffer(), display.getBuffer(), frameBytes);
+  }
+  TEST_ASSERT_GREATER_THAN(2000, frames);
+  TEST_ASSERT_GREATER_THAN(10, rescales);
+}
+
+void test_history(void) {
+  AngleHistory history;
+  TEST_ASSERT_EQUAL_INT16(0, history.peak());
+  history.add(1.26, -1.24);
+  TEST_ASSERT_EQUAL_INT16(13, history.roll(0));
+  TEST_ASSERT_EQUAL_INT16(-12, history.pitch(0));
+  history.add(-0.05, 0.05);  // rounds away from zero
+  TEST_ASSERT_EQUAL_INT16(-1, history.roll(0));
+  TEST_ASSERT_EQUAL_INT16(1, history.pitch(0));
+  TEST_ASSERT_EQUAL_INT16(13, history.peak());
+  for (uint16_t i = 0; i < gaugeHistorySize + 5; i++) {
+    history.add(i, 0);
+  }
+  TEST_ASSERT_EQUAL_UINT16(gaugeHistorySize, history.size());
+  TEST_ASSERT_EQUAL_UINT32(gaugeHistorySize + 7, history.added());
+  TEST_ASSERT_EQUAL_INT16((gaugeHistorySize + 4) * 10, history.roll(0));
+  TEST_ASSERT_EQUAL_INT16(50, history.roll(gaugeHistorySize - 1));
+  TEST_ASSERT_EQUAL_INT16((gaugeHistorySize + 4) * 10, history.peak());  // only the shown columns
+}
+
+void test_out_of_range_readings(void) {
+  // NaN from a failed read plots level, huge values clamp, nothing is undefined
+  AngleHistory history;
+  history.add(NAN, -NAN);
+  TEST_ASSERT_EQUAL_INT16(0, history.roll(0));
+  TEST_ASSERT_EQUAL_INT16(0, history.pitch(0));
+  history.add(INFINITY, -1e9);
+  TEST_ASSERT_EQUAL_INT16(32767, history.roll(0));
+  TEST_ASSERT_EQUAL_INT16(-32767, history.pitch(0));
+  AngleGauge gauge;
+  Adafruit_SSD1306Fixed<128, 64> display(&Wire);
+  gauge.add(NAN, NAN);
+  gauge.add(5000, -5000);
+  display.clearDisplay();
+  gauge.draw(display, 0, 0, "nan", "nan");
+  TEST_ASSERT_EQUAL_UINT8(180, gauge.range());
+}
+
+void test_timings(void) {
+  // only printed, the numbers depend on the host and the build flags
+  Adafruit_SSD1306Fixed<128, 64> display(&Wire);
+  AngleGauge gauge;
+  for (uint16_t i = 0; i < 200; i++) {
+    nextReading();
+    gauge.add(roll, pitch);
+  }
+  double best[2] = { 1e9, 1e9 };
+  for (uint8_t round = 0; round < 7; round++) {
+    for (uint8_t way = 0; way < 2; way++) {
+      auto start = std::chrono::steady_clock::now();
+      for (uint16_t run = 0; run < 200; run++) {
+        gauge.add(roll, pitch);  // steady: no rescale
+        if (way) {
+          // the chart redrawn each frame, as a gauge without the kept canvas would
+          AngleGauge fresh;
+          for (int16_t age = gauge.readings().size() - 1; age >= 0; age--) {
+            fresh.add(gauge.readings().roll(age) / 10.0f, gauge.readings().pitch(age) / 10.0f);
+          }
+          display.clearDisplay();
+          fresh.draw(display, roll, pitch, "-12.3", "4.5");
+        }
+        else {
+          display.clearDisplay();
+          gauge.draw(display, roll, pitch, "-12.3", "4.5");
+        }
+      }
+      double elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / 200;
+      best[way] = elapsed < best[way] ? elapsed : best[way];
+    }
+  }
+  char message[80];
+  snprintf(message, sizeof(message), "frame: incremental %.2f us, chart redrawn %.2f us", best[0], best[1]);
+  TEST_MESSAGE(message);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_incremental_matches_full_redraw);
+  RUN_TEST(test_history);
+  RUN_TEST(test_out_of_range_readings);
+  RUN_TEST(test_timings);
+  return UNITY_END();
+}
@@ -0,0 +1,111 @@
+// State of charge and time remaining against synthetic discharge curves
+
+#include <unity.h>
+#include <math.h>
+#include "batteryCharge.h"
+
+// The resting voltage table from batteryCharge.cpp, to build cells that follow it
+static const uint16_t curve[] = {
+  3270, 3610, 3690, 3710, 3730, 3750, 3770, 3790, 3800, 3820, 3840,
+  3850, 3870, 3910, 3950, 3980, 4020, 4080, 4110, 4150, 4200
+};
+
+// Resting millivolts of a cell at charge (0..1)
+static double restingVoltage(double charge) {
+  double position = charge * 20;
+  int step = position >= 20 ? 19 : (int)position;
+  return curve[step] + (curve[step + 1] - curve[step]) * (position - step);
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_table_ends_and_points(void) {
+  TEST_ASSERT_EQUAL_UINT16(0, BatteryCharge::ocvToCharge(0));
+  TEST_ASSERT_EQUAL_UINT16(0, BatteryCharge::ocvToCharge(3270));
+  TEST_ASSERT_EQUAL_UINT16(10000, BatteryCharge::ocvToCharge(4200));
+  TEST_ASSERT_EQUAL_UINT16(10000, BatteryCharge::ocvToCharge(4350));
+  for (uint8_t i = 0; i <= 20; i++) {
+    TEST_ASSERT_EQUAL_UINT16(i * 500, BatteryCharge::ocvToCharge(curve[i]));
+  }
+  TEST_ASSERT_EQUAL_UINT16(250, BatteryCharge::ocvToCharge(3440));  // half way up the first step
+}
+
+void test_charge_rises_with_voltage(void) {
+  uint16_t last = 0;
+  for (uint16_t mv = 3000; mv < 4400; mv++) {
+    uint16_t charge = BatteryCharge::ocvToCharge(mv);
+    TEST_ASSERT_GREATER_OR_EQUAL(last, charge);
+    last = charge;
+  }
+}
+
+void test_updates_once_per_period(void) {
+  BatteryCharge battery;
+  TEST_ASSERT_TRUE(battery.update(5, 3840, 0));
+  TEST_ASSERT_EQUAL_UINT8(50, battery.percent());
+  TEST_ASSERT_FALSE(battery.update(5 + batteryChargePeriod - 1, 4200, 0));
+  TEST_ASSERT_EQUAL_UINT8(50, battery.percent());
+  TEST_ASSERT_TRUE(battery.update(5 + batteryChargePeriod, 4200, 0));
+  TEST_ASSERT_EQUAL_UINT8(100, battery.percent());
+  TEST_ASSERT_EQUAL_UINT16(batteryUnknownTime, battery.minutesRemaining());  // no history yet
+}
+
+void test_load_sag_is_added_back(void) {
+  // 3800mV resting, 40mA through 250 milliohm reads 10mV low
+  BatteryCharge battery;
+  battery.update(0, 3790, 40);
+  TEST_ASSERT_EQUAL_UINT8(40, battery.percent());
+}
+
+void test_linear_discharge(void) {
+  // charge falls linearly from 95% to empty over 30 hours, with +-2mV of reading noise
+  // (about +-1% of charge on the flat part of the curve, more than an hour's discharge)
+  const double hours = 30;
+  BatteryCharge battery;
+  uint32_t state = 1;
+  uint32_t checked = 0;
+  double squares = 0;
+  for (uint32_t minute = 0; minute < hours * 60 * 0.95; minute++) {
+    double charge = 0.95 - minute / (hours * 60);
+    state = state * 1103515245 + 12345;
+    uint16_t mv = lround(restingVoltage(charge) - 20 * 0.25) + (int)((state >> 16) % 5) - 2;
+    TEST_ASSERT_TRUE(battery.update(minute * batteryChargePeriod, mv, 20));
+    TEST_ASSERT_UINT_WITHIN(2, lround(charge * 100), battery.percent());
+    // once the history is full, away from the steep ends of the curve
+    if (minute >= batteryHistorySize && charge > 0.15 && charge < 0.85) {
+      double remaining = charge * hours * 60;
+      TEST_ASSERT_NOT_EQUAL(batteryUnknownTime, battery.minutesRemaining());
+      TEST_ASSERT_FLOAT_WITHIN(remaining * 0.25, remaining, battery.minutesRemaining());
+      double error = (battery.minutesRemaining() - remaining) / remaining;
+      squares += error * error;
+      checked++;
+    }
+  }
+  TEST_ASSERT_GREATER_THAN(1000, checked);
+  TEST_ASSERT_LESS_THAN(0.08, sqrt(squares / checked));  // rms error
+}
+
+void test_charging_is_unknown(void) {
+  BatteryCharge battery;
+  for (uint32_t minute = 0; minute < 60; minute++) {
+    battery.update(minute * batteryChargePeriod, restingVoltage(0.3 + minute * 0.005), 0);
+  }
+  TEST_ASSERT_EQUAL_UINT16(batteryUnknownTime, battery.minutesRemaining());
+  // nor is a steady reading once charging stops
+  for (uint32_t minute = 60; minute < 60 + batteryHistorySize * 2; minute++) {
+    battery.update(minute * batteryChargePeriod, restingVoltage(0.6), 0);
+  }
+  TEST_ASSERT_EQUAL_UINT16(batteryUnknownTime, battery.minutesRemaining());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_table_ends_and_points);
+  RUN_TEST(test_charge_rises_with_voltage);
+  RUN_TEST(test_updates_once_per_period);
+  RUN_TEST(test_load_sag_is_added_back);
+  RUN_TEST(test_linear_discharge);
+  RUN_TEST(test_charging_is_unknown);
+  return UNITY_END();
+}
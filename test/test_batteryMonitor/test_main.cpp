@@ -0,0 +1,83 @@
+// Battery SAADC scaling and the integer exponential filter, the parts of
+// BatteryMonitor that don't touch the hardware
+
+#include <unity.h>
+#include <math.h>
+#include <stdlib.h>
+#include "batteryMonitor.h"
+
+// Battery millivolts for a 12 bit SAADC result, in floating point
+static double reference(int16_t result) {
+  return result * 3600.0 / 4096 * batteryDividerHigh / batteryDividerLow;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_scaling_is_rounded_exactly(void) {
+  for (int32_t result = 0; result < 4096; result++) {
+    uint16_t mv = BatteryMonitor::resultToMillivolts(result);
+    TEST_ASSERT_EQUAL_UINT16(lround(reference(result)), mv);
+  }
+}
+
+void test_scaling_extremes(void) {
+  // negative results (single ended noise below 0V) read as 0, full scale doesn't overflow
+  TEST_ASSERT_EQUAL_UINT16(0, BatteryMonitor::resultToMillivolts(-5));
+  TEST_ASSERT_EQUAL_UINT16(0, BatteryMonitor::resultToMillivolts(-32768));
+  TEST_ASSERT_EQUAL_UINT16(lround(reference(4095)), BatteryMonitor::resultToMillivolts(4095));
+  // a full 4.2V cell is about result 1614, 2.6mV per count
+  TEST_ASSERT_UINT16_WITHIN(2, 4200, BatteryMonitor::resultToMillivolts(1614));
+}
+
+void test_first_reading_is_taken_as_is(void) {
+  BatteryMonitor monitor;
+  TEST_ASSERT_FALSE(monitor.ready());
+  monitor.addReading(3850);
+  TEST_ASSERT_TRUE(monitor.ready());
+  TEST_ASSERT_EQUAL_UINT16(3850, monitor.millivolts());
+}
+
+void test_filter_settles_both_ways(void) {
+  BatteryMonitor monitor;
+  monitor.addReading(4000);
+  // each step closes 1/4 of the gap
+  monitor.addReading(4400);
+  TEST_ASSERT_EQUAL_UINT16(4100, monitor.millivolts());
+  for (int i = 0; i < 60; i++) {
+    monitor.addReading(4400);
+  }
+  TEST_ASSERT_EQUAL_UINT16(4400, monitor.millivolts());
+  for (int i = 0; i < 60; i++) {
+    monitor.addReading(3300);
+  }
+  TEST_ASSERT_EQUAL_UINT16(3300, monitor.millivolts());
+}
+
+void test_filter_smooths_noise(void) {
+  // +-40mV of uniform noise around 3900mV, the filter cuts its rms to well under half
+  BatteryMonitor monitor;
+  monitor.addReading(3900);
+  uint32_t state = 1;
+  double input = 0;
+  double output = 0;
+  for (int i = 0; i < 5000; i++) {
+    state = state * 1103515245 + 12345;
+    int noise = (int)((state >> 16) % 81) - 40;
+    monitor.addReading(3900 + noise);
+    int error = (int)monitor.millivolts() - 3900;
+    input += noise * noise;
+    output += error * error;
+  }
+  TEST_ASSERT_LESS_THAN(0.5, sqrt(output / input));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_scaling_is_rounded_exactly);
+  RUN_TEST(test_scaling_extremes);
+  RUN_TEST(test_first_reading_is_taken_as_is);
+  RUN_TEST(test_filter_settles_both_ways);
+  RUN_TEST(test_filter_smooths_noise);
+  return UNITY_END();
+}
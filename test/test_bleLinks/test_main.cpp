@@ -0,0 +1,226 @@
+// Connection table and notification scheduler, with the shared CCCD model of
+// ArduinoBLE: a notifying write goes to every connected link
+
+#include <unity.h>
+#include "bleLinks.h"
+
+#define phone "a4:c1:38:00:00:01"
+#define laptop "a4:c1:38:00:00:02"
+#define tablet "a4:c1:38:00:00:03"
+
+static BleLinks *links;
+
+// The firmware's channels: text roll, pitch, volts, throws, battery level, then binary
+#define channelRoll 0
+#define channelPitch 1
+#define channelLevel 5
+#define channelRollBinary 6
+#define channelCount 11
+#define allChannels 0x07FF
+
+// A characteristic as far as the scheduler cares: its CCCD, shared by every central
+struct MockCharacteristic {
+  bool notify = false;
+  bool subscribed() const { return notify; }
+};
+static MockCharacteristic characteristics[channelCount];
+static MockCharacteristic *channels[channelCount];
+
+// Runs the scheduler one loop, returns the channels written (bit per channel) and the packets spent
+static uint16_t loop(uint8_t packets, uint16_t notifying, uint32_t now, uint8_t *spent = nullptr) {
+  uint8_t budget = packets;
+  uint16_t written = 0;
+  int8_t channel;
+  while ((channel = links->next(&budget, notifying, now)) != bleNoChannel) {
+    TEST_ASSERT_FALSE_MESSAGE(written & (1 << channel), "channel written twice");
+    written |= 1 << channel;
+  }
+  if (spent) {
+    *spent = packets - budget;
+  }
+  return written;
+}
+
+// A new reading as sendBLE() queues it
+static void reading(uint32_t now, bool refreshDue, bool levelUnchanged = true) {
+  uint16_t notifying = bleSubscribedChannels(channels, channelCount);
+  links->update(bleChannelsDue(allChannels, notifying, refreshDue, levelUnchanged ? 1 << channelLevel : 0), now);
+}
+
+void setUp(void) {
+  links = new BleLinks();
+  for (uint8_t i = 0; i < channelCount; i++) {
+    characteristics[i].notify = false;
+    channels[i] = &characteristics[i];
+  }
+}
+void tearDown(void) {
+  delete links;
+}
+
+void test_table(void) {
+  TEST_ASSERT_EQUAL_UINT8(0, links->count());
+  TEST_ASSERT_EQUAL_STRING("", links->newest());
+  TEST_ASSERT_TRUE(links->connect(phone, 100));
+  TEST_ASSERT_TRUE(links->connect(laptop, 200));
+  TEST_ASSERT_TRUE(links->connect(phone, 300));  // reconnect, same entry
+  TEST_ASSERT_EQUAL_UINT8(2, links->count());
+  TEST_ASSERT_EQUAL_STRING(phone, links->newest());
+  TEST_ASSERT_TRUE(links->connect(tablet, 400));
+  TEST_ASSERT_TRUE(links->full());
+  TEST_ASSERT_FALSE(links->connect("a4:c1:38:00:00:04", 500));
+  links->disconnect(tablet);
+  links->disconnect(tablet);  // twice is harmless
+  TEST_ASSERT_EQUAL_UINT8(2, links->count());
+  TEST_ASSERT_EQUAL_STRING(phone, links->newest());
+  links->disconnect(phone);
+  links->disconnect(laptop);
+  TEST_ASSERT_EQUAL_UINT8(0, links->count());
+  TEST_ASSERT_EQUAL_STRING("", links->newest());
+}
+
+void test_newest_across_millis_wrap(void) {
+  links->connect(phone, 0xFFFFFF00);
+  links->connect(laptop, 0x100);
+  TEST_ASSERT_EQUAL_STRING(laptop, links->newest());
+}
+
+void test_notifying_writes_cost_every_link(void) {
+  // one central subscribed to channel 0, but the CCCD is shared, so both links get it
+  links->connect(phone, 0);
+  links->connect(laptop, 0);
+  uint8_t spent;
+  links->update(0x0001, 10);
+  TEST_ASSERT_EQUAL_HEX16(0x0001, loop(8, 0x0001, 10, &spent));
+  TEST_ASSERT_EQUAL_UINT8(2, spent);
+  // a third link makes the same write cost 3
+  links->connect(tablet, 0);
+  links->update(0x0001, 20);
+  loop(8, 0x0001, 20, &spent);
+  TEST_ASSERT_EQUAL_UINT8(3, spent);
+}
+
+void test_unsubscribed_writes_are_free(void) {
+  links->connect(phone, 0);
+  links->connect(laptop, 0);
+  uint8_t spent;
+  links->update(0x07FF, 10);
+  TEST_ASSERT_EQUAL_HEX16(0x07FF, loop(2, 0, 10, &spent));
+  TEST_ASSERT_EQUAL_UINT8(0, spent);
+  TEST_ASSERT_FALSE(links->pending());
+}
+
+void test_budget_paces_the_writes(void) {
+  // 5 notifying channels and 2 read-only ones, 8 packets per loop, a loop every 5 ms:
+  // each connected link adds a packet per notifying write, so the reading takes
+  // 1 loop with 1 link, 2 with 2 (4 + 1 channels) and 3 with 3 (2 + 2 + 1)
+  const char *addresses[] = { phone, laptop, tablet };
+  static const uint8_t expectedLoops[] = { 1, 2, 3 };
+  static const uint32_t expectedLatency[] = { 0, 5, 10 };  // msec from update() to the last write
+  uint16_t notifying = 0x001F;
+  for (uint8_t count = 1; count <= bleMaxLinks; count++) {
+    links->connect(addresses[count - 1], 0);
+    TEST_ASSERT_EQUAL_UINT8(count, links->count());
+    links->update(notifying | 0x0600, 100);
+    uint16_t written = 0;
+    uint32_t now = 100;
+    uint8_t loops = 0;
+    while (links->pending()) {
+      uint8_t spent;
+      uint16_t channels = loop(8, notifying, now, &spent);
+      TEST_ASSERT_LESS_OR_EQUAL(8, spent);
+      TEST_ASSERT_NOT_EQUAL(0, channels);  // every loop makes progress
+      written |= channels;
+      now += 5;
+      loops++;
+    }
+    TEST_ASSERT_EQUAL_HEX16(0x061F, written);
+    TEST_ASSERT_EQUAL_UINT8(expectedLoops[count - 1], loops);
+    TEST_ASSERT_EQUAL_UINT32(expectedLatency[count - 1], links->latency);
+  }
+}
+
+void test_update_merges_and_rotates(void) {
+  // channels marked again before they went out are written once, and when readings come
+  // faster than the budget the next loop carries on where the last stopped, so the
+  // channels at the end still go out
+  links->connect(phone, 0);
+  links->update(0x000F, 0);
+  TEST_ASSERT_EQUAL_HEX16(0x0003, loop(2, 0x000F, 0));
+  links->update(0x000F, 5);
+  TEST_ASSERT_EQUAL_HEX16(0x000C, loop(2, 0x000F, 5));
+  TEST_ASSERT_EQUAL_HEX16(0x0003, loop(2, 0x000F, 10));
+  TEST_ASSERT_FALSE(links->pending());
+  TEST_ASSERT_EQUAL_UINT32(10, links->latency);  // from the first update still pending
+}
+
+void test_no_links_no_cost(void) {
+  // values still update for reads while nobody is connected
+  links->update(0x0003, 0);
+  TEST_ASSERT_EQUAL_HEX16(0x0003, loop(bleMaxLinks, 0x0003, 0));
+}
+
+void test_only_subscribed_channels_are_sent(void) {
+  // only roll subscribed: a reading queues roll alone, one packet per link
+  links->connect(phone, 0);
+  links->connect(laptop, 0);
+  characteristics[channelRoll].notify = true;
+  TEST_ASSERT_EQUAL_HEX16(1 << channelRoll, bleSubscribedChannels(channels, channelCount));
+  uint8_t spent;
+  reading(10, false);
+  TEST_ASSERT_EQUAL_HEX16(1 << channelRoll, loop(8, 1 << channelRoll, 10, &spent));
+  TEST_ASSERT_EQUAL_UINT8(2, spent);
+  TEST_ASSERT_FALSE(links->pending());
+  // nothing subscribed, nothing sent
+  characteristics[channelRoll].notify = false;
+  reading(20, false);
+  TEST_ASSERT_FALSE(links->pending());
+}
+
+void test_refresh_tick_sends_everything(void) {
+  // every characteristic's value is brought up to date for readers, only the notifying
+  // ones cost packets, and an unchanged battery level is still left out
+  links->connect(phone, 0);
+  characteristics[channelRollBinary].notify = true;
+  uint8_t spent;
+  reading(1000, true);
+  TEST_ASSERT_EQUAL_HEX16(allChannels & ~(1 << channelLevel), loop(8, 1 << channelRollBinary, 1000, &spent));
+  TEST_ASSERT_EQUAL_UINT8(1, spent);
+  reading(2000, true, false);  // the level changed
+  TEST_ASSERT_EQUAL_HEX16(allChannels, loop(8, 1 << channelRollBinary, 2000));
+  // between ticks only the subscribed channel
+  reading(2050, false, false);
+  TEST_ASSERT_EQUAL_HEX16(1 << channelRollBinary, loop(8, 1 << channelRollBinary, 2050));
+  TEST_ASSERT_EQUAL_HEX16(0x0003, bleChannelsDue(0x0003, 0, true, 0));
+  TEST_ASSERT_EQUAL_HEX16(0x0001, bleChannelsDue(0x0003, 0x0005, false, 0));
+}
+
+void test_new_subscription_gets_a_value(void) {
+  // the subscribe event queues the channel straight away (bleSubscription()), so a new
+  // subscriber doesn't wait for the next reading or refresh, then every reading has it
+  links->connect(phone, 0);
+  characteristics[channelRoll].notify = true;
+  reading(10, false);
+  loop(8, 1 << channelRoll, 10);
+  characteristics[channelPitch].notify = true;
+  uint16_t notifying = bleSubscribedChannels(channels, channelCount);
+  links->update(1 << channelPitch, 12);
+  TEST_ASSERT_EQUAL_HEX16(1 << channelPitch, loop(8, notifying, 12));
+  reading(20, false);
+  TEST_ASSERT_EQUAL_HEX16((1 << channelRoll) | (1 << channelPitch), loop(8, notifying, 20));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_table);
+  RUN_TEST(test_newest_across_millis_wrap);
+  RUN_TEST(test_notifying_writes_cost_every_link);
+  RUN_TEST(test_unsubscribed_writes_are_free);
+  RUN_TEST(test_budget_paces_the_writes);
+  RUN_TEST(test_update_merges_and_rotates);
+  RUN_TEST(test_no_links_no_cost);
+  RUN_TEST(test_only_subscribed_channels_are_sent);
+  RUN_TEST(test_refresh_tick_sends_everything);
+  RUN_TEST(test_new_subscription_gets_a_value);
+  return UNITY_END();
+}
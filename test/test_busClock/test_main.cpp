@@ -0,0 +1,136 @@
+// I2C clock fallback: errors counted per busClockPeriod window, wrapping counters,
+// one profile per step down and never below busClockStandard
+
+#include <unity.h>
+#include "busClock.h"
+
+// The LSM6DS3 driver's error counters, as loop() adds them up
+struct ImuCounters {
+  uint16_t nonSuccessCounter = 0;
+  uint16_t allOnesCounter = 0;
+};
+
+// Feeds update() one error at a time, 100ms apart, returns how many steps it reported
+static uint8_t errorsAt(BusClock &bus, uint16_t *errors, uint8_t count, uint32_t *now) {
+  uint8_t steps = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    (*errors)++;
+    *now += 100;
+    steps += bus.update(*errors, *now);
+  }
+  return steps;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_profiles(void) {
+  TEST_ASSERT_EQUAL_UINT32(100000, BusClock(busClockStandard).hz());
+  TEST_ASSERT_EQUAL_UINT32(400000, BusClock(busClockFast).hz());
+  TEST_ASSERT_EQUAL_UINT32(1000000, BusClock(busClockFastPlus).hz());
+  TEST_ASSERT_EQUAL_UINT8(busClockFast, BusClock(busClockProfileCount).profile());  // unknown, the default
+}
+
+void test_steps_down_after_max_errors_in_a_window(void) {
+  BusClock bus(busClockFast);
+  uint16_t errors = 0;
+  uint32_t now = 5000;
+  TEST_ASSERT_FALSE(bus.update(errors, now));  // first call starts the window
+  TEST_ASSERT_EQUAL_UINT8(0, errorsAt(bus, &errors, busClockMaxErrors - 1, &now));
+  TEST_ASSERT_EQUAL_UINT8(busClockFast, bus.profile());
+  TEST_ASSERT_EQUAL_UINT8(1, errorsAt(bus, &errors, 1, &now));
+  TEST_ASSERT_EQUAL_UINT8(busClockStandard, bus.profile());
+  TEST_ASSERT_EQUAL_UINT32(100000, bus.hz());
+  TEST_ASSERT_EQUAL_UINT8(1, bus.stepDowns);
+  // quiet from here on: no more steps
+  for (uint32_t i = 0; i < 100; i++) {
+    now += 1000;
+    TEST_ASSERT_FALSE(bus.update(errors, now));
+  }
+  TEST_ASSERT_EQUAL_UINT8(1, bus.stepDowns);
+}
+
+void test_window_restarts(void) {
+  // the same errors spread over windows never add up to a step down
+  BusClock bus(busClockFastPlus);
+  uint16_t errors = 0;
+  uint32_t now = 0;
+  bus.update(errors, now);
+  for (uint8_t window = 0; window < 20; window++) {
+    uint32_t windowStart = now;
+    TEST_ASSERT_EQUAL_UINT8(0, errorsAt(bus, &errors, busClockMaxErrors - 1, &now));
+    now = windowStart + busClockPeriod;
+    TEST_ASSERT_FALSE(bus.update(errors, now));  // restarts the window at the current count
+  }
+  TEST_ASSERT_EQUAL_UINT8(busClockFastPlus, bus.profile());
+  TEST_ASSERT_EQUAL_UINT8(0, bus.stepDowns);
+  // one loop short of the period still counts in the same window
+  uint32_t windowStart = now;
+  errorsAt(bus, &errors, busClockMaxErrors - 1, &now);
+  now = windowStart + busClockPeriod - 1;
+  TEST_ASSERT_TRUE(bus.update(errors + 1, now));
+}
+
+void test_error_counter_wraps(void) {
+  BusClock bus(busClockFast);
+  uint16_t errors = 65534;
+  uint32_t now = 0xFFFFFF00;  // millis() wraps too
+  bus.update(errors, now);
+  TEST_ASSERT_EQUAL_UINT8(0, errorsAt(bus, &errors, busClockMaxErrors - 1, &now));  // 65535, 0
+  TEST_ASSERT_EQUAL_UINT8(1, errorsAt(bus, &errors, 1, &now));  // 1
+  TEST_ASSERT_EQUAL_UINT8(busClockStandard, bus.profile());
+}
+
+void test_floor_at_standard(void) {
+  // 1MHz -> 400kHz -> 100kHz, then it stays there however many errors follow
+  BusClock bus(busClockFastPlus);
+  uint16_t errors = 0;
+  uint32_t now = 0;
+  bus.update(errors, now);
+  TEST_ASSERT_EQUAL_UINT8(1, errorsAt(bus, &errors, busClockMaxErrors, &now));
+  TEST_ASSERT_EQUAL_UINT8(busClockFast, bus.profile());
+  // the next window starts at the step, so it takes another busClockMaxErrors
+  TEST_ASSERT_EQUAL_UINT8(0, errorsAt(bus, &errors, busClockMaxErrors - 1, &now));
+  TEST_ASSERT_EQUAL_UINT8(1, errorsAt(bus, &errors, 1, &now));
+  TEST_ASSERT_EQUAL_UINT8(busClockStandard, bus.profile());
+  TEST_ASSERT_EQUAL_UINT8(0, errorsAt(bus, &errors, 200, &now));
+  TEST_ASSERT_EQUAL_UINT8(busClockStandard, bus.profile());
+  TEST_ASSERT_EQUAL_UINT8(2, bus.stepDowns);
+
+  BusClock slow(busClockStandard);
+  errors = 0;
+  slow.update(errors, now);
+  TEST_ASSERT_EQUAL_UINT8(0, errorsAt(slow, &errors, 200, &now));
+  TEST_ASSERT_EQUAL_UINT8(0, slow.stepDowns);
+}
+
+void test_imu_counters_as_main_adds_them(void) {
+  // imuBus.update(myIMU.nonSuccessCounter + myIMU.allOnesCounter, ...): the sum is an
+  // int, truncated to uint16 on the way in, so each counter wrapping on its own is fine
+  ImuCounters imu;
+  imu.nonSuccessCounter = 65534;
+  imu.allOnesCounter = 65535;
+  BusClock bus(busClockFast);
+  uint32_t now = 0;
+  TEST_ASSERT_FALSE(bus.update(imu.nonSuccessCounter + imu.allOnesCounter, now));
+  imu.nonSuccessCounter++;  // 65535
+  TEST_ASSERT_FALSE(bus.update(imu.nonSuccessCounter + imu.allOnesCounter, now += 10));
+  imu.allOnesCounter++;  // wraps to 0
+  TEST_ASSERT_FALSE(bus.update(imu.nonSuccessCounter + imu.allOnesCounter, now += 10));
+  TEST_ASSERT_EQUAL_UINT8(busClockFast, bus.profile());
+  imu.nonSuccessCounter++;  // wraps to 0, the third error
+  TEST_ASSERT_TRUE(bus.update(imu.nonSuccessCounter + imu.allOnesCounter, now += 10));
+  TEST_ASSERT_EQUAL_UINT8(busClockStandard, bus.profile());
+  TEST_ASSERT_EQUAL_UINT8(1, bus.stepDowns);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_profiles);
+  RUN_TEST(test_steps_down_after_max_errors_in_a_window);
+  RUN_TEST(test_window_restarts);
+  RUN_TEST(test_error_counter_wraps);
+  RUN_TEST(test_floor_at_standard);
+  RUN_TEST(test_imu_counters_as_main_adds_them);
+  return UNITY_END();
+}
@@ -0,0 +1,227 @@
+// Command parser: the documented requests, and a fuzz run of random requests
+// checked against a separate model of the protocol. Every request is passed in a
+// buffer of exactly its length, so the sanitizers catch any read past the end.
+
+#include <unity.h>
+#include <vector>
+#include "commandProtocol.h"
+
+static const commandConfig defaults = { 100, 0, filterAverage, 208, 2, 0, captureOn };
+
+// The protocol as documented in commandProtocol.h
+static const uint8_t payloadBytes[commandOpcodeCount] = { 0, 2, 2, 1, 3, 1, 1, 0 };
+static const uint16_t imuRates[] = { 13, 26, 52, 104, 208, 416, 833, 1660, 3330, 6660 };
+
+static uint32_t state;
+static uint32_t random32() {
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+struct result {
+  uint8_t actions;
+  uint8_t status;
+  std::vector<uint8_t> response;
+};
+
+static result run(const std::vector<uint8_t> &request, commandConfig &config) {
+  // the request is copied to the heap with no spare bytes
+  uint8_t *exact = new uint8_t[request.size() ? request.size() : 1];
+  if (request.size()) {
+    memcpy(exact, request.data(), request.size());
+  }
+  uint8_t response[commandMaxLength];
+  uint8_t length = 0xFF;
+  result r;
+  r.actions = handleCommand(exact, request.size(), config, response, &length);
+  delete[] exact;
+  TEST_ASSERT_LESS_OR_EQUAL(commandMaxLength, length);
+  TEST_ASSERT_GREATER_OR_EQUAL(4, length);
+  r.status = response[3];
+  r.response.assign(response, response + length);
+  return r;
+}
+
+// Status the protocol description gives for a request, independent of the parser
+static uint8_t expectedStatus(const std::vector<uint8_t> &request) {
+  if (request.size() < 3) {
+    return commandBadLength;
+  }
+  if (request[0] != commandVersion) {
+    return commandBadVersion;
+  }
+  if (request[2] >= commandOpcodeCount) {
+    return commandBadOpcode;
+  }
+  if (request.size() != 3u + payloadBytes[request[2]]) {
+    return commandBadLength;
+  }
+  uint16_t word = request.size() >= 5 ? request[3] | request[4] << 8 : 0;
+  switch (request[2]) {
+    case commandSetWindow:
+      return word >= 1 && word <= 1000 ? commandOk : commandBadValue;
+    case commandSetFilter:
+      return request[3] <= filterSmooth ? commandOk : commandBadValue;
+    case commandSetImu: {
+      bool rate = false;
+      for (uint16_t odr : imuRates) {
+        rate |= word == odr;
+      }
+      uint8_t range = request[5];
+      return rate && (range == 2 || range == 4 || range == 8 || range == 16) ? commandOk : commandBadValue;
+    }
+    case commandSetStream:
+      return request[3] == 0 || request[3] == 2 || request[3] == 3 ? commandOk : commandBadValue;
+    case commandSetCapture:
+      return request[3] <= captureReset ? commandOk : commandBadValue;
+  }
+  return commandOk;
+}
+
+void setUp(void) {
+  state = 1;
+}
+void tearDown(void) {}
+
+void test_get_config(void) {
+  commandConfig config = defaults;
+  result r = run({ commandVersion, 42, commandGetConfig }, config);
+  TEST_ASSERT_EQUAL_UINT8(commandOk, r.status);
+  TEST_ASSERT_EQUAL_UINT8(0, r.actions);
+  TEST_ASSERT_EQUAL_UINT(4 + sizeof(commandConfig), r.response.size());
+  TEST_ASSERT_EQUAL_UINT8(commandVersion, r.response[0]);
+  TEST_ASSERT_EQUAL_UINT8(42, r.response[1]);  // sequence echoed
+  TEST_ASSERT_EQUAL_UINT8(commandGetConfig, r.response[2]);
+  TEST_ASSERT_EQUAL_MEMORY(&defaults, &r.response[4], sizeof(commandConfig));
+}
+
+void test_setters_and_actions(void) {
+  commandConfig config = defaults;
+  TEST_ASSERT_EQUAL_UINT8(commandActionWindow, run({ 1, 1, commandSetWindow, 0xE8, 0x03 }, config).actions);
+  TEST_ASSERT_EQUAL_UINT16(1000, config.window);
+  TEST_ASSERT_EQUAL_UINT8(0, run({ 1, 2, commandSetOutput, 50, 0 }, config).actions);
+  TEST_ASSERT_EQUAL_UINT16(50, config.outputPeriod);
+  TEST_ASSERT_EQUAL_UINT8(0, run({ 1, 3, commandSetFilter, filterSmooth }, config).actions);
+  TEST_ASSERT_EQUAL_UINT8(filterSmooth, config.filter);
+  TEST_ASSERT_EQUAL_UINT8(commandActionImu, run({ 1, 4, commandSetImu, 0x7C, 0x06, 16 }, config).actions);
+  TEST_ASSERT_EQUAL_UINT16(1660, config.imuRate);
+  TEST_ASSERT_EQUAL_UINT8(16, config.imuRange);
+  TEST_ASSERT_EQUAL_UINT8(commandActionStream, run({ 1, 5, commandSetStream, 3 }, config).actions);
+  TEST_ASSERT_EQUAL_UINT8(commandActionCapture, run({ 1, 6, commandSetCapture, captureOff }, config).actions);
+  TEST_ASSERT_EQUAL_UINT8(commandActionReset, run({ 1, 7, commandSetCapture, captureReset }, config).actions);
+  TEST_ASSERT_EQUAL_UINT8(captureOff, config.capture);  // reset isn't stored
+  TEST_ASSERT_EQUAL_UINT8(commandActionPersist, run({ 1, 8, commandPersist }, config).actions);
+  TEST_ASSERT_TRUE(validConfig(config));
+}
+
+void test_repeated_request_changes_nothing(void) {
+  commandConfig config = defaults;
+  TEST_ASSERT_EQUAL_UINT8(commandActionImu, run({ 1, 1, commandSetImu, 0xA0, 0x01, 4 }, config).actions);
+  result r = run({ 1, 2, commandSetImu, 0xA0, 0x01, 4 }, config);
+  TEST_ASSERT_EQUAL_UINT8(commandOk, r.status);
+  TEST_ASSERT_EQUAL_UINT8(0, r.actions);  // no IMU restart for the same settings
+  TEST_ASSERT_EQUAL_UINT8(0, run({ 1, 3, commandSetWindow, 100, 0 }, config).actions);
+  TEST_ASSERT_EQUAL_UINT8(0, run({ 1, 4, commandSetStream, 0 }, config).actions);
+  TEST_ASSERT_EQUAL_UINT8(0, run({ 1, 5, commandSetCapture, captureOn }, config).actions);
+}
+
+void test_rejects(void) {
+  commandConfig config = defaults;
+  TEST_ASSERT_EQUAL_UINT8(commandBadLength, run({}, config).status);
+  TEST_ASSERT_EQUAL_UINT8(commandBadLength, run({ 1, 9 }, config).status);
+  TEST_ASSERT_EQUAL_UINT8(commandBadVersion, run({ 2, 9, commandGetConfig }, config).status);
+  TEST_ASSERT_EQUAL_UINT8(commandBadOpcode, run({ 1, 9, commandOpcodeCount }, config).status);
+  TEST_ASSERT_EQUAL_UINT8(commandBadLength, run({ 1, 9, commandSetWindow, 10 }, config).status);
+  TEST_ASSERT_EQUAL_UINT8(commandBadLength, run({ 1, 9, commandGetConfig, 0 }, config).status);
+  TEST_ASSERT_EQUAL_UINT8(commandBadValue, run({ 1, 9, commandSetWindow, 0, 0 }, config).status);
+  TEST_ASSERT_EQUAL_UINT8(commandBadValue, run({ 1, 9, commandSetImu, 0xD0, 0x00, 3 }, config).status);
+  TEST_ASSERT_EQUAL_UINT8(commandBadValue, run({ 1, 9, commandSetImu, 0xD1, 0x00, 2 }, config).status);
+  TEST_ASSERT_EQUAL_UINT8(commandBadValue, run({ 1, 9, commandSetStream, 1 }, config).status);
+  TEST_ASSERT_EQUAL_MEMORY(&defaults, &config, sizeof(config));
+  // a rejected request answers with just the header
+  result r = run({ 1, 77, commandSetFilter, 9 }, config);
+  TEST_ASSERT_EQUAL_UINT(4, r.response.size());
+  TEST_ASSERT_EQUAL_UINT8(77, r.response[1]);
+}
+
+void test_flash_config_validation(void) {
+  commandConfig config = defaults;
+  TEST_ASSERT_TRUE(validConfig(config));
+  config.window = 0;
+  TEST_ASSERT_FALSE(validConfig(config));
+  config = defaults;
+  config.capture = captureReset;  // only ever a command, never stored
+  TEST_ASSERT_FALSE(validConfig(config));
+  memset(&config, 0xFF, sizeof(config));  // erased flash
+  TEST_ASSERT_FALSE(validConfig(config));
+}
+
+void test_fuzz(void) {
+  // random requests biased towards the valid shape, so most reach the value checks
+  commandConfig config = defaults;
+  uint32_t accepted = 0;
+  for (uint32_t i = 0; i < 500000; i++) {
+    std::vector<uint8_t> request;
+    uint8_t opcode = random32() % (commandOpcodeCount + 2);
+    uint8_t length = random32() % 8 ? 3 + (opcode < commandOpcodeCount ? payloadBytes[opcode] : 0)
+                                     : random32() % (commandMaxLength + 1);
+    for (uint8_t n = 0; n < length; n++) {
+      request.push_back(random32());
+    }
+    if (length > 0 && random32() % 16) {
+      request[0] = commandVersion;
+    }
+    if (length > 2) {
+      request[2] = opcode;
+    }
+    if (opcode == commandSetImu && length == 6 && random32() % 2) {
+      uint16_t rate = imuRates[random32() % 10];
+      request[3] = rate;
+      request[4] = rate >> 8;
+      request[5] = 1 << (random32() % 6);
+    }
+    if ((opcode == commandSetWindow || opcode == commandSetOutput) && length == 5 && random32() % 2) {
+      request[4] = random32() % 4;
+    }
+    if (length == 4 && random32() % 2) {
+      request[3] = random32() % 5;
+    }
+
+    commandConfig before = config;
+    uint8_t expected = expectedStatus(request);
+    result r = run(request, config);
+    TEST_ASSERT_EQUAL_UINT8(expected, r.status);
+    TEST_ASSERT_EQUAL_UINT8(commandVersion, r.response[0]);
+    if (length > 1) {
+      TEST_ASSERT_EQUAL_UINT8(request[1], r.response[1]);
+    }
+    TEST_ASSERT_TRUE(validConfig(config));
+    if (r.status != commandOk) {
+      TEST_ASSERT_EQUAL_UINT8(0, r.actions);
+      TEST_ASSERT_EQUAL_MEMORY(&before, &config, sizeof(config));
+      TEST_ASSERT_EQUAL_UINT(4, r.response.size());
+      continue;
+    }
+    accepted++;
+    TEST_ASSERT_EQUAL_MEMORY(&config, &r.response[4], sizeof(config));
+    // actions match what changed
+    TEST_ASSERT_EQUAL(before.imuRate != config.imuRate || before.imuRange != config.imuRange, !!(r.actions & commandActionImu));
+    TEST_ASSERT_EQUAL(before.window != config.window, !!(r.actions & commandActionWindow));
+    TEST_ASSERT_EQUAL(before.stream != config.stream, !!(r.actions & commandActionStream));
+    TEST_ASSERT_EQUAL(before.capture != config.capture, !!(r.actions & commandActionCapture));
+  }
+  TEST_ASSERT_GREATER_THAN(50000, accepted);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_get_config);
+  RUN_TEST(test_setters_and_actions);
+  RUN_TEST(test_repeated_request_changes_nothing);
+  RUN_TEST(test_rejects);
+  RUN_TEST(test_flash_config_validation);
+  RUN_TEST(test_fuzz);
+  return UNITY_END();
+}
@@ -0,0 +1,345 @@
+// Firmware update engine against a RAM slot: transfers with dropped links, resent
+// chunks and power cycles, and no flash erase outside erase()
+
+#include <unity.h>
+#include <vector>
+#include "dfuEngine.h"
+
+#define testSlot 0x89000
+#define testSlotSize 0x20000
+#define testPage 4096
+#define testApp 0x27000
+
+// Flash in RAM: programming only clears bits, erase sets a whole page
+class RamFlash : public SettingsFlash {
+  public:
+    std::vector<uint8_t> memory;
+    std::vector<uint32_t> erased;  // page addresses, in order
+    bool eraseAllowed = true;
+
+    RamFlash() : memory(testSlotSize, 0xFF) {}
+
+    void read(uint32_t address, void *data, uint32_t length) override {
+      TEST_ASSERT_TRUE(address >= testSlot && address + length <= testSlot + testSlotSize);
+      memcpy(data, &memory[address - testSlot], length);
+    }
+    void program(uint32_t address, const uint32_t *words, uint32_t count) override {
+      TEST_ASSERT_EQUAL_UINT32(0, address % 4);
+      TEST_ASSERT_TRUE(address >= testSlot && address + count * 4 <= testSlot + testSlotSize);
+      for (uint32_t i = 0; i < count * 4; i++) {
+        uint8_t &byte = memory[address - testSlot + i];
+        TEST_ASSERT_EQUAL_HEX8_MESSAGE(0xFF, byte | ((const uint8_t *)words)[i], "programmed a word that wasn't erased");
+        byte &= ((const uint8_t *)words)[i];
+      }
+    }
+    void erase(uint32_t page) override {
+      TEST_ASSERT_TRUE_MESSAGE(eraseAllowed, "page erased outside erase()");
+      TEST_ASSERT_EQUAL_UINT32(0, (page - testSlot) % testPage);
+      TEST_ASSERT_TRUE(page >= testSlot && page < testSlot + testSlotSize);
+      memset(&memory[page - testSlot], 0xFF, testPage);
+      erased.push_back(page);
+    }
+};
+
+static uint32_t state;
+static uint32_t random32() {
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+static void setVectors(std::vector<uint8_t> &bytes, uint32_t stack, uint32_t reset) {
+  memcpy(&bytes[0], &stack, 4);
+  memcpy(&bytes[4], &reset, 4);
+}
+
+static std::vector<uint8_t> image(uint32_t size) {
+  // random, behind a vector table that points into the installed image
+  std::vector<uint8_t> bytes(size);
+  for (auto &b : bytes) {
+    b = random32();
+  }
+  setVectors(bytes, 0x20040000, (testApp + size / 2) | 1);
+  return bytes;
+}
+
+static void start(DfuEngine &dfu, const std::vector<uint8_t> &bytes, dfuResponse *response, uint32_t crc = 0) {
+  uint8_t request[9] = { dfuStart };
+  uint32_t size = bytes.size();
+  if (!crc) {
+    crc = DfuEngine::crc32(bytes.data(), bytes.size());
+  }
+  memcpy(&request[1], &size, 4);
+  memcpy(&request[5], &crc, 4);
+  dfu.control(request, sizeof(request), response);
+}
+
+// Runs erase() until the slot is ready, as loop() does, returns the calls it took
+static uint32_t eraseAll(DfuEngine &dfu) {
+  for (uint32_t calls = 1; calls < 1000; calls++) {
+    if (dfu.erase()) {
+      return calls;
+    }
+  }
+  TEST_FAIL_MESSAGE("erase() never finished");
+  return 0;
+}
+
+static uint8_t send(DfuEngine &dfu, RamFlash &flash, const std::vector<uint8_t> &bytes, uint32_t offset, uint8_t count) {
+  uint8_t chunk[4 + dfuMaxChunk];
+  memcpy(chunk, &offset, 4);
+  memcpy(&chunk[4], &bytes[offset], count);
+  flash.eraseAllowed = false;  // never from the BLE write callback
+  uint8_t result = dfu.data(chunk, 4 + count);
+  flash.eraseAllowed = true;
+  return result;
+}
+
+static uint8_t control(DfuEngine &dfu, uint8_t opcode, dfuResponse *response) {
+  dfu.control(&opcode, 1, response);
+  return response->result;
+}
+
+void setUp(void) {
+  state = 1;
+}
+void tearDown(void) {}
+
+void test_crc32_matches_zlib(void) {
+  // no final xor, zlib's crc32("123456789") is 0xCBF43926
+  TEST_ASSERT_EQUAL_HEX32(0xCBF43926 ^ 0xFFFFFFFF, DfuEngine::crc32("123456789", 9));
+  uint32_t split = DfuEngine::crc32("12345", 5);
+  TEST_ASSERT_EQUAL_HEX32(0xCBF43926 ^ 0xFFFFFFFF, DfuEngine::crc32("6789", 4, split));
+}
+
+void test_start_is_answered_after_the_erase(void) {
+  RamFlash flash;
+  memset(flash.memory.data(), 0, flash.memory.size());  // an old image in the slot
+  DfuEngine dfu(flash, testSlot, testSlotSize, testPage, testApp, 0x60000);
+  dfu.begin(nullptr);
+  std::vector<uint8_t> bytes = image(3 * testPage + 100);
+  dfuResponse response;
+  start(dfu, bytes, &response);
+  TEST_ASSERT_EQUAL_UINT8(dfuOk, response.result);
+  TEST_ASSERT_EQUAL_UINT8(dfuErasing, dfu.state());
+  TEST_ASSERT_EQUAL_UINT(0, flash.erased.size());  // nothing erased in control()
+  // chunks before the answer are refused
+  TEST_ASSERT_EQUAL_UINT8(dfuNotStarted, send(dfu, flash, bytes, 0, 240));
+  // one page per call, only the pages the image needs
+  TEST_ASSERT_EQUAL_UINT32(5, eraseAll(dfu));
+  TEST_ASSERT_EQUAL_UINT(4, flash.erased.size());
+  for (uint32_t i = 0; i < 4; i++) {
+    TEST_ASSERT_EQUAL_HEX32(testSlot + i * testPage, flash.erased[i]);
+  }
+  TEST_ASSERT_EQUAL_UINT8(dfuReceiving, dfu.state());
+  TEST_ASSERT_FALSE(dfu.erase());  // true only once
+  TEST_ASSERT_EQUAL_HEX8(0, flash.memory[4 * testPage]);  // the rest of the slot is left alone
+}
+
+void test_blank_pages_are_skipped(void) {
+  RamFlash flash;
+  memset(&flash.memory[testPage], 0x55, 10);  // only page 1 holds anything
+  DfuEngine dfu(flash, testSlot, testSlotSize, testPage, testApp, 0x60000);
+  std::vector<uint8_t> bytes = image(8 * testPage);
+  dfuResponse response;
+  start(dfu, bytes, &response);
+  eraseAll(dfu);
+  TEST_ASSERT_EQUAL_UINT(1, flash.erased.size());
+  TEST_ASSERT_EQUAL_HEX32(testSlot + testPage, flash.erased[0]);
+}
+
+void test_refused_when_the_sketch_reaches_the_slot(void) {
+  RamFlash flash;
+  memset(flash.memory.data(), 0, flash.memory.size());
+  DfuEngine dfu(flash, testSlot, testSlotSize, testPage, testApp, testSlot + 4);
+  std::vector<uint8_t> bytes = image(1000);
+  dfuResponse response;
+  start(dfu, bytes, &response);
+  TEST_ASSERT_EQUAL_UINT8(dfuSlotInUse, response.result);
+  TEST_ASSERT_EQUAL_UINT8(dfuIdle, dfu.state());
+  TEST_ASSERT_FALSE(dfu.erase());
+  // and a saved transfer isn't resumed either
+  dfuProgress saved = { 1000, DfuEngine::crc32(bytes.data(), 1000), 0, 0xFFFFFFFF };
+  dfu.begin(&saved);
+  TEST_ASSERT_EQUAL_UINT8(dfuIdle, dfu.state());
+  TEST_ASSERT_FALSE(dfu.erase());
+  TEST_ASSERT_EQUAL_UINT(0, flash.erased.size());
+  // ending exactly at the slot is fine
+  DfuEngine fits(flash, testSlot, testSlotSize, testPage, testApp, testSlot);
+  start(fits, bytes, &response);
+  TEST_ASSERT_EQUAL_UINT8(dfuOk, response.result);
+}
+
+void test_control_checks(void) {
+  RamFlash flash;
+  DfuEngine dfu(flash, testSlot, testSlotSize, testPage, testApp, 0x60000);
+  dfuResponse response;
+  TEST_ASSERT_EQUAL_UINT8(dfuNotStarted, control(dfu, dfuInstall, &response));
+  TEST_ASSERT_EQUAL_UINT8(dfuBadOpcode, control(dfu, 9, &response));
+  TEST_ASSERT_EQUAL_UINT8(0x89, response.opcode);
+  uint8_t shortStart[5] = { dfuStart };
+  dfu.control(shortStart, sizeof(shortStart), &response);
+  TEST_ASSERT_EQUAL_UINT8(dfuBadLength, response.result);
+  std::vector<uint8_t> huge(testSlotSize + 1);
+  start(dfu, huge, &response, 1);
+  TEST_ASSERT_EQUAL_UINT8(dfuTooLarge, response.result);
+  TEST_ASSERT_EQUAL_UINT8(dfuIdle, response.state);
+}
+
+void test_chunk_checks(void) {
+  RamFlash flash;
+  DfuEngine dfu(flash, testSlot, testSlotSize, testPage, testApp, 0x60000);
+  std::vector<uint8_t> bytes = image(1002);
+  dfuResponse response;
+  start(dfu, bytes, &response);
+  eraseAll(dfu);
+  TEST_ASSERT_EQUAL_UINT8(dfuBadOffset, send(dfu, flash, bytes, 240, 240));
+  TEST_ASSERT_EQUAL_UINT8(dfuBadLength, send(dfu, flash, bytes, 0, 0));
+  TEST_ASSERT_EQUAL_UINT8(dfuBadLength, send(dfu, flash, bytes, 0, 238 + 1));  // not whole words
+  TEST_ASSERT_EQUAL_UINT8(dfuOk, send(dfu, flash, bytes, 0, 240));
+  TEST_ASSERT_EQUAL_UINT8(dfuBadOffset, send(dfu, flash, bytes, 0, 240));  // resent
+  for (uint32_t offset = 240; offset < 960; offset += 240) {
+    TEST_ASSERT_EQUAL_UINT8(dfuOk, send(dfu, flash, bytes, offset, 240));
+  }
+  TEST_ASSERT_EQUAL_UINT8(dfuIncomplete, control(dfu, dfuInstall, &response));
+  TEST_ASSERT_EQUAL_UINT8(dfuOk, send(dfu, flash, bytes, 960, 42));  // the odd sized last chunk
+  TEST_ASSERT_EQUAL_UINT8(dfuOk, control(dfu, dfuInstall, &response));
+  TEST_ASSERT_EQUAL_UINT8(dfuVerified, dfu.state());
+  TEST_ASSERT_EQUAL_MEMORY(bytes.data(), flash.memory.data(), bytes.size());
+}
+
+void test_bad_crc_starts_over(void) {
+  RamFlash flash;
+  DfuEngine dfu(flash, testSlot, testSlotSize, testPage, testApp, 0x60000);
+  std::vector<uint8_t> bytes = image(480);
+  dfuResponse response;
+  start(dfu, bytes, &response, 0x12345678);
+  eraseAll(dfu);
+  send(dfu, flash, bytes, 0, 240);
+  send(dfu, flash, bytes, 240, 240);
+  TEST_ASSERT_EQUAL_UINT8(dfuCrcError, control(dfu, dfuInstall, &response));
+  TEST_ASSERT_EQUAL_UINT8(dfuIdle, dfu.state());
+  TEST_ASSERT_TRUE(dfu.progressDue());
+  TEST_ASSERT_EQUAL_UINT32(0, dfu.progress().size);
+}
+
+void test_not_a_firmware_image_is_refused(void) {
+  // intact bytes, but a stack pointer outside RAM or a reset vector that isn't Thumb code
+  // inside the installed image: installing it would leave the board for the USB bootloader
+  struct {
+    uint32_t stack;
+    uint32_t reset;
+    uint8_t result;
+  } cases[] = {
+    { 0x20040000, testApp + 0x101, dfuOk },
+    { 0x20010000, testApp + 1, dfuOk },
+    { 0x20000000, testApp + 0x101, dfuBadImage },  // stack would start below RAM
+    { 0x20040004, testApp + 0x101, dfuBadImage },  // past the end of RAM
+    { 0x00000000, testApp + 0x101, dfuBadImage },
+    { 0x2003FFFE, testApp + 0x101, dfuBadImage },  // unaligned
+    { 0x20040000, testApp + 0x100, dfuBadImage },  // ARM, not Thumb
+    { 0x20040000, testApp - 0xFF, dfuBadImage },   // below the image
+    { 0x20040000, testApp + 2000 + 1, dfuBadImage },  // past its end
+    { 0x3A313030, 0x30303030, dfuBadImage },       // ":100000..." an Intel hex file
+    { 0x0A324655, 0x9E5D5157, dfuBadImage },       // a UF2 file
+  };
+  for (auto &c : cases) {
+    RamFlash flash;
+    DfuEngine dfu(flash, testSlot, testSlotSize, testPage, testApp, 0x60000);
+    std::vector<uint8_t> bytes = image(2000);
+    setVectors(bytes, c.stack, c.reset);
+    dfuResponse response;
+    start(dfu, bytes, &response);
+    eraseAll(dfu);
+    for (uint32_t offset = 0; offset < bytes.size(); offset += 200) {
+      TEST_ASSERT_EQUAL_UINT8(dfuOk, send(dfu, flash, bytes, offset, 200));
+    }
+    dfu.progressDue();
+    TEST_ASSERT_EQUAL_UINT8(c.result, control(dfu, dfuInstall, &response));
+    if (c.result == dfuOk) {
+      TEST_ASSERT_EQUAL_UINT8(dfuVerified, dfu.state());
+    }
+    else {
+      TEST_ASSERT_EQUAL_UINT8(dfuIdle, dfu.state());
+      TEST_ASSERT_TRUE(dfu.progressDue());
+      TEST_ASSERT_EQUAL_UINT32(0, dfu.progress().size);
+    }
+  }
+}
+
+void test_transfer_survives_drops_and_power_cycles(void) {
+  // a sender that reconnects, resends and loses power at random, many times over
+  for (uint32_t run = 0; run < 20; run++) {
+    RamFlash flash;
+    memset(flash.memory.data(), 0xA5, flash.memory.size());
+    std::vector<uint8_t> bytes = image(50001 + run * 997);
+    DfuEngine *dfu = new DfuEngine(flash, testSlot, testSlotSize, testPage, testApp, 0x60000);
+    dfu->begin(nullptr);
+    dfuProgress stored = {};
+    bool haveStored = false;
+    dfuResponse response;
+    start(*dfu, bytes, &response);
+    eraseAll(*dfu);
+    uint32_t offset = response.offset;
+    uint32_t resets = 0;
+    while (offset < bytes.size()) {
+      uint8_t count = bytes.size() - offset < 240 ? bytes.size() - offset : 240;
+      uint8_t result = send(*dfu, flash, bytes, offset, count);
+      if (dfu->progressDue()) {
+        stored = dfu->progress();
+        haveStored = true;
+      }
+      if (result == dfuBadOffset) {
+        dfu->status(0, result, &response);
+        offset = response.offset;
+        continue;
+      }
+      TEST_ASSERT_EQUAL_UINT8(dfuOk, result);
+      offset += count;
+      uint32_t event = random32() % 100;
+      if (event < 3) {
+        // power cycle: a new engine from the saved progress, then the sender starts again
+        delete dfu;
+        dfu = new DfuEngine(flash, testSlot, testSlotSize, testPage, testApp, 0x60000);
+        dfu->begin(haveStored ? &stored : nullptr);
+        start(*dfu, bytes, &response);
+        TEST_ASSERT_EQUAL_UINT8(dfuOk, response.result);
+        if (dfu->state() == dfuErasing) {
+          eraseAll(*dfu);
+        }
+        dfu->status(dfuStart, dfuOk, &response);
+        offset = response.offset;
+        TEST_ASSERT_EQUAL_UINT32(0, offset % testPage);  // from the top of the saved page
+        resets++;
+      }
+      else if (event < 6) {
+        // dropped link, same engine
+        start(*dfu, bytes, &response);
+        TEST_ASSERT_EQUAL_UINT8(dfuReceiving, dfu->state());
+        offset = response.offset;
+      }
+      else if (event < 8) {
+        offset = offset > 480 ? offset - 480 : 0;  // the sender resends old chunks
+      }
+    }
+    TEST_ASSERT_GREATER_THAN(0, resets);
+    TEST_ASSERT_EQUAL_UINT8(dfuOk, control(*dfu, dfuInstall, &response));
+    TEST_ASSERT_EQUAL_MEMORY(bytes.data(), flash.memory.data(), bytes.size());
+    delete dfu;
+  }
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_crc32_matches_zlib);
+  RUN_TEST(test_start_is_answered_after_the_erase);
+  RUN_TEST(test_blank_pages_are_skipped);
+  RUN_TEST(test_refused_when_the_sketch_reaches_the_slot);
+  RUN_TEST(test_control_checks);
+  RUN_TEST(test_chunk_checks);
+  RUN_TEST(test_bad_crc_starts_over);
+  RUN_TEST(test_not_a_firmware_image_is_refused);
+  RUN_TEST(test_transfer_survives_drops_and_power_cycles);
+  return UNITY_END();
+}
@@ -0,0 +1,165 @@
+// Bytes and I2C transactions per 128x64 OLED frame: write_chunked() (a copying chunked
+// write) and display() on the stub Wire, the queue on 32 and 256 byte buses, and the
+// zero-copy transfer the firmware uses (TwimI2cBus::startDirect())
+
+#include <unity.h>
+#include <string>
+#include <Adafruit_I2CDevice.h>
+#include <Adafruit_SSD1306.h>
+#include "i2cQueue.h"
+
+#define frameBytes (128 * 64 / 8)
+
+// Counts transfers and bytes on the wire (address byte included), never busy
+class CountingBus : public I2cBus {
+  public:
+    uint16_t bufferSize;
+    bool direct;
+    uint32_t transfers = 0;
+    uint32_t bytes = 0;
+    std::string data;  // everything after the control bytes
+
+    CountingBus(uint16_t bufferSize, bool direct) : bufferSize(bufferSize), direct(direct) {}
+    uint16_t maxTransfer(uint8_t prefixLength) override { return bufferSize - prefixLength; }
+    bool start(uint8_t, const uint8_t *prefix, uint8_t prefixLength, const uint8_t *run, uint16_t length, uint8_t *, uint16_t) override {
+      TEST_ASSERT_TRUE(prefixLength + length <= bufferSize);
+      TEST_ASSERT_EQUAL_HEX8(0x40, prefix[0]);
+      count(prefixLength + length);
+      data.append((const char *)run, length);
+      return true;
+    }
+    uint8_t poll() override { return i2cDone; }
+    void setClock(uint32_t) override {}
+    uint16_t maxDirect(const uint8_t *) override { return direct ? 0xFFFF : 0; }
+    bool startDirect(uint8_t, const uint8_t *run, uint16_t length, uint8_t *, uint16_t) override {
+      TEST_ASSERT_EQUAL_HEX8(0x40, run[0]);
+      count(length);
+      data.append((const char *)run + 1, length - 1);
+      return true;
+    }
+
+  private:
+    void count(uint32_t length) {
+      transfers++;
+      bytes += 1 + length;
+    }
+};
+
+static uint8_t pattern[frameBytes];
+
+// Bytes on the stub Wire since the last reset, address bytes included
+static uint32_t wireBytes() {
+  uint32_t bytes = 0;
+  for (auto &t : Wire.transactions) {
+    bytes += t.size();
+  }
+  return bytes;
+}
+
+void setUp(void) {
+  for (uint16_t i = 0; i < frameBytes; i++) {
+    pattern[i] = i * 13 + (i >> 8);
+  }
+  Wire.reset();
+}
+void tearDown(void) {}
+
+void test_write_chunked_sends_any_length(void) {
+  Adafruit_I2CDevice device(0x3C, &Wire);
+  device.begin(false);
+  uint8_t control = 0x40;
+  TEST_ASSERT_FALSE(device.write(pattern, frameBytes, true, &control, 1));  // write() still refuses
+  TEST_ASSERT_EQUAL_UINT(0, Wire.transactions.size());
+  TEST_ASSERT_TRUE(device.write_chunked(pattern, frameBytes, &control, 1));
+  TEST_ASSERT_EQUAL_UINT(5, Wire.transactions.size());  // 4 x 255 + 4
+  std::string sent;
+  for (auto &t : Wire.transactions) {
+    TEST_ASSERT_TRUE(t.size() <= 1 + device.maxBufferSize());
+    TEST_ASSERT_EQUAL_HEX8(0x3C, t[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x40, t[1]);
+    sent.append(t.begin() + 2, t.end());
+  }
+  TEST_ASSERT_EQUAL_UINT(frameBytes, sent.size());
+  TEST_ASSERT_EQUAL_MEMORY(pattern, sent.data(), frameBytes);
+  TEST_ASSERT_EQUAL_UINT32(1034, wireBytes());
+  // a short write is one transaction, a prefix that fills the buffer is refused
+  Wire.reset();
+  TEST_ASSERT_TRUE(device.write_chunked(pattern, 10, &control, 1));
+  TEST_ASSERT_EQUAL_UINT(1, Wire.transactions.size());
+  uint8_t prefix[256] = {};
+  TEST_ASSERT_FALSE(device.write_chunked(pattern, 10, prefix, sizeof(prefix)));
+}
+
+void test_display_frame_on_wire(void) {
+  Adafruit_SSD1306 display(128, 64, &Wire);
+  TEST_ASSERT_TRUE(display.begin(SSD1306_SWITCHCAPVCC, 0x3C, false, true));
+  memcpy(display.getBuffer(), pattern, frameBytes);
+  Wire.reset();
+  display.display();
+  // the addressing commands, then the frame in Wire buffer sized transactions
+  std::string sent;
+  uint32_t frameTransactions = 0;
+  uint32_t frameBytesOnWire = 0;
+  for (auto &t : Wire.transactions) {
+    if (t[1] == 0x40) {
+      frameTransactions++;
+      frameBytesOnWire += t.size();
+      sent.append(t.begin() + 2, t.end());
+    }
+  }
+  TEST_ASSERT_EQUAL_UINT32(5, frameTransactions);
+  TEST_ASSERT_EQUAL_UINT32(1034, frameBytesOnWire);
+  TEST_ASSERT_EQUAL_MEMORY(pattern, sent.data(), frameBytes);
+}
+
+void test_control_byte_sits_before_the_framebuffer(void) {
+  Adafruit_SSD1306 display(128, 64, &Wire);
+  display.begin(SSD1306_SWITCHCAPVCC, 0x3C, false, true);
+  display.clearDisplay();
+  display.fillScreen(SSD1306_WHITE);
+  TEST_ASSERT_EQUAL_HEX8(0x40, display.getBuffer()[-1]);  // drawing never touches it
+}
+
+static void sendFrame(CountingBus &bus, const uint8_t *frame) {
+  I2cQueue queue(bus);
+  i2cTransaction transaction;
+  transaction.address = 0x3C;
+  transaction.prefix[0] = 0x40;
+  transaction.prefixLength = 1;
+  transaction.data = frame;
+  transaction.length = frameBytes;
+  transaction.prefixed = true;
+  queue.submit(transaction);
+  while (!queue.idle()) {
+    queue.service();
+  }
+  TEST_ASSERT_EQUAL_UINT8(i2cDone, transaction.status);
+  TEST_ASSERT_EQUAL_UINT(frameBytes, bus.data.size());
+  TEST_ASSERT_EQUAL_MEMORY(frame, bus.data.data(), frameBytes);
+}
+
+void test_queue_frame_cost(void) {
+  // the OLED frame transaction as main.cpp sets it up, straight from the display's buffer
+  Adafruit_SSD1306 display(128, 64, &Wire);
+  display.begin(SSD1306_SWITCHCAPVCC, 0x3C, false, true);
+  memcpy(display.getBuffer(), pattern, frameBytes);
+  CountingBus wire32(32, false), wire256(256, false), twim(256, true);
+  sendFrame(wire32, display.getBuffer());
+  sendFrame(wire256, display.getBuffer());
+  sendFrame(twim, display.getBuffer());
+  TEST_ASSERT_EQUAL_UINT32(34, wire32.transfers);  // 1024 / 31 per transfer
+  TEST_ASSERT_EQUAL_UINT32(1092, wire32.bytes);
+  TEST_ASSERT_EQUAL_UINT32(5, wire256.transfers);
+  TEST_ASSERT_EQUAL_UINT32(1034, wire256.bytes);
+  TEST_ASSERT_EQUAL_UINT32(1, twim.transfers);  // zero-copy, one 1025 byte EasyDMA run
+  TEST_ASSERT_EQUAL_UINT32(1026, twim.bytes);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_write_chunked_sends_any_length);
+  RUN_TEST(test_display_frame_on_wire);
+  RUN_TEST(test_control_byte_sits_before_the_framebuffer);
+  RUN_TEST(test_queue_frame_cost);
+  return UNITY_END();
+}
@@ -0,0 +1,345 @@
+// I2C transaction queue against a mock bus that takes the real 400 kHz time per
+// byte: order, priority, chunking, failures, and the sensor read latency while a
+// display frame is going out
+
+#include <unity.h>
+#include <string>
+#include <vector>
+#include "i2cQueue.h"
+
+static uint32_t now;  // usec
+
+// One transfer at a time, busy for 9 bit times per byte (plus START/address)
+class MockBus : public I2cBus {
+  public:
+    struct transfer {
+      uint8_t address;
+      std::vector<uint8_t> bytes;  // prefix + data
+      uint16_t readLength;
+      bool direct;
+    };
+    std::vector<transfer> transfers;
+    uint32_t hz = 400000;
+    uint16_t bufferSize = 256;
+    uint16_t directSize = 0;  // zero-copy reach, 0 = none
+    int failAt = -1;  // transfer that gets a NACK
+    uint32_t busyUntil = 0;
+    bool running = false;
+    uint8_t result = i2cDone;
+
+    uint16_t maxTransfer(uint8_t prefixLength) override { return bufferSize - prefixLength; }
+    bool start(uint8_t address, const uint8_t *prefix, uint8_t prefixLength,
+               const uint8_t *data, uint16_t length, uint8_t *readData, uint16_t readLength) override {
+      std::vector<uint8_t> bytes(prefix, prefix + prefixLength);
+      bytes.insert(bytes.end(), data, data + length);
+      return begin(address, bytes, readData, readLength, false);
+    }
+    uint8_t poll() override {
+      if (running && (int32_t)(now - busyUntil) >= 0) {
+        running = false;
+      }
+      return running ? (uint8_t)i2cRunning : result;
+    }
+    void setClock(uint32_t clock) override { hz = clock; }
+    uint16_t maxDirect(const uint8_t *) override { return directSize; }
+    bool startDirect(uint8_t address, const uint8_t *run, uint16_t length, uint8_t *readData, uint16_t readLength) override {
+      return begin(address, std::vector<uint8_t>(run, run + length), readData, readLength, true);
+    }
+
+  private:
+    bool begin(uint8_t address, const std::vector<uint8_t> &bytes, uint8_t *readData, uint16_t readLength, bool direct) {
+      TEST_ASSERT_FALSE_MESSAGE(running, "transfer started while the bus was busy");
+      TEST_ASSERT_TRUE(bytes.size() <= (direct ? directSize : bufferSize));
+      for (uint16_t i = 0; i < readLength; i++) {
+        readData[i] = address + i;
+      }
+      result = (int)transfers.size() == failAt ? i2cFailed : i2cDone;
+      transfers.push_back({ address, bytes, readLength, direct });
+      busyUntil = now + (bytes.size() + readLength + 2) * 9 * 1000000ull / hz;
+      running = true;
+      return true;
+    }
+};
+
+static std::vector<uint16_t> finished;  // order of the completion callbacks
+static void recordDone(i2cTransaction &transaction) {
+  finished.push_back(transaction.order);
+}
+
+static MockBus *bus;
+static I2cQueue *queue;
+
+// Calls service() every `period` usec until the queue is idle or `limit` passes
+static void runFor(uint32_t limit, uint32_t period = 100) {
+  uint32_t end = now + limit;
+  while (!queue->idle() && (int32_t)(now - end) < 0) {
+    queue->service();
+    now += period;
+  }
+}
+
+static void display(i2cTransaction &transaction, const uint8_t *frame, uint16_t length) {
+  transaction.address = 0x3C;
+  transaction.priority = i2cPriorityDisplay;
+  transaction.prefix[0] = 0x40;
+  transaction.prefixLength = 1;
+  transaction.data = frame;
+  transaction.length = length;
+  transaction.done = recordDone;
+}
+
+static void sensorRead(i2cTransaction &transaction, uint8_t *buffer, uint16_t length) {
+  static uint8_t reg = 0x22;  // OUTX_L_G
+  transaction.address = 0x6A;
+  transaction.priority = i2cPrioritySensor;
+  transaction.data = &reg;
+  transaction.length = 1;
+  transaction.readData = buffer;
+  transaction.readLength = length;
+  transaction.done = recordDone;
+}
+
+void setUp(void) {
+  now = 0;
+  finished.clear();
+  bus = new MockBus();
+  queue = new I2cQueue(*bus);
+}
+void tearDown(void) {
+  delete queue;
+  delete bus;
+}
+
+void test_frame_is_chunked_with_the_prefix(void) {
+  uint8_t frame[1024];
+  for (uint16_t i = 0; i < sizeof(frame); i++) {
+    frame[i] = i * 7;
+  }
+  i2cTransaction transaction;
+  display(transaction, frame, sizeof(frame));
+  TEST_ASSERT_TRUE(queue->submit(transaction));
+  TEST_ASSERT_FALSE(queue->submit(transaction));  // already queued
+  runFor(100000);
+  TEST_ASSERT_EQUAL_UINT8(i2cDone, transaction.status);
+  TEST_ASSERT_EQUAL_UINT(5, bus->transfers.size());  // 4 x 255 + 4
+  std::string sent;
+  for (auto &t : bus->transfers) {
+    TEST_ASSERT_EQUAL_HEX8(0x40, t.bytes[0]);
+    sent.append(t.bytes.begin() + 1, t.bytes.end());
+  }
+  TEST_ASSERT_EQUAL_UINT(sizeof(frame), sent.size());
+  TEST_ASSERT_EQUAL_MEMORY(frame, sent.data(), sizeof(frame));
+  TEST_ASSERT_EQUAL_UINT32(1, queue->completed);
+}
+
+void test_zero_copy_frame_is_one_transfer(void) {
+  uint8_t run[1 + 1024] = { 0x40 };
+  i2cTransaction transaction;
+  display(transaction, &run[1], 1024);
+  transaction.prefixed = true;
+  bus->directSize = 0xFFFF;
+  queue->submit(transaction);
+  runFor(100000);
+  TEST_ASSERT_EQUAL_UINT8(i2cDone, transaction.status);
+  TEST_ASSERT_EQUAL_UINT(1, bus->transfers.size());
+  TEST_ASSERT_TRUE(bus->transfers[0].direct);
+  TEST_ASSERT_EQUAL_UINT(1025, bus->transfers[0].bytes.size());
+  // a bus that can't reach the buffer gets the chunks instead
+  bus->directSize = 0;
+  bus->transfers.clear();
+  queue->submit(transaction);
+  runFor(100000);
+  TEST_ASSERT_EQUAL_UINT(5, bus->transfers.size());
+}
+
+void test_same_priority_keeps_order(void) {
+  uint8_t frames[3][300];
+  i2cTransaction transactions[3];
+  for (uint8_t i = 0; i < 3; i++) {
+    memset(frames[i], i, sizeof(frames[i]));
+    display(transactions[i], frames[i], sizeof(frames[i]));
+    queue->submit(transactions[i]);
+  }
+  runFor(100000);
+  TEST_ASSERT_EQUAL_UINT(3, finished.size());
+  for (uint8_t i = 0; i < 3; i++) {
+    TEST_ASSERT_EQUAL_UINT16(transactions[i].order, finished[i]);
+  }
+  // chunks of one transaction never interleave with the next of the same priority
+  for (uint8_t i = 0; i < 6; i++) {
+    TEST_ASSERT_EQUAL_HEX8(i / 2, bus->transfers[i].bytes[1]);
+  }
+}
+
+void test_sensor_read_goes_between_chunks(void) {
+  uint8_t frame[1024] = {};
+  uint8_t reading[12];
+  i2cTransaction frameTransaction, readTransaction;
+  display(frameTransaction, frame, sizeof(frame));
+  sensorRead(readTransaction, reading, sizeof(reading));
+  queue->submit(frameTransaction);
+  queue->service();  // first chunk on the bus
+  queue->submit(readTransaction);
+  runFor(100000);
+  TEST_ASSERT_EQUAL_UINT(6, bus->transfers.size());
+  TEST_ASSERT_EQUAL_HEX8(0x3C, bus->transfers[0].address);
+  TEST_ASSERT_EQUAL_HEX8(0x6A, bus->transfers[1].address);  // right after the running chunk
+  TEST_ASSERT_EQUAL_UINT16(12, bus->transfers[1].readLength);
+  TEST_ASSERT_EQUAL_HEX8(0x6A + 11, reading[11]);
+  TEST_ASSERT_EQUAL_UINT16(readTransaction.order, finished[0]);
+}
+
+void test_sensor_latency_while_the_display_flushes(void) {
+  // a frame after every finished one, and a 12 byte gyro/accel read at 208 Hz: the
+  // read waits at most for the chunk on the bus, whatever the display is doing
+  static uint8_t frame[1024];
+  uint8_t reading[12];
+  i2cTransaction frameTransaction, readTransaction;
+  display(frameTransaction, frame, sizeof(frame));
+  frameTransaction.chunkSize = 64;
+  sensorRead(readTransaction, reading, sizeof(reading));
+  const uint32_t period = 100;  // usec between service() calls
+  const uint32_t chunkTime = (1 + 64 + 2) * 9 * 1000000ull / 400000;
+  const uint32_t readTime = (1 + 12 + 2) * 9 * 1000000ull / 400000;
+  uint32_t submitted = 0;
+  uint32_t worst = 0;
+  uint32_t reads = 0;
+  uint32_t frames = 0;
+  for (now = 0; now < 2000000; now += period) {
+    if (frameTransaction.status != i2cQueued && frameTransaction.status != i2cRunning) {
+      frames += frameTransaction.status == i2cDone;
+      queue->submit(frameTransaction);
+    }
+    if (now % 4800 == 0) {
+      TEST_ASSERT_TRUE_MESSAGE(readTransaction.status != i2cQueued && readTransaction.status != i2cRunning, "read still pending at the next sample");
+      queue->submit(readTransaction);
+      submitted = now;
+    }
+    queue->service();
+    if (readTransaction.status == i2cDone && submitted != UINT32_MAX) {
+      worst = max(worst, now - submitted);
+      submitted = UINT32_MAX;
+      reads++;
+    }
+  }
+  TEST_ASSERT_EQUAL_UINT32(417, reads);
+  TEST_ASSERT_LESS_OR_EQUAL(chunkTime + readTime + 2 * period, worst);
+  TEST_ASSERT_GREATER_THAN(50, frames);  // and the display still runs at ~40 fps
+  TEST_ASSERT_EQUAL_UINT32(0, queue->failed);
+}
+
+void test_failure_stops_the_transaction(void) {
+  uint8_t frame[1024] = {};
+  uint8_t reading[6];
+  i2cTransaction frameTransaction, readTransaction;
+  display(frameTransaction, frame, sizeof(frame));
+  sensorRead(readTransaction, reading, sizeof(reading));
+  bus->failAt = 2;  // the read goes first, then the second chunk is not acknowledged
+  queue->submit(frameTransaction);
+  queue->submit(readTransaction);
+  runFor(100000);
+  TEST_ASSERT_EQUAL_UINT8(i2cFailed, frameTransaction.status);
+  TEST_ASSERT_EQUAL_UINT8(i2cDone, readTransaction.status);
+  TEST_ASSERT_EQUAL_UINT(3, bus->transfers.size());  // read, chunk, failed chunk
+  TEST_ASSERT_EQUAL_UINT32(1, queue->failed);
+  TEST_ASSERT_EQUAL_UINT32(2, queue->completed);
+  // a read that can never fit the bus fails without a transfer
+  uint8_t big[300];
+  sensorRead(readTransaction, big, sizeof(big));
+  queue->submit(readTransaction);
+  runFor(1000);
+  TEST_ASSERT_EQUAL_UINT8(i2cFailed, readTransaction.status);
+  TEST_ASSERT_EQUAL_UINT(3, bus->transfers.size());
+}
+
+static i2cTransaction *again;
+static void resubmit(i2cTransaction &transaction) {
+  recordDone(transaction);
+  if (finished.size() < 5) {
+    TEST_ASSERT_TRUE(queue->submit(*again));
+  }
+}
+
+void test_queue_limits_and_resubmit(void) {
+  uint8_t data[4] = {};
+  i2cTransaction transactions[i2cQueueLength + 1];
+  for (uint8_t i = 0; i < i2cQueueLength; i++) {
+    display(transactions[i], data, sizeof(data));
+    TEST_ASSERT_TRUE(queue->submit(transactions[i]));
+  }
+  display(transactions[i2cQueueLength], data, sizeof(data));
+  TEST_ASSERT_FALSE(queue->submit(transactions[i2cQueueLength]));
+  TEST_ASSERT_FALSE(queue->setBus(*bus));  // not while busy
+  runFor(100000);
+  TEST_ASSERT_TRUE(queue->setBus(*bus));
+  // the callback may submit again, from service()
+  finished.clear();
+  i2cTransaction looping;
+  display(looping, data, sizeof(data));
+  looping.done = resubmit;
+  again = &looping;
+  queue->submit(looping);
+  runFor(100000);
+  TEST_ASSERT_EQUAL_UINT(5, finished.size());
+  TEST_ASSERT_TRUE(queue->idle());
+}
+
+void test_order_survives_wrap(void) {
+  // submit orders are 16 bit, the oldest still goes first across the wrap
+  uint8_t data[1] = {};
+  i2cTransaction first, second;
+  display(first, data, 1);
+  display(second, data, 1);
+  for (uint32_t i = 0; i < 65535; i++) {
+    queue->submit(first);
+    runFor(1000);
+  }
+  queue->submit(first);  // order 65535
+  queue->submit(second);  // order 0
+  finished.clear();
+  runFor(1000);
+  TEST_ASSERT_EQUAL_UINT(2, finished.size());
+  TEST_ASSERT_EQUAL_UINT16(65535, finished[0]);
+  TEST_ASSERT_EQUAL_UINT16(0, finished[1]);
+}
+
+void test_wire_backend(void) {
+  uint8_t registers[256] = {};
+  for (uint16_t i = 0; i < 256; i++) {
+    registers[i] = i ^ 0x5A;
+  }
+  Wire.reset();
+  Wire.registers = registers;
+  WireI2cBus wireBus(Wire);
+  queue->setBus(wireBus);
+  uint8_t reading[12];
+  i2cTransaction transaction;
+  sensorRead(transaction, reading, sizeof(reading));
+  queue->submit(transaction);
+  runFor(1000);
+  TEST_ASSERT_EQUAL_UINT8(i2cDone, transaction.status);
+  TEST_ASSERT_EQUAL_UINT(1, Wire.transactions.size());
+  TEST_ASSERT_EQUAL_MEMORY(&registers[0x22], reading, sizeof(reading));
+  // a frame goes out in Wire buffer sized chunks
+  uint8_t frame[1024] = {};
+  display(transaction, frame, sizeof(frame));
+  queue->submit(transaction);
+  runFor(1000);
+  TEST_ASSERT_EQUAL_UINT(1 + 5, Wire.transactions.size());
+  TEST_ASSERT_EQUAL_UINT(1 + i2cWireBuffer, Wire.transactions[1].size());  // address byte too
+  Wire.registers = nullptr;
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_frame_is_chunked_with_the_prefix);
+  RUN_TEST(test_zero_copy_frame_is_one_transfer);
+  RUN_TEST(test_same_priority_keeps_order);
+  RUN_TEST(test_sensor_read_goes_between_chunks);
+  RUN_TEST(test_sensor_latency_while_the_display_flushes);
+  RUN_TEST(test_failure_stops_the_transaction);
+  RUN_TEST(test_queue_limits_and_resubmit);
+  RUN_TEST(test_order_survives_wrap);
+  RUN_TEST(test_wire_backend);
+  return UNITY_END();
+}
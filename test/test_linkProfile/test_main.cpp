@@ -0,0 +1,198 @@
+// Link manager request sequencing against a mock controller
+
+#include <unity.h>
+#include <string>
+#include <vector>
+#include "linkProfile.h"
+
+#define phone "a4:c1:38:00:00:01"
+#define laptop "a4:c1:38:00:00:02"
+
+// Records every request, handles come from a small address table
+class MockControl : public LinkControl {
+  public:
+    struct request {
+      char type;  // 'C'onnection parameters, 'P'hy, 'D'ata length
+      uint16_t handle;
+      uint32_t value;  // interval max, phy or length
+    };
+    std::vector<request> requests;
+    bool laptopKnown = true;  // false = the stack doesn't have the handle yet
+    uint8_t phyStatus = 0;
+
+    uint16_t handle(const char *address) override {
+      if (!strcmp(address, phone)) {
+        return 0x40;
+      }
+      if (!strcmp(address, laptop) && laptopKnown) {
+        return 0x41;
+      }
+      return linkNoHandle;
+    }
+    uint8_t setParameters(uint16_t handle, const linkSettings &settings) override {
+      requests.push_back({ 'C', handle, settings.intervalMax });
+      return 0;
+    }
+    uint8_t setPhy(uint16_t handle, uint8_t phy) override {
+      requests.push_back({ 'P', handle, phy });
+      return phyStatus;
+    }
+    uint8_t setDataLength(uint16_t handle, uint16_t length) override {
+      requests.push_back({ 'D', handle, length });
+      return 0;
+    }
+};
+
+// Runs service() every 10ms, returns the msec of each request sent
+static std::vector<uint32_t> run(LinkManager &manager, uint32_t from, uint32_t to) {
+  std::vector<uint32_t> times;
+  for (uint32_t now = from; now < to; now += 10) {
+    if (manager.service(now)) {
+      times.push_back(now);
+    }
+  }
+  return times;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_settings_are_valid(void) {
+  // the controller rejects timeouts shorter than (1 + latency) * interval * 2
+  for (uint8_t profile = 0; profile < linkProfileCount; profile++) {
+    const linkSettings &s = LinkManager::settings[profile];
+    TEST_ASSERT_GREATER_OR_EQUAL(6, s.intervalMin);
+    TEST_ASSERT_LESS_OR_EQUAL(3200, s.intervalMax);
+    TEST_ASSERT_LESS_OR_EQUAL(s.intervalMax, s.intervalMin);
+    TEST_ASSERT_GREATER_THAN((1 + s.latency) * s.intervalMax * 125 * 2 / 1000, s.timeout);
+  }
+}
+
+void test_connection_sends_three_spaced_requests(void) {
+  MockControl control;
+  LinkManager manager(control);
+  manager.connect(phone, 1000);
+  std::vector<uint32_t> times = run(manager, 1000, 2000);
+  TEST_ASSERT_EQUAL_UINT(3, control.requests.size());
+  TEST_ASSERT_EQUAL_UINT(3, times.size());
+  // waits requestGap after the connection, then one per requestGap
+  TEST_ASSERT_EQUAL_UINT32(1100, times[0]);
+  TEST_ASSERT_EQUAL_UINT32(1200, times[1]);
+  TEST_ASSERT_EQUAL_UINT32(1300, times[2]);
+  TEST_ASSERT_EQUAL_INT('C', control.requests[0].type);
+  TEST_ASSERT_EQUAL_UINT32(LinkManager::settings[linkProfileLowPower].intervalMax, control.requests[0].value);
+  TEST_ASSERT_EQUAL_INT('P', control.requests[1].type);
+  TEST_ASSERT_EQUAL_UINT32(linkPhy, control.requests[1].value);
+  TEST_ASSERT_EQUAL_INT('D', control.requests[2].type);
+  TEST_ASSERT_EQUAL_UINT32(linkDataLength, control.requests[2].value);
+  for (auto &r : control.requests) {
+    TEST_ASSERT_EQUAL_HEX16(0x40, r.handle);
+  }
+}
+
+void test_profile_switch_only_resends_parameters(void) {
+  MockControl control;
+  LinkManager manager(control);
+  manager.connect(phone, 0);
+  manager.connect(laptop, 0);
+  run(manager, 0, 1000);
+  TEST_ASSERT_EQUAL_UINT(6, control.requests.size());
+  control.requests.clear();
+
+  manager.setProfile(linkProfileLowLatency);
+  manager.setProfile(linkProfileLowLatency);  // no change, nothing more
+  run(manager, 1000, 2000);
+  TEST_ASSERT_EQUAL_UINT(2, control.requests.size());
+  for (auto &r : control.requests) {
+    TEST_ASSERT_EQUAL_INT('C', r.type);
+    TEST_ASSERT_EQUAL_UINT32(LinkManager::settings[linkProfileLowLatency].intervalMax, r.value);
+  }
+  TEST_ASSERT_NOT_EQUAL(control.requests[0].handle, control.requests[1].handle);
+  TEST_ASSERT_EQUAL_UINT8(linkProfileLowLatency, manager.profile());
+  manager.setProfile(linkProfileCount);  // out of range is ignored
+  TEST_ASSERT_EQUAL_UINT8(linkProfileLowLatency, manager.profile());
+}
+
+void test_one_request_per_service_call(void) {
+  // two links connected together never get requests in the same loop
+  MockControl control;
+  LinkManager manager(control);
+  manager.connect(phone, 0);
+  manager.connect(laptop, 0);
+  for (uint32_t now = 0; now < 2000; now++) {
+    size_t before = control.requests.size();
+    manager.service(now);
+    TEST_ASSERT_LESS_OR_EQUAL(before + 1, control.requests.size());
+  }
+  TEST_ASSERT_EQUAL_UINT(6, control.requests.size());
+}
+
+void test_handle_is_looked_up_later(void) {
+  // the connect event can come before the stack has the handle, requests wait for it
+  MockControl control;
+  control.laptopKnown = false;
+  LinkManager manager(control);
+  manager.connect(laptop, 0);
+  run(manager, 0, 500);
+  TEST_ASSERT_EQUAL_UINT(0, control.requests.size());
+  control.laptopKnown = true;
+  run(manager, 500, 1000);
+  TEST_ASSERT_EQUAL_UINT(3, control.requests.size());
+  TEST_ASSERT_EQUAL_HEX16(0x41, control.requests[0].handle);
+}
+
+void test_diagnostics(void) {
+  MockControl control;
+  control.phyStatus = 0x11;  // unsupported feature
+  LinkManager manager(control);
+  linkDiagnostics report;
+  manager.diagnostics(&report);
+  TEST_ASSERT_EQUAL_UINT8(1, report.version);
+  TEST_ASSERT_EQUAL_UINT8(0, report.links);
+  TEST_ASSERT_EQUAL_UINT8(linkNotRequested, report.parameterStatus);
+  TEST_ASSERT_EQUAL_UINT(17, sizeof(report));  // packed, the characteristic size
+
+  manager.connect(phone, 0);
+  run(manager, 0, 1000);
+  manager.connect(laptop, 1000);
+  manager.diagnostics(&report);
+  TEST_ASSERT_EQUAL_UINT8(2, report.links);
+  TEST_ASSERT_EQUAL_UINT8(linkNotRequested, report.phyStatus);  // the newest link's, not sent yet
+  run(manager, 1000, 2000);
+  manager.diagnostics(&report);
+  TEST_ASSERT_EQUAL_UINT8(0, report.parameterStatus);
+  TEST_ASSERT_EQUAL_UINT8(0x11, report.phyStatus);
+  TEST_ASSERT_EQUAL_UINT8(0, report.dataLengthStatus);
+  TEST_ASSERT_EQUAL_UINT16(LinkManager::settings[linkProfileLowPower].intervalMin, report.intervalMin);
+  TEST_ASSERT_EQUAL_UINT16(linkDataLength, report.dataLength);
+
+  manager.disconnect(laptop);
+  manager.diagnostics(&report);
+  TEST_ASSERT_EQUAL_UINT8(1, report.links);
+  TEST_ASSERT_EQUAL_UINT8(linkNotRequested, report.parameterStatus);
+}
+
+void test_reconnect_starts_over(void) {
+  MockControl control;
+  LinkManager manager(control);
+  manager.connect(phone, 0);
+  run(manager, 0, 1000);
+  manager.disconnect(phone);
+  run(manager, 1000, 2000);
+  TEST_ASSERT_EQUAL_UINT(3, control.requests.size());
+  manager.connect(phone, 2000);
+  run(manager, 2000, 3000);
+  TEST_ASSERT_EQUAL_UINT(6, control.requests.size());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_settings_are_valid);
+  RUN_TEST(test_connection_sends_three_spaced_requests);
+  RUN_TEST(test_profile_switch_only_resends_parameters);
+  RUN_TEST(test_one_request_per_service_call);
+  RUN_TEST(test_handle_is_looked_up_later);
+  RUN_TEST(test_diagnostics);
+  RUN_TEST(test_reconnect_starts_over);
+  return UNITY_END();
+}
@@ -0,0 +1,196 @@
+#ifndef DEJAVU_SANS_BOLD_13PT_H
+#define DEJAVU_SANS_BOLD_13PT_H
+
+// The readout font as a regular GFXfont, the reference drawPageText() is checked
+// against. Generated with
+//   fontconvert DejaVuSans-Bold.ttf 13 32 176
+// then trimmed to the characters bigDigitsFont.h holds, the other glyphs are empty.
+
+#include <Adafruit_GFX.h>
+
+const uint8_t DejaVuSans_Bold13pt8bBitmaps[] PROGMEM = {
+  0x00, 0x03, 0x80, 0x07, 0x00, 0x0E, 0x00, 0x1C, 0x00, 0x38, 0x00, 0x70,
+  0x3F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFE, 0x07, 0x00, 0x0E, 0x00, 0x1C, 0x00,
+  0x38, 0x00, 0x70, 0x00, 0xE0, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xF0, 0x07, 0xC0, 0x3F, 0xE0, 0xFF, 0xE3, 0xE3, 0xE7, 0x83, 0xDE, 0x03,
+  0xFC, 0x07, 0xF8, 0x0F, 0xF0, 0x1F, 0xE0, 0x3F, 0xC0, 0x7F, 0x80, 0xFF,
+  0x01, 0xEF, 0x07, 0x9F, 0x1F, 0x1F, 0xFC, 0x1F, 0xF0, 0x1F, 0xC0, 0x3F,
+  0x0F, 0xF0, 0xFF, 0x0C, 0xF0, 0x0F, 0x00, 0xF0, 0x0F, 0x00, 0xF0, 0x0F,
+  0x00, 0xF0, 0x0F, 0x00, 0xF0, 0x0F, 0x00, 0xF0, 0x0F, 0x0F, 0xFF, 0xFF,
+  0xFF, 0xFF, 0x3F, 0x87, 0xFF, 0x3F, 0xFD, 0xC1, 0xF8, 0x07, 0x80, 0x3C,
+  0x01, 0xE0, 0x0F, 0x00, 0xF8, 0x0F, 0x81, 0xF8, 0x1F, 0x81, 0xF8, 0x1F,
+  0x81, 0xF8, 0x1F, 0xFF, 0xFF, 0xFF, 0xFF, 0xC0, 0x1F, 0xE1, 0xFF, 0xE7,
+  0xFF, 0x98, 0x1F, 0x00, 0x3C, 0x00, 0xF0, 0x03, 0xC0, 0x1E, 0x1F, 0xF0,
+  0x7F, 0xC1, 0xFF, 0x80, 0x1F, 0x00, 0x3C, 0x00, 0xFC, 0x07, 0xFF, 0xFE,
+  0xFF, 0xF0, 0xFF, 0x00, 0x01, 0xF8, 0x03, 0xF8, 0x03, 0xF8, 0x07, 0xF8,
+  0x0F, 0x78, 0x1E, 0x78, 0x1E, 0x78, 0x3C, 0x78, 0x78, 0x78, 0x70, 0x78,
+  0xF0, 0x78, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x78, 0x00, 0x78,
+  0x00, 0x78, 0x00, 0x78, 0x7F, 0xF9, 0xFF, 0xE7, 0xFF, 0x9E, 0x00, 0x78,
+  0x01, 0xFF, 0x07, 0xFF, 0x1F, 0xFE, 0x60, 0xF8, 0x01, 0xF0, 0x03, 0xC0,
+  0x0F, 0x00, 0x3C, 0x01, 0xFC, 0x0F, 0xBF, 0xFE, 0xFF, 0xF0, 0xFF, 0x00,
+  0x03, 0xF8, 0x1F, 0xF8, 0xFF, 0xF1, 0xF0, 0x67, 0x80, 0x0E, 0x00, 0x3D,
+  0xF8, 0x7F, 0xFC, 0xFF, 0xFD, 0xF0, 0x7F, 0xC0, 0x7F, 0x80, 0xFF, 0x01,
+  0xEE, 0x03, 0xDE, 0x0F, 0x1F, 0xFE, 0x1F, 0xF8, 0x0F, 0xC0, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xC0, 0x1F, 0x00, 0x78, 0x03, 0xE0, 0x0F, 0x00, 0x7C,
+  0x01, 0xE0, 0x0F, 0x80, 0x3C, 0x01, 0xF0, 0x07, 0x80, 0x3E, 0x00, 0xF0,
+  0x07, 0xC0, 0x1E, 0x00, 0x78, 0x00, 0x1F, 0xF0, 0xFF, 0xFB, 0xFF, 0xF7,
+  0xC1, 0xFF, 0x01, 0xFE, 0x03, 0xFE, 0x0F, 0x3F, 0xFE, 0x1F, 0xF0, 0xFF,
+  0xF9, 0xE0, 0xF7, 0x80, 0xFF, 0x01, 0xFE, 0x03, 0xFE, 0x0F, 0xBF, 0xFE,
+  0x3F, 0xF8, 0x1F, 0xC0, 0x0F, 0xC0, 0x7F, 0xE1, 0xFF, 0xE3, 0xC1, 0xEF,
+  0x01, 0xDE, 0x03, 0xFC, 0x07, 0xF8, 0x0F, 0xF8, 0x3E, 0xFF, 0xFC, 0xFF,
+  0xF8, 0x7E, 0xF0, 0x01, 0xC0, 0x07, 0x90, 0x3E, 0x3F, 0xFC, 0x7F, 0xE0,
+  0x7F, 0x00, 0x3C, 0x7E, 0xE7, 0xC3, 0xC3, 0xE7, 0x7E, 0x3C };
+
+const GFXglyph DejaVuSans_Bold13pt8bGlyphs[] PROGMEM = {
+  {     0,   1,   1,   9,    0,    0 },   // 0x20 ' '
+  {     0,   0,   0,   0,    0,    0 },   // 0x21 '!'
+  {     0,   0,   0,   0,    0,    0 },   // 0x22 '"'
+  {     0,   0,   0,   0,    0,    0 },   // 0x23 '#'
+  {     0,   0,   0,   0,    0,    0 },   // 0x24 '$'
+  {     0,   0,   0,   0,    0,    0 },   // 0x25 '%'
+  {     0,   0,   0,   0,    0,    0 },   // 0x26 '&'
+  {     0,   0,   0,   0,    0,    0 },   // 0x27 '''
+  {     0,   0,   0,   0,    0,    0 },   // 0x28 '('
+  {     0,   0,   0,   0,    0,    0 },   // 0x29 ')'
+  {     0,   0,   0,   0,    0,    0 },   // 0x2A '*'
+  {     1,  15,  15,  21,    3,  -14 },   // 0x2B '+'
+  {     0,   0,   0,   0,    0,    0 },   // 0x2C ','
+  {    30,   8,   4,  10,    1,   -8 },   // 0x2D '-'
+  {    34,   4,   5,  10,    3,   -4 },   // 0x2E '.'
+  {     0,   0,   0,   0,    0,    0 },   // 0x2F '/'
+  {    37,  15,  18,  17,    1,  -17 },   // 0x30 '0'
+  {    71,  12,  18,  17,    3,  -17 },   // 0x31 '1'
+  {    98,  13,  18,  17,    2,  -17 },   // 0x32 '2'
+  {   128,  14,  18,  17,    2,  -17 },   // 0x33 '3'
+  {   160,  16,  18,  17,    1,  -17 },   // 0x34 '4'
+  {   196,  14,  18,  17,    2,  -17 },   // 0x35 '5'
+  {   228,  15,  18,  17,    1,  -17 },   // 0x36 '6'
+  {   262,  14,  18,  17,    2,  -17 },   // 0x37 '7'
+  {   294,  15,  18,  17,    1,  -17 },   // 0x38 '8'
+  {   328,  15,  18,  17,    1,  -17 },   // 0x39 '9'
+  {     0,   0,   0,   0,    0,    0 },   // 0x3A ':'
+  {     0,   0,   0,   0,    0,    0 },   // 0x3B ';'
+  {     0,   0,   0,   0,    0,    0 },   // 0x3C '<'
+  {     0,   0,   0,   0,    0,    0 },   // 0x3D '='
+  {     0,   0,   0,   0,    0,    0 },   // 0x3E '>'
+  {     0,   0,   0,   0,    0,    0 },   // 0x3F '?'
+  {     0,   0,   0,   0,    0,    0 },   // 0x40 '@'
+  {     0,   0,   0,   0,    0,    0 },   // 0x41 'A'
+  {     0,   0,   0,   0,    0,    0 },   // 0x42 'B'
+  {     0,   0,   0,   0,    0,    0 },   // 0x43 'C'
+  {     0,   0,   0,   0,    0,    0 },   // 0x44 'D'
+  {     0,   0,   0,   0,    0,    0 },   // 0x45 'E'
+  {     0,   0,   0,   0,    0,    0 },   // 0x46 'F'
+  {     0,   0,   0,   0,    0,    0 },   // 0x47 'G'
+  {     0,   0,   0,   0,    0,    0 },   // 0x48 'H'
+  {     0,   0,   0,   0,    0,    0 },   // 0x49 'I'
+  {     0,   0,   0,   0,    0,    0 },   // 0x4A 'J'
+  {     0,   0,   0,   0,    0,    0 },   // 0x4B 'K'
+  {     0,   0,   0,   0,    0,    0 },   // 0x4C 'L'
+  {     0,   0,   0,   0,    0,    0 },   // 0x4D 'M'
+  {     0,   0,   0,   0,    0,    0 },   // 0x4E 'N'
+  {     0,   0,   0,   0,    0,    0 },   // 0x4F 'O'
+  {     0,   0,   0,   0,    0,    0 },   // 0x50 'P'
+  {     0,   0,   0,   0,    0,    0 },   // 0x51 'Q'
+  {     0,   0,   0,   0,    0,    0 },   // 0x52 'R'
+  {     0,   0,   0,   0,    0,    0 },   // 0x53 'S'
+  {     0,   0,   0,   0,    0,    0 },   // 0x54 'T'
+  {     0,   0,   0,   0,    0,    0 },   // 0x55 'U'
+  {     0,   0,   0,   0,    0,    0 },   // 0x56 'V'
+  {     0,   0,   0,   0,    0,    0 },   // 0x57 'W'
+  {     0,   0,   0,   0,    0,    0 },   // 0x58 'X'
+  {     0,   0,   0,   0,    0,    0 },   // 0x59 'Y'
+  {     0,   0,   0,   0,    0,    0 },   // 0x5A 'Z'
+  {     0,   0,   0,   0,    0,    0 },   // 0x5B '['
+  {     0,   0,   0,   0,    0,    0 },   // 0x5C '\'
+  {     0,   0,   0,   0,    0,    0 },   // 0x5D ']'
+  {     0,   0,   0,   0,    0,    0 },   // 0x5E '^'
+  {     0,   0,   0,   0,    0,    0 },   // 0x5F '_'
+  {     0,   0,   0,   0,    0,    0 },   // 0x60 '`'
+  {     0,   0,   0,   0,    0,    0 },   // 0x61 'a'
+  {     0,   0,   0,   0,    0,    0 },   // 0x62 'b'
+  {     0,   0,   0,   0,    0,    0 },   // 0x63 'c'
+  {     0,   0,   0,   0,    0,    0 },   // 0x64 'd'
+  {     0,   0,   0,   0,    0,    0 },   // 0x65 'e'
+  {     0,   0,   0,   0,    0,    0 },   // 0x66 'f'
+  {     0,   0,   0,   0,    0,    0 },   // 0x67 'g'
+  {     0,   0,   0,   0,    0,    0 },   // 0x68 'h'
+  {     0,   0,   0,   0,    0,    0 },   // 0x69 'i'
+  {     0,   0,   0,   0,    0,    0 },   // 0x6A 'j'
+  {     0,   0,   0,   0,    0,    0 },   // 0x6B 'k'
+  {     0,   0,   0,   0,    0,    0 },   // 0x6C 'l'
+  {     0,   0,   0,   0,    0,    0 },   // 0x6D 'm'
+  {     0,   0,   0,   0,    0,    0 },   // 0x6E 'n'
+  {     0,   0,   0,   0,    0,    0 },   // 0x6F 'o'
+  {     0,   0,   0,   0,    0,    0 },   // 0x70 'p'
+  {     0,   0,   0,   0,    0,    0 },   // 0x71 'q'
+  {     0,   0,   0,   0,    0,    0 },   // 0x72 'r'
+  {     0,   0,   0,   0,    0,    0 },   // 0x73 's'
+  {     0,   0,   0,   0,    0,    0 },   // 0x74 't'
+  {     0,   0,   0,   0,    0,    0 },   // 0x75 'u'
+  {     0,   0,   0,   0,    0,    0 },   // 0x76 'v'
+  {     0,   0,   0,   0,    0,    0 },   // 0x77 'w'
+  {     0,   0,   0,   0,    0,    0 },   // 0x78 'x'
+  {     0,   0,   0,   0,    0,    0 },   // 0x79 'y'
+  {     0,   0,   0,   0,    0,    0 },   // 0x7A 'z'
+  {     0,   0,   0,   0,    0,    0 },   // 0x7B '{'
+  {     0,   0,   0,   0,    0,    0 },   // 0x7C '|'
+  {     0,   0,   0,   0,    0,    0 },   // 0x7D '}'
+  {     0,   0,   0,   0,    0,    0 },   // 0x7E '~'
+  {     0,   0,   0,   0,    0,    0 },   // 0x7F
+  {     0,   0,   0,   0,    0,    0 },   // 0x80
+  {     0,   0,   0,   0,    0,    0 },   // 0x81
+  {     0,   0,   0,   0,    0,    0 },   // 0x82
+  {     0,   0,   0,   0,    0,    0 },   // 0x83
+  {     0,   0,   0,   0,    0,    0 },   // 0x84
+  {     0,   0,   0,   0,    0,    0 },   // 0x85
+  {     0,   0,   0,   0,    0,    0 },   // 0x86
+  {     0,   0,   0,   0,    0,    0 },   // 0x87
+  {     0,   0,   0,   0,    0,    0 },   // 0x88
+  {     0,   0,   0,   0,    0,    0 },   // 0x89
+  {     0,   0,   0,   0,    0,    0 },   // 0x8A
+  {     0,   0,   0,   0,    0,    0 },   // 0x8B
+  {     0,   0,   0,   0,    0,    0 },   // 0x8C
+  {     0,   0,   0,   0,    0,    0 },   // 0x8D
+  {     0,   0,   0,   0,    0,    0 },   // 0x8E
+  {     0,   0,   0,   0,    0,    0 },   // 0x8F
+  {     0,   0,   0,   0,    0,    0 },   // 0x90
+  {     0,   0,   0,   0,    0,    0 },   // 0x91
+  {     0,   0,   0,   0,    0,    0 },   // 0x92
+  {     0,   0,   0,   0,    0,    0 },   // 0x93
+  {     0,   0,   0,   0,    0,    0 },   // 0x94
+  {     0,   0,   0,   0,    0,    0 },   // 0x95
+  {     0,   0,   0,   0,    0,    0 },   // 0x96
+  {     0,   0,   0,   0,    0,    0 },   // 0x97
+  {     0,   0,   0,   0,    0,    0 },   // 0x98
+  {     0,   0,   0,   0,    0,    0 },   // 0x99
+  {     0,   0,   0,   0,    0,    0 },   // 0x9A
+  {     0,   0,   0,   0,    0,    0 },   // 0x9B
+  {     0,   0,   0,   0,    0,    0 },   // 0x9C
+  {     0,   0,   0,   0,    0,    0 },   // 0x9D
+  {     0,   0,   0,   0,    0,    0 },   // 0x9E
+  {     0,   0,   0,   0,    0,    0 },   // 0x9F
+  {     0,   0,   0,   0,    0,    0 },   // 0xA0
+  {     0,   0,   0,   0,    0,    0 },   // 0xA1
+  {     0,   0,   0,   0,    0,    0 },   // 0xA2
+  {     0,   0,   0,   0,    0,    0 },   // 0xA3
+  {     0,   0,   0,   0,    0,    0 },   // 0xA4
+  {     0,   0,   0,   0,    0,    0 },   // 0xA5
+  {     0,   0,   0,   0,    0,    0 },   // 0xA6
+  {     0,   0,   0,   0,    0,    0 },   // 0xA7
+  {     0,   0,   0,   0,    0,    0 },   // 0xA8
+  {     0,   0,   0,   0,    0,    0 },   // 0xA9
+  {     0,   0,   0,   0,    0,    0 },   // 0xAA
+  {     0,   0,   0,   0,    0,    0 },   // 0xAB
+  {     0,   0,   0,   0,    0,    0 },   // 0xAC
+  {     0,   0,   0,   0,    0,    0 },   // 0xAD
+  {     0,   0,   0,   0,    0,    0 },   // 0xAE
+  {     0,   0,   0,   0,    0,    0 },   // 0xAF
+  {   362,   8,   8,  13,    2,  -18 } };   // 0xB0
+
+const GFXfont DejaVuSans_Bold13pt8b PROGMEM = {
+  (uint8_t  *)DejaVuSans_Bold13pt8bBitmaps,
+  (GFXglyph *)DejaVuSans_Bold13pt8bGlyphs,
+  0x20, 0xB0, 30 };
+
+#endif
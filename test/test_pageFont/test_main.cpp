@@ -0,0 +1,147 @@
+// drawPageText() with the readout font against the same font converted as a regular
+// GFXfont and drawn by GFX: random strings at random positions, clipped at every edge
+
+#include <unity.h>
+#include <chrono>
+#include <stdio.h>
+#include <vector>
+#include <Adafruit_SSD1306Fixed.h>
+#include "bigDigitsFont.h"
+#include "dejaVuSansBold13pt.h"
+
+#define frameBytes (128 * 64 / 8)
+#define baseline 18  // rows from the top of the page font's cell to the GFX baseline
+
+static uint32_t state;
+static uint32_t random32() {
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+static int16_t randomIn(int16_t low, int16_t high) {
+  return low + (int16_t)(random32() % (uint32_t)(high - low + 1));
+}
+
+static Adafruit_SSD1306Fixed<128, 64> *pages;
+static Adafruit_SSD1306Fixed<128, 64> *reference;
+
+// GFX's rendering of `text`, ORed in like drawPageText(), returns the cursor after it
+static int16_t drawReference(int16_t x, int16_t y, const char *text) {
+  reference->setCursor(x, y + baseline);
+  reference->print(text);
+  return reference->getCursorX();
+}
+
+static void randomBackground() {
+  for (uint16_t i = 0; i < frameBytes; i++) {
+    pages->getBuffer()[i] = reference->getBuffer()[i] = random32() % 4 ? 0 : random32();
+  }
+}
+
+void setUp(void) {
+  state = 1;
+  pages = new Adafruit_SSD1306Fixed<128, 64>(&Wire);
+  reference = new Adafruit_SSD1306Fixed<128, 64>(&Wire);
+  reference->setFont(&DejaVuSans_Bold13pt8b);
+  reference->setTextColor(SSD1306_WHITE);  // no background, only set pixels: an OR
+  reference->setTextWrap(false);
+  pages->clearDisplay();
+  reference->clearDisplay();
+}
+void tearDown(void) {
+  delete pages;
+  delete reference;
+}
+
+void test_every_glyph(void) {
+  static const char characters[] = "0123456789+-. \xB0";
+  for (const char *c = characters; *c; c++) {
+    char text[2] = { *c, 0 };
+    for (int16_t y = -20; y <= 64; y += 3) {
+      pages->clearDisplay();
+      reference->clearDisplay();
+      int16_t end = pages->drawPageText(50, y, &DejaVuSans_Bold13ptPages, text);
+      TEST_ASSERT_EQUAL_INT16(drawReference(50, y, text), end);
+      TEST_ASSERT_EQUAL_MEMORY(reference->getBuffer(), pages->getBuffer(), frameBytes);
+    }
+  }
+}
+
+void test_random_strings(void) {
+  static const char characters[] = "0123456789+-. \xB0" "A";  // A isn't in the font, skipped by both
+  for (uint32_t i = 0; i < 20000; i++) {
+    char text[10];
+    uint8_t length = random32() % sizeof(text);
+    for (uint8_t j = 0; j < length; j++) {
+      text[j] = characters[random32() % (sizeof(characters) - 1)];
+    }
+    text[length] = 0;
+    int16_t x = randomIn(-60, 140);
+    int16_t y = randomIn(-24, 70);
+    if (i % 16 == 0) {
+      randomBackground();
+    }
+    int16_t end = pages->drawPageText(x, y, &DejaVuSans_Bold13ptPages, text);
+    TEST_ASSERT_EQUAL_INT16(drawReference(x, y, text), end);
+    TEST_ASSERT_EQUAL_INT16(end - x, Adafruit_SSD1306::pageTextWidth(&DejaVuSans_Bold13ptPages, text));
+    if (memcmp(reference->getBuffer(), pages->getBuffer(), frameBytes)) {
+      char message[64];
+      snprintf(message, sizeof(message), "\"%s\" at %d,%d", text, x, y);
+      TEST_FAIL_MESSAGE(message);
+    }
+  }
+}
+
+void test_readout_line(void) {
+  // the oledFormatBig readout: value and degree sign right justified against a column
+  const char *values[] = { "-179.9", "0.0", "+45.5", "-0.1" };
+  for (const char *value : values) {
+    pages->clearDisplay();
+    reference->clearDisplay();
+    int16_t x = 104 - Adafruit_SSD1306::pageTextWidth(&DejaVuSans_Bold13ptPages, value)
+      - Adafruit_SSD1306::pageTextWidth(&DejaVuSans_Bold13ptPages, "\xB0");
+    drawReference(x, 3, value);
+    reference->print("\xB0");
+    x = pages->drawPageText(x, 3, &DejaVuSans_Bold13ptPages, value);
+    TEST_ASSERT_EQUAL_INT16(104, pages->drawPageText(x, 3, &DejaVuSans_Bold13ptPages, "\xB0"));
+    TEST_ASSERT_EQUAL_INT16(104, reference->getCursorX());
+    TEST_ASSERT_EQUAL_MEMORY(reference->getBuffer(), pages->getBuffer(), frameBytes);
+  }
+}
+
+void test_timings(void) {
+  // only printed, the numbers depend on the host and the build flags
+  pages->setFont(nullptr);
+  pages->setTextSize(3);
+  pages->setTextColor(SSD1306_WHITE, SSD1306_BLACK);
+  double best[2] = { 1e9, 1e9 };
+  for (uint8_t round = 0; round < 7; round++) {
+    for (uint8_t way = 0; way < 2; way++) {
+      auto start = std::chrono::steady_clock::now();
+      for (uint16_t run = 0; run < 1000; run++) {
+        if (way) {
+          pages->drawPageText(20, 3, &DejaVuSans_Bold13ptPages, "-12.3\xB0");
+        }
+        else {
+          pages->setCursor(20, 3);
+          pages->print("-12.3");
+        }
+      }
+      double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / 1000;
+      best[way] = elapsed < best[way] ? elapsed : best[way];
+    }
+  }
+  char message[80];
+  snprintf(message, sizeof(message), "readout line: size 3 text %.0f ns, page font %.0f ns", best[0], best[1]);
+  TEST_MESSAGE(message);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_every_glyph);
+  RUN_TEST(test_random_strings);
+  RUN_TEST(test_readout_line);
+  RUN_TEST(test_timings);
+  return UNITY_END();
+}
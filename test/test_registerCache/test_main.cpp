@@ -0,0 +1,237 @@
+// BusIO register cache against a register file on the stub Wire: bus transactions
+// for the LSM6DS3 CTRL register style of configuration, with and without the cache
+
+#include <unity.h>
+#include <Adafruit_BusIO_Register.h>
+
+#define CTRL1_XL 0x10  // the LSM6DS3 control block, 0x10 - 0x19
+#define CTRL2_G 0x11
+#define CTRL3_C 0x12
+#define CTRL4_C 0x13
+#define CTRL6_C 0x15
+#define CTRL10_C 0x19
+#define STATUS_REG 0x1E  // set by the device
+
+static uint8_t device[256];
+static Adafruit_I2CDevice *i2c;
+
+static uint32_t transactions() {
+  return Wire.transactions.size();
+}
+
+// Odr, full scale and filter fields of the accelerometer and gyro, then BDU and the
+// gyro axis enables: six fields over five registers, as LSM6DS3::begin() sets them
+static void configure(Adafruit_I2CDevice *dev, Adafruit_BusIO_RegisterCache *cache) {
+  Adafruit_BusIO_Register ctrl1(dev, CTRL1_XL), ctrl2(dev, CTRL2_G), ctrl3(dev, CTRL3_C);
+  Adafruit_BusIO_Register ctrl4(dev, CTRL4_C), ctrl10(dev, CTRL10_C);
+  for (Adafruit_BusIO_Register *r : { &ctrl1, &ctrl2, &ctrl3, &ctrl4, &ctrl10 }) {
+    r->setCache(cache);
+  }
+  Adafruit_BusIO_RegisterBits(&ctrl1, 4, 4).write(0x5);  // accel 208 Hz
+  Adafruit_BusIO_RegisterBits(&ctrl1, 2, 2).write(0x2);  // 4 g
+  Adafruit_BusIO_RegisterBits(&ctrl2, 4, 4).write(0x4);  // gyro 104 Hz
+  Adafruit_BusIO_RegisterBits(&ctrl3, 1, 6).write(1);  // block data update
+  Adafruit_BusIO_RegisterBits(&ctrl4, 1, 7).write(1);  // bandwidth from the odr
+  Adafruit_BusIO_RegisterBits(&ctrl10, 3, 3).write(0x7);  // gyro x, y, z on
+}
+
+static void checkConfigured() {
+  TEST_ASSERT_EQUAL_HEX8(0x58, device[CTRL1_XL]);
+  TEST_ASSERT_EQUAL_HEX8(0x40, device[CTRL2_G]);
+  TEST_ASSERT_EQUAL_HEX8(0x44, device[CTRL3_C]);  // IF_INC was already set
+  TEST_ASSERT_EQUAL_HEX8(0x80, device[CTRL4_C]);
+  TEST_ASSERT_EQUAL_HEX8(0x38, device[CTRL10_C]);
+}
+
+void setUp(void) {
+  memset(device, 0, sizeof(device));
+  device[CTRL3_C] = 0x04;  // reset value
+  Wire.reset();
+  Wire.registers = device;
+  i2c = new Adafruit_I2CDevice(0x6A, &Wire);
+  i2c->begin(false);
+}
+void tearDown(void) {
+  delete i2c;
+  Wire.registers = nullptr;
+}
+
+void test_configuration_without_cache(void) {
+  // every field is a read-modify-write round trip
+  configure(i2c, nullptr);
+  checkConfigured();
+  TEST_ASSERT_EQUAL_UINT32(12, transactions());
+}
+
+void test_configuration_write_through(void) {
+  // the block is read once, then each changed register is one write
+  Adafruit_BusIO_RegisterCache cache(i2c, CTRL1_XL, 10);
+  uint8_t block[10];
+  TEST_ASSERT_TRUE(cache.read(CTRL1_XL, block, sizeof(block)));
+  configure(i2c, &cache);
+  checkConfigured();
+  TEST_ASSERT_EQUAL_UINT32(1 + 6, transactions());
+  TEST_ASSERT_EQUAL_UINT32(transactions(), cache.transactions());
+  // the same configuration again costs nothing
+  configure(i2c, &cache);
+  TEST_ASSERT_EQUAL_UINT32(7, transactions());
+}
+
+void test_configuration_deferred(void) {
+  // one block read and one burst over CTRL1_XL..CTRL10_C, the clean registers between
+  // the fields are rewritten with their known values
+  Adafruit_BusIO_RegisterCache cache(i2c, CTRL1_XL, 10);
+  device[CTRL6_C] = 0x10;
+  uint8_t block[10];
+  cache.read(CTRL1_XL, block, sizeof(block));
+  cache.setDeferred(true);
+  configure(i2c, &cache);
+  TEST_ASSERT_EQUAL_UINT32(1, transactions());
+  TEST_ASSERT_TRUE(cache.dirty());
+  TEST_ASSERT_EQUAL_HEX8(0, device[CTRL1_XL]);  // nothing sent yet
+  TEST_ASSERT_TRUE(cache.flush());
+  TEST_ASSERT_FALSE(cache.dirty());
+  TEST_ASSERT_EQUAL_UINT32(2, transactions());
+  TEST_ASSERT_EQUAL_UINT(2 + 10, Wire.transactions.back().size());  // address, register, CTRL1-10
+  checkConfigured();
+  TEST_ASSERT_EQUAL_HEX8(0x10, device[CTRL6_C]);
+  // nothing left to send
+  TEST_ASSERT_TRUE(cache.flush());
+  TEST_ASSERT_EQUAL_UINT32(2, transactions());
+}
+
+void test_unknown_registers_are_not_bridged(void) {
+  // without the block read the gaps aren't known, each dirty run is its own burst
+  Adafruit_BusIO_RegisterCache cache(i2c, CTRL1_XL, 10);
+  cache.setDeferred(true);
+  uint8_t value = 0x60;
+  cache.write(CTRL1_XL, &value, 1);
+  cache.write(CTRL2_G, &value, 1);
+  cache.write(CTRL10_C, &value, 1);
+  cache.flush();
+  TEST_ASSERT_EQUAL_UINT32(2, transactions());
+  TEST_ASSERT_EQUAL_HEX8(0x60, device[CTRL2_G]);
+  TEST_ASSERT_EQUAL_HEX8(0x04, device[CTRL3_C]);  // untouched
+  TEST_ASSERT_EQUAL_HEX8(0x60, device[CTRL10_C]);
+}
+
+void test_volatile_registers_go_to_the_bus(void) {
+  Adafruit_BusIO_RegisterCache cache(i2c, CTRL1_XL, 16);
+  cache.setVolatile(STATUS_REG);
+  Adafruit_BusIO_Register status(i2c, STATUS_REG);
+  status.setCache(&cache);
+  uint8_t value;
+  device[STATUS_REG] = 0x01;
+  TEST_ASSERT_TRUE(status.read(&value));
+  TEST_ASSERT_EQUAL_HEX8(0x01, value);
+  device[STATUS_REG] = 0x03;  // new data
+  TEST_ASSERT_TRUE(status.read(&value));
+  TEST_ASSERT_EQUAL_HEX8(0x03, value);
+  TEST_ASSERT_EQUAL_UINT32(2, transactions());
+  // written now even when deferred, and a burst stops in front of it
+  cache.setDeferred(true);
+  value = 0;
+  cache.write(STATUS_REG, &value, 1);
+  TEST_ASSERT_EQUAL_UINT32(3, transactions());
+  uint8_t block[16] = {};
+  cache.write(CTRL1_XL, block, 14);
+  cache.write(0x1F, block, 1);
+  cache.flush();
+  TEST_ASSERT_EQUAL_UINT32(5, transactions());
+}
+
+void test_invalidate_rereads(void) {
+  Adafruit_BusIO_RegisterCache cache(i2c, CTRL1_XL, 10);
+  uint8_t value;
+  cache.read(CTRL3_C, &value, 1);
+  cache.read(CTRL3_C, &value, 1);
+  TEST_ASSERT_EQUAL_UINT32(1, transactions());
+  device[CTRL3_C] = 0x04;  // software reset, back to the defaults
+  device[CTRL1_XL] = 0;
+  cache.invalidateAll();
+  cache.read(CTRL3_C, &value, 1);
+  TEST_ASSERT_EQUAL_UINT32(2, transactions());
+  // a pending write wins over what the device holds
+  cache.setDeferred(true);
+  value = 0x44;
+  cache.write(CTRL3_C, &value, 1);
+  uint8_t block[3];
+  cache.read(CTRL1_XL, block, 3);
+  TEST_ASSERT_EQUAL_HEX8(0x44, block[2]);
+  TEST_ASSERT_EQUAL_HEX8(0x04, device[CTRL3_C]);
+  // and invalidating drops it
+  cache.invalidate(CTRL3_C);
+  TEST_ASSERT_FALSE(cache.dirty());
+}
+
+void test_outside_the_block_is_uncached(void) {
+  Adafruit_BusIO_RegisterCache cache(i2c, CTRL1_XL, 10);
+  uint8_t value = 1;
+  TEST_ASSERT_FALSE(cache.write(0x0F, &value, 1));
+  TEST_ASSERT_FALSE(cache.read(CTRL10_C, &value, 2));
+  Adafruit_BusIO_Register whoami(i2c, 0x0F);
+  whoami.setCache(&cache);
+  device[0x0F] = 0x69;
+  TEST_ASSERT_EQUAL_UINT32(0x69, whoami.read());
+  TEST_ASSERT_EQUAL_UINT32(0x69, whoami.read());
+  TEST_ASSERT_EQUAL_UINT32(0, cache.transactions());  // plain register reads
+  TEST_ASSERT_EQUAL_UINT32(2, transactions());
+}
+
+void test_random_operations_match_the_device(void) {
+  // random reads, writes and flushes: after each flush the device holds every value
+  // written, and reads always return the newest value
+  Adafruit_BusIO_RegisterCache cache(i2c, CTRL1_XL, 16);
+  cache.setVolatile(STATUS_REG);
+  uint8_t expected[256];
+  memcpy(expected, device, sizeof(expected));
+  uint32_t state = 1;
+  for (uint32_t i = 0; i < 20000; i++) {
+    state = state * 1103515245 + 12345;
+    uint8_t reg = CTRL1_XL + (state >> 16) % 15;
+    uint8_t len = 1 + (state >> 8) % 3;
+    if (reg + len > CTRL1_XL + 16) {
+      len = CTRL1_XL + 16 - reg;
+    }
+    uint8_t data[3];
+    switch ((state >> 24) % 6) {
+      case 0:
+      case 1:
+        for (uint8_t j = 0; j < len; j++) {
+          data[j] = (state >> (j * 3)) % 4;  // few values, so unchanged writes happen
+          expected[reg + j] = data[j];
+        }
+        TEST_ASSERT_TRUE(cache.write(reg, data, len));
+        break;
+      case 2:
+        TEST_ASSERT_TRUE(cache.read(reg, data, len));
+        TEST_ASSERT_EQUAL_MEMORY(&expected[reg], data, len);
+        break;
+      case 3:
+        TEST_ASSERT_TRUE(cache.flush());
+        TEST_ASSERT_EQUAL_MEMORY(&expected[CTRL1_XL], &device[CTRL1_XL], 16);
+        break;
+      case 4:
+        cache.setDeferred(!cache.dirty() && (state & 1));
+        break;
+      case 5:
+        device[STATUS_REG] = expected[STATUS_REG] = state;  // the device changes it
+        break;
+    }
+  }
+  cache.flush();
+  TEST_ASSERT_EQUAL_MEMORY(&expected[CTRL1_XL], &device[CTRL1_XL], 16);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_configuration_without_cache);
+  RUN_TEST(test_configuration_write_through);
+  RUN_TEST(test_configuration_deferred);
+  RUN_TEST(test_unknown_registers_are_not_bridged);
+  RUN_TEST(test_volatile_registers_go_to_the_bus);
+  RUN_TEST(test_invalidate_rereads);
+  RUN_TEST(test_outside_the_block_is_uncached);
+  RUN_TEST(test_random_operations_match_the_device);
+  return UNITY_END();
+}
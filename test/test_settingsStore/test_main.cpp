@@ -0,0 +1,243 @@
+// Settings store against a RAM copy of its two flash pages, with the power cut
+// at every single flash operation of a scripted run (compactions included)
+
+#include <unity.h>
+#include <map>
+#include <vector>
+#include "settingsStore.h"
+
+#define testBase 0x1000
+#define testPageSize 256  // small, so the script compacts often
+
+struct PowerLoss {};
+
+// Flash in RAM: programming only clears bits, erase sets a whole page. When the
+// operation budget runs out the current operation is torn and PowerLoss thrown.
+class RamFlash : public SettingsFlash {
+  public:
+    uint8_t memory[testPageSize * 2];
+    long budget = -1;  // operations left before the power cut, -1 = no cut
+    uint32_t operations = 0;
+    uint32_t erases[2] = {};
+    uint32_t overwrites = 0;  // programmed words that needed a 0 -> 1 change
+    uint32_t seed = 1;
+
+    RamFlash() { memset(memory, 0xFF, sizeof(memory)); }
+
+    void read(uint32_t address, void *data, uint32_t length) override {
+      TEST_ASSERT_TRUE(address >= testBase && address + length <= testBase + sizeof(memory));
+      memcpy(data, &memory[address - testBase], length);
+    }
+    void program(uint32_t address, const uint32_t *words, uint32_t count) override {
+      TEST_ASSERT_EQUAL_UINT32(0, address % 4);
+      for (uint32_t i = 0; i < count; i++) {
+        uint32_t *word = (uint32_t *)&memory[address - testBase + i * 4];
+        if (cut()) {
+          *word &= words[i] | random();  // torn: only some of the bits cleared
+          throw PowerLoss();
+        }
+        if ((*word & words[i]) != words[i]) {
+          overwrites++;
+        }
+        *word &= words[i];
+      }
+    }
+    void erase(uint32_t pageAddress) override {
+      uint8_t *page = &memory[pageAddress - testBase];
+      if (cut()) {
+        memset(page, 0xFF, random() % testPageSize);  // erase interrupted part way
+        throw PowerLoss();
+      }
+      memset(page, 0xFF, testPageSize);
+      erases[(pageAddress - testBase) / testPageSize]++;
+    }
+
+  private:
+    bool cut() {
+      operations++;
+      if (budget == 0) {
+        return true;
+      }
+      if (budget > 0) {
+        budget--;
+      }
+      return false;
+    }
+    uint32_t random() {
+      seed = seed * 1103515245 + 12345;
+      return seed >> 8;
+    }
+};
+
+typedef std::vector<uint8_t> bytes;
+
+// One size per key, like the real settings structs
+static uint8_t keyLength(uint8_t key) {
+  static const uint8_t lengths[] = { 0, 8, 12, 16, 1, 1, 20 };
+  return lengths[key];
+}
+
+struct step {
+  uint8_t key;
+  bytes value;
+};
+
+static std::vector<step> script() {
+  std::vector<step> steps;
+  uint32_t state = 7;
+  for (int i = 0; i < 150; i++) {
+    state = state * 1103515245 + 12345;
+    uint8_t key = 1 + (state >> 16) % (settingsKeyCount - 1);
+    bytes value(keyLength(key));
+    for (auto &b : value) {
+      state = state * 1103515245 + 12345;
+      b = state >> 24;
+    }
+    if (i % 10 == 9) {
+      // unchanged puts too
+      key = steps.back().key;
+      value = steps.back().value;
+    }
+    steps.push_back({ key, value });
+  }
+  return steps;
+}
+
+static void checkStored(SettingsStore &store, const std::map<uint8_t, bytes> &expected, uint8_t tornKey = 0, const bytes *tornValue = nullptr) {
+  for (uint8_t key = 1; key < settingsKeyCount; key++) {
+    bytes value(keyLength(key));
+    bool found = store.get(key, value.data(), value.size());
+    if (key == tornKey && found && value == *tornValue) {
+      continue;  // the interrupted put may have made it
+    }
+    auto it = expected.find(key);
+    if (it == expected.end()) {
+      TEST_ASSERT_FALSE_MESSAGE(found, "key appeared without a put");
+    }
+    else {
+      TEST_ASSERT_TRUE_MESSAGE(found, "committed value lost");
+      TEST_ASSERT_EQUAL_MEMORY_MESSAGE(it->second.data(), value.data(), value.size(), "committed value changed");
+    }
+  }
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_blank_flash_formats(void) {
+  RamFlash flash;
+  SettingsStore store(flash, testBase, testPageSize);
+  TEST_ASSERT_FALSE(store.begin());
+  SettingsStore again(flash, testBase, testPageSize);
+  TEST_ASSERT_TRUE(again.begin());
+  tareSettings tare;
+  TEST_ASSERT_FALSE(again.get(settingsKeyTare, &tare, sizeof(tare)));
+}
+
+void test_values_survive_reboot(void) {
+  RamFlash flash;
+  SettingsStore store(flash, testBase, testPageSize);
+  store.begin();
+  tareSettings tare = { 1.5, -2.25 };
+  TEST_ASSERT_TRUE(store.put(settingsKeyTare, &tare, sizeof(tare)));
+  uint8_t mode = 3;
+  TEST_ASSERT_TRUE(store.put(settingsKeyDisplayMode, &mode, 1));
+
+  SettingsStore again(flash, testBase, testPageSize);
+  TEST_ASSERT_TRUE(again.begin());
+  tareSettings read;
+  TEST_ASSERT_TRUE(again.get(settingsKeyTare, &read, sizeof(read)));
+  TEST_ASSERT_EQUAL_MEMORY(&tare, &read, sizeof(tare));
+  TEST_ASSERT_FALSE(again.get(settingsKeyTare, &read, 4));  // wrong size
+  TEST_ASSERT_FALSE(again.put(settingsKeyCount, &mode, 1));
+  TEST_ASSERT_FALSE(again.put(settingsKeyTare, &mode, settingsMaxValueSize + 1));
+}
+
+void test_unchanged_put_writes_nothing(void) {
+  RamFlash flash;
+  SettingsStore store(flash, testBase, testPageSize);
+  store.begin();
+  tareSettings tare = { 0.5, 0.5 };
+  store.put(settingsKeyTare, &tare, sizeof(tare));
+  uint32_t before = flash.operations;
+  TEST_ASSERT_TRUE(store.put(settingsKeyTare, &tare, sizeof(tare)));
+  TEST_ASSERT_EQUAL_UINT32(before, flash.operations);
+}
+
+void test_wear_is_spread(void) {
+  RamFlash flash;
+  SettingsStore store(flash, testBase, testPageSize);
+  store.begin();
+  for (uint32_t i = 0; i < 2000; i++) {
+    tareSettings tare = { (float)i, 0 };
+    TEST_ASSERT_TRUE(store.put(settingsKeyTare, &tare, sizeof(tare)));
+  }
+  // the pages take turns, and no word is ever programmed twice between erases
+  TEST_ASSERT_EQUAL_UINT32(0, flash.overwrites);
+  TEST_ASSERT_GREATER_THAN(10, flash.erases[0]);
+  TEST_ASSERT_LESS_OR_EQUAL(1, labs((long)flash.erases[0] - (long)flash.erases[1]));
+  SettingsStore again(flash, testBase, testPageSize);
+  again.begin();
+  tareSettings tare;
+  TEST_ASSERT_TRUE(again.get(settingsKeyTare, &tare, sizeof(tare)));
+  TEST_ASSERT_EQUAL_FLOAT(1999, tare.roll);
+}
+
+void test_power_loss_at_every_operation(void) {
+  std::vector<step> steps = script();
+  // flash operations of the uninterrupted run
+  RamFlash reference;
+  SettingsStore referenceStore(reference, testBase, testPageSize);
+  referenceStore.begin();
+  uint32_t start = reference.operations;
+  for (auto &s : steps) {
+    referenceStore.put(s.key, s.value.data(), s.value.size());
+  }
+  uint32_t total = reference.operations - start;
+  TEST_ASSERT_GREATER_THAN(4, referenceStore.eraseCount());  // the script goes through compactions
+
+  for (uint32_t cut = 0; cut < total; cut++) {
+    RamFlash flash;
+    flash.seed = cut;
+    SettingsStore store(flash, testBase, testPageSize);
+    store.begin();
+    flash.budget = cut;
+    std::map<uint8_t, bytes> committed;
+    size_t done = 0;
+    try {
+      for (; done < steps.size(); done++) {
+        store.put(steps[done].key, steps[done].value.data(), steps[done].value.size());
+        committed[steps[done].key] = steps[done].value;
+      }
+      TEST_FAIL_MESSAGE("the power cut never happened");
+    }
+    catch (PowerLoss &) {
+    }
+    flash.budget = -1;
+
+    // reboot: every key holds its last committed value, the torn one may hold the new one
+    SettingsStore rebooted(flash, testBase, testPageSize);
+    TEST_ASSERT_TRUE(rebooted.begin());
+    checkStored(rebooted, committed, steps[done].key, &steps[done].value);
+
+    // and the store keeps working: finish the script, reboot again
+    committed[steps[done].key] = steps[done].value;
+    for (size_t i = done; i < steps.size(); i++) {
+      TEST_ASSERT_TRUE(rebooted.put(steps[i].key, steps[i].value.data(), steps[i].value.size()));
+      committed[steps[i].key] = steps[i].value;
+    }
+    SettingsStore final(flash, testBase, testPageSize);
+    TEST_ASSERT_TRUE(final.begin());
+    checkStored(final, committed);
+  }
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_blank_flash_formats);
+  RUN_TEST(test_values_survive_reboot);
+  RUN_TEST(test_unchanged_put_writes_nothing);
+  RUN_TEST(test_wear_is_spread);
+  RUN_TEST(test_power_loss_at_every_operation);
+  return UNITY_END();
+}
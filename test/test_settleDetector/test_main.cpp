@@ -0,0 +1,110 @@
+// Settle detection on step-plus-noise angle traces
+
+#include <unity.h>
+#include <math.h>
+#include "settleDetector.h"
+
+static uint32_t state;
+
+// Roughly gaussian noise (sum of four uniforms), standard deviation sigma
+static float noise(float sigma) {
+  float total = 0;
+  for (uint8_t i = 0; i < 4; i++) {
+    state = state * 1103515245 + 12345;
+    total += (state >> 8) / 16777216.0f - 0.5f;
+  }
+  return total * sigma * 1.732f;
+}
+
+// Feeds samples at (roll, pitch) plus noise, returns the first sample that was settled, -1 = none
+static long feed(SettleDetector &detector, uint32_t samples, float roll, float pitch, float sigma) {
+  long first = -1;
+  for (uint32_t i = 0; i < samples; i++) {
+    detector.add(roll + noise(sigma), pitch + noise(sigma));
+    if (first < 0 && detector.settled()) {
+      first = i;
+    }
+  }
+  return first;
+}
+
+void setUp(void) {
+  state = 1;
+}
+void tearDown(void) {}
+
+void test_still_reading_settles(void) {
+  SettleDetector detector;
+  TEST_ASSERT_FALSE(detector.settled());
+  long first = feed(detector, 1000, 12.5, -3, 0.02);
+  TEST_ASSERT_EQUAL_INT32(detector.minSamples - 1, first);
+  TEST_ASSERT_TRUE(detector.settled());
+  TEST_ASSERT_FLOAT_WITHIN(0.005, 12.5, detector.roll());
+  TEST_ASSERT_FLOAT_WITHIN(0.005, -3, detector.pitch());
+}
+
+void test_step_restarts(void) {
+  SettleDetector detector;
+  feed(detector, 500, 12.5, -3, 0.02);
+  // a 1 degree step on either axis drops out at once, and settles a stretch later at the new angle
+  detector.add(13.5, -3);
+  TEST_ASSERT_FALSE(detector.settled());
+  long first = feed(detector, 1000, 13.5, -3, 0.02);
+  TEST_ASSERT_EQUAL_INT32(detector.minSamples - 2, first);
+  TEST_ASSERT_FLOAT_WITHIN(0.005, 13.5, detector.roll());
+  detector.add(13.5, -2.5);
+  TEST_ASSERT_FALSE(detector.settled());
+  feed(detector, detector.minSamples, 13.5, -2.5, 0.02);
+  TEST_ASSERT_TRUE(detector.settled());
+  TEST_ASSERT_FLOAT_WITHIN(0.01, -2.5, detector.pitch());
+}
+
+void test_noise_within_the_limit_doesnt_restart(void) {
+  // 10000 samples with noise at 60% of the limit never drop out once settled
+  SettleDetector detector;
+  long first = feed(detector, 200, 45, 0, detector.noise * 0.6f);
+  TEST_ASSERT_GREATER_OR_EQUAL(0, first);
+  for (uint32_t i = 0; i < 10000; i++) {
+    detector.add(45 + noise(detector.noise * 0.6f), noise(detector.noise * 0.6f));
+    TEST_ASSERT_TRUE(detector.settled());
+  }
+  // the capped trackers still average closely
+  TEST_ASSERT_FLOAT_WITHIN(0.005, 45, detector.roll());
+}
+
+void test_noisy_reading_never_settles(void) {
+  SettleDetector detector;
+  TEST_ASSERT_EQUAL_INT32(-1, feed(detector, 10000, 10, 10, detector.noise * 3));
+}
+
+void test_slow_drift_never_settles(void) {
+  // 0.01 degree per sample, each sample within the noise of the last, but moving
+  SettleDetector detector;
+  for (uint32_t i = 0; i < 5000; i++) {
+    detector.add(i * 0.01f + noise(0.01), 5);
+    TEST_ASSERT_FALSE(detector.settled());
+  }
+}
+
+void test_settles_after_motion_stops(void) {
+  // a servo sweeping back and forth, then holding: settled within two stretches of the stop
+  SettleDetector detector;
+  for (uint32_t i = 0; i < 2000; i++) {
+    detector.add(20 * sinf(i * 0.01f), 0);
+    TEST_ASSERT_FALSE(detector.settled());
+  }
+  long first = feed(detector, 1000, 20 * sinf(2000 * 0.01f), 0, 0.02);
+  TEST_ASSERT_GREATER_OR_EQUAL(0, first);
+  TEST_ASSERT_LESS_THAN(detector.minSamples * 2, first);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_still_reading_settles);
+  RUN_TEST(test_step_restarts);
+  RUN_TEST(test_noise_within_the_limit_doesnt_restart);
+  RUN_TEST(test_noisy_reading_never_settles);
+  RUN_TEST(test_slow_drift_never_settles);
+  RUN_TEST(test_settles_after_motion_stops);
+  return UNITY_END();
+}
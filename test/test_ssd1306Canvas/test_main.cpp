@@ -0,0 +1,243 @@
+// Page-major canvas and blit() against a per-pixel reference: random sizes, offsets
+// (negative and clipped) and ops, canvas drawing against the fixed driver, and the
+// drawBitmap() vs blit() timings
+
+#include <unity.h>
+#include <chrono>
+#include <stdio.h>
+#include <vector>
+#include <Adafruit_SSD1306Canvas.h>
+#include <Adafruit_SSD1306Fixed.h>
+
+static uint32_t state;
+static uint32_t random32() {
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+static int16_t randomIn(int16_t low, int16_t high) {
+  return low + (int16_t)(random32() % (uint32_t)(high - low + 1));
+}
+
+static bool pixel(const uint8_t *pages, int16_t w, int16_t x, int16_t y) {
+  return pages[x + (y / 8) * w] >> (y & 7) & 1;
+}
+static void setPixel(uint8_t *pages, int16_t w, int16_t x, int16_t y, bool on) {
+  uint8_t &byte = pages[x + (y / 8) * w];
+  byte = on ? byte | 1 << (y & 7) : byte & ~(1 << (y & 7));
+}
+
+// blit() one pixel at a time
+static void referenceBlit(uint8_t *dst, int16_t dstW, int16_t dstH, const uint8_t *src, int16_t srcW, int16_t srcH, int16_t x, int16_t y, uint8_t op) {
+  for (int16_t sy = 0; sy < srcH; sy++) {
+    for (int16_t sx = 0; sx < srcW; sx++) {
+      int16_t dx = x + sx;
+      int16_t dy = y + sy;
+      if (dx < 0 || dy < 0 || dx >= dstW || dy >= dstH) {
+        continue;
+      }
+      bool on = pixel(src, srcW, sx, sy);
+      bool was = pixel(dst, dstW, dx, dy);
+      setPixel(dst, dstW, dx, dy, op == SSD1306_BLIT_COPY ? on : op == SSD1306_BLIT_OR ? was || on : was && on);
+    }
+  }
+}
+
+static std::vector<uint8_t> randomPages(int16_t w, int16_t h) {
+  std::vector<uint8_t> pages(w * ((h + 7) / 8));
+  for (auto &b : pages) {
+    b = random32();
+  }
+  return pages;
+}
+
+// Same pixels inside w x h, the padding rows of the last page aren't compared
+static bool samePixels(const uint8_t *a, const uint8_t *b, int16_t w, int16_t h) {
+  for (int16_t y = 0; y < h; y++) {
+    for (int16_t x = 0; x < w; x++) {
+      if (pixel(a, w, x, y) != pixel(b, w, x, y)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+void setUp(void) {
+  state = 1;
+}
+void tearDown(void) {}
+
+void test_blit_matches_per_pixel(void) {
+  for (uint32_t i = 0; i < 50000; i++) {
+    int16_t dstW = randomIn(1, 128);
+    int16_t dstH = randomIn(1, 64);
+    int16_t srcW = randomIn(1, 80);
+    int16_t srcH = randomIn(1, 40);
+    int16_t x = randomIn(-srcW - 2, dstW + 2);
+    int16_t y = randomIn(-srcH - 10, dstH + 10);
+    uint8_t op = random32() % 3;
+    std::vector<uint8_t> src = randomPages(srcW, srcH);
+    std::vector<uint8_t> dst = randomPages(dstW, dstH);
+    std::vector<uint8_t> expected = dst;
+    referenceBlit(expected.data(), dstW, dstH, src.data(), srcW, srcH, x, y, op);
+    Adafruit_SSD1306Canvas::blit(dst.data(), dstW, dstH, src.data(), srcW, srcH, x, y, op);
+    if (!samePixels(expected.data(), dst.data(), dstW, dstH)) {
+      char message[120];
+      snprintf(message, sizeof(message), "%dx%d into %dx%d at %d,%d op %u", srcW, srcH, dstW, dstH, x, y, op);
+      TEST_FAIL_MESSAGE(message);
+    }
+  }
+}
+
+void test_display_blit(void) {
+  // a widget into the framebuffer, and the raw pages variant, as main.cpp uses them
+  Adafruit_SSD1306Fixed<128, 64> display(&Wire);
+  Adafruit_SSD1306Canvas widget(64, 24);
+  for (uint32_t i = 0; i < 2000; i++) {
+    std::vector<uint8_t> before = randomPages(128, 64);
+    memcpy(display.getBuffer(), before.data(), before.size());
+    std::vector<uint8_t> pages = randomPages(64, 24);
+    memcpy(widget.getBuffer(), pages.data(), pages.size());
+    int16_t x = randomIn(-70, 130);
+    int16_t y = randomIn(-30, 70);
+    uint8_t op = random32() % 3;
+    referenceBlit(before.data(), 128, 64, pages.data(), 64, 24, x, y, op);
+    if (i % 2) {
+      display.blit(widget, x, y, op);
+    }
+    else {
+      display.blit(pages.data(), 64, 24, x, y, op);
+    }
+    TEST_ASSERT_EQUAL_MEMORY(before.data(), display.getBuffer(), before.size());
+  }
+}
+
+void test_shift_columns(void) {
+  Adafruit_SSD1306Canvas canvas(100, 20);
+  for (uint32_t i = 0; i < 2000; i++) {
+    std::vector<uint8_t> pages = randomPages(100, 20);
+    memcpy(canvas.getBuffer(), pages.data(), pages.size());
+    int16_t n = randomIn(-110, 110);
+    canvas.shiftColumns(n);
+    for (int16_t y = 0; y < 20; y++) {
+      for (int16_t x = 0; x < 100; x++) {
+        int16_t from = x + n;
+        bool expected = from >= 0 && from < 100 && pixel(pages.data(), 100, from, y);
+        TEST_ASSERT_EQUAL(expected, canvas.getPixel(x, y));
+      }
+    }
+  }
+}
+
+template <uint8_t ROTATION> static void checkDrawing() {
+  // the canvas draws exactly what the display driver draws, rotated the same way
+  Adafruit_SSD1306Canvas canvas(128, 64);
+  Adafruit_SSD1306Fixed<128, 64, ROTATION> display(&Wire);
+  canvas.setRotation(ROTATION);
+  canvas.fillScreen(SSD1306_BLACK);
+  display.clearDisplay();
+  Adafruit_GFX *targets[] = { &canvas, &display };
+  for (uint32_t i = 0; i < 50000; i++) {
+    uint32_t operation = random32() % 6;
+    int16_t x = randomIn(-20, 147);
+    int16_t y = randomIn(-20, 147);
+    int16_t w = randomIn(0, 140);
+    int16_t h = randomIn(0, 80);
+    uint16_t color = random32() % 2;
+    for (Adafruit_GFX *target : targets) {
+      switch (operation) {
+        case 0:
+          target->drawPixel(x, y, color);
+          break;
+        case 1:
+          target->drawFastHLine(x, y, w, color);
+          break;
+        case 2:
+          target->drawFastVLine(x, y, h, color);
+          break;
+        case 3:
+          target->fillRect(x, y, w, h, color);
+          break;
+        case 4:
+          target->drawLine(x, y, w, h, color);
+          break;
+        case 5:
+          target->setTextSize(1 + h % 3);
+          target->setTextColor(color, !color);
+          target->setCursor(x, y);
+          target->print("-12.3");
+          break;
+      }
+    }
+  }
+  TEST_ASSERT_EQUAL_MEMORY(display.getBuffer(), canvas.getBuffer(), 128 * 64 / 8);
+}
+
+void test_drawing_rotation_0(void) {
+  checkDrawing<0>();
+}
+void test_drawing_rotation_1(void) {
+  checkDrawing<1>();
+}
+void test_drawing_rotation_2(void) {
+  checkDrawing<2>();
+}
+void test_drawing_rotation_3(void) {
+  checkDrawing<3>();
+}
+
+// usec per call, best of 7 rounds of 100
+template <typename Draw> static double timeIt(Draw draw) {
+  double best = 1e9;
+  for (uint8_t round = 0; round < 7; round++) {
+    auto start = std::chrono::steady_clock::now();
+    for (uint16_t run = 0; run < 100; run++) {
+      draw();
+    }
+    double elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / 100;
+    best = elapsed < best ? elapsed : best;
+  }
+  return best;
+}
+
+void test_timings(void) {
+  // only printed, the numbers depend on the host and the build flags: compare the columns
+  Adafruit_SSD1306Fixed<128, 64> display(&Wire);
+  static const int16_t sizes[][3] = { { 64, 24, 13 }, { 64, 24, 16 }, { 128, 64, 0 } };  // w, h, y
+  for (auto &size : sizes) {
+    Adafruit_SSD1306Canvas widget(size[0], size[1]);
+    std::vector<uint8_t> pages = randomPages(size[0], size[1]);
+    memcpy(widget.getBuffer(), pages.data(), pages.size());
+    // the row-major copy drawBitmap() needs
+    std::vector<uint8_t> rows((size[0] + 7) / 8 * size[1]);
+    for (int16_t y = 0; y < size[1]; y++) {
+      for (int16_t x = 0; x < size[0]; x++) {
+        if (widget.getPixel(x, y)) {
+          rows[y * ((size[0] + 7) / 8) + x / 8] |= 0x80 >> (x & 7);
+        }
+      }
+    }
+    double bitmap = timeIt([&] { display.drawBitmap(0, size[2], rows.data(), size[0], size[1], SSD1306_WHITE, SSD1306_BLACK); });
+    std::vector<uint8_t> drawn(display.getBuffer(), display.getBuffer() + 1024);
+    double blit = timeIt([&] { display.blit(widget, 0, size[2]); });
+    char message[96];
+    snprintf(message, sizeof(message), "%dx%d at y=%d: drawBitmap %7.2f us, blit %6.2f us", size[0], size[1], size[2], bitmap, blit);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_EQUAL_MEMORY(drawn.data(), display.getBuffer(), 1024);
+  }
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_blit_matches_per_pixel);
+  RUN_TEST(test_display_blit);
+  RUN_TEST(test_shift_columns);
+  RUN_TEST(test_drawing_rotation_0);
+  RUN_TEST(test_drawing_rotation_1);
+  RUN_TEST(test_drawing_rotation_2);
+  RUN_TEST(test_drawing_rotation_3);
+  RUN_TEST(test_timings);
+  return UNITY_END();
+}
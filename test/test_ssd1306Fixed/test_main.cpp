@@ -0,0 +1,184 @@
+// Adafruit_SSD1306Fixed against the generic driver: the same random drawing in every
+// rotation must leave byte-identical framebuffers, and the timings of both are printed
+
+#include <unity.h>
+#include <chrono>
+#include <stdio.h>
+#include <Adafruit_SSD1306Fixed.h>
+
+#define frameBytes (128 * 64 / 8)
+
+static uint32_t state;
+static uint32_t random32() {
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+static int16_t randomIn(int16_t low, int16_t high) {
+  return low + (int16_t)(random32() % (uint32_t)(high - low + 1));
+}
+
+// One random operation, the same on both displays. Line and rectangle lengths are
+// positive: the drivers differ on negative ones by design.
+static void drawRandom(Adafruit_SSD1306 &generic, Adafruit_SSD1306 &fixed) {
+  uint32_t operation = random32() % 9;
+  int16_t x = randomIn(-20, 147);
+  int16_t y = randomIn(-20, 147);
+  int16_t w = randomIn(0, 140);
+  int16_t h = randomIn(0, 80);
+  uint16_t color = random32() % 3;  // black, white, inverse
+  bool clear = random32() % 50 == 0;
+  char text[8];
+  snprintf(text, sizeof(text), "%d.%d", (int)(random32() % 2000) - 1000, (int)(random32() % 10));
+  Adafruit_SSD1306 *displays[] = { &generic, &fixed };
+  for (Adafruit_SSD1306 *display : displays) {
+    switch (operation) {
+      case 0:
+      case 1:
+        display->drawPixel(x, y, color);
+        break;
+      case 2:
+        display->drawFastHLine(x, y, w, color);
+        break;
+      case 3:
+        display->drawFastVLine(x, y, h, color);
+        break;
+      case 4:
+        display->fillRect(x, y, w, h, color);
+        break;
+      case 5:
+        display->drawLine(x, y, w, h, color ? color : SSD1306_WHITE);
+        break;
+      case 6:
+        display->drawCircle(x, y, h / 4, color);
+        break;
+      case 7:
+        display->setTextSize(1 + h % 3);
+        display->setTextColor(SSD1306_WHITE, SSD1306_BLACK);
+        display->setCursor(x, y);
+        display->print(text);
+        break;
+      case 8:
+        if (clear) {
+          display->fillScreen(color);
+        }
+        break;
+    }
+  }
+}
+
+template <uint8_t ROTATION> static void checkRotation() {
+  Adafruit_SSD1306 generic(128, 64, &Wire);
+  Adafruit_SSD1306Fixed<128, 64, ROTATION> fixed(&Wire);
+  generic.begin(SSD1306_SWITCHCAPVCC, 0x3C, false, true);
+  fixed.begin(SSD1306_SWITCHCAPVCC, 0x3C, false, true);
+  generic.setRotation(ROTATION);
+  generic.clearDisplay();
+  fixed.clearDisplay();
+  TEST_ASSERT_EQUAL_INT16(generic.width(), fixed.width());
+  TEST_ASSERT_EQUAL_INT16(generic.height(), fixed.height());
+  state = 1 + ROTATION;
+  for (uint32_t i = 0; i < 100000; i++) {
+    drawRandom(generic, fixed);
+    if (i % 64 == 0) {
+      if (memcmp(generic.getBuffer(), fixed.getBuffer(), frameBytes)) {
+        char message[64];
+        snprintf(message, sizeof(message), "framebuffers differ after operation %u", (unsigned)i);
+        TEST_FAIL_MESSAGE(message);
+      }
+      int16_t x = randomIn(-2, 129);
+      int16_t y = randomIn(-2, 129);
+      TEST_ASSERT_EQUAL(generic.getPixel(x, y), fixed.getPixel(x, y));
+    }
+  }
+  TEST_ASSERT_EQUAL_MEMORY(generic.getBuffer(), fixed.getBuffer(), frameBytes);
+  TEST_ASSERT_EQUAL_HEX8(0x40, fixed.getBuffer()[-1]);  // the control byte, as in the allocated buffer
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_rotation_0(void) {
+  checkRotation<0>();
+}
+void test_rotation_1(void) {
+  checkRotation<1>();
+}
+void test_rotation_2(void) {
+  checkRotation<2>();
+}
+void test_rotation_3(void) {
+  checkRotation<3>();
+}
+
+void test_set_rotation_is_fixed(void) {
+  Adafruit_SSD1306Fixed<128, 64, 1> fixed(&Wire);
+  fixed.setRotation(0);
+  TEST_ASSERT_EQUAL_UINT8(1, fixed.getRotation());
+  TEST_ASSERT_EQUAL_INT16(64, fixed.width());
+}
+
+// usec for `runs` calls of the drawing set, best of 7
+template <typename Draw> static double timeIt(Draw draw) {
+  double best = 1e9;
+  for (uint8_t round = 0; round < 7; round++) {
+    auto start = std::chrono::steady_clock::now();
+    for (uint16_t run = 0; run < 100; run++) {
+      draw();
+    }
+    double elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / 100;
+    best = elapsed < best ? elapsed : best;
+  }
+  return best;
+}
+
+static void compare(const char *name, Adafruit_SSD1306 &generic, Adafruit_SSD1306 &fixed, void (*draw)(Adafruit_SSD1306 &)) {
+  double before = timeIt([&] { draw(generic); });
+  double after = timeIt([&] { draw(fixed); });
+  char message[96];
+  snprintf(message, sizeof(message), "%-22s generic %7.2f us, fixed %7.2f us", name, before, after);
+  TEST_MESSAGE(message);
+  TEST_ASSERT_EQUAL_MEMORY(generic.getBuffer(), fixed.getBuffer(), frameBytes);
+}
+
+void test_timings(void) {
+  // only printed, the numbers depend on the host and the build flags: compare the columns
+  Adafruit_SSD1306 generic(128, 64, &Wire);
+  Adafruit_SSD1306Fixed<128, 64> fixed(&Wire);
+  generic.begin(SSD1306_SWITCHCAPVCC, 0x3C, false, true);
+  fixed.begin(SSD1306_SWITCHCAPVCC, 0x3C, false, true);
+  compare("2048 pixels", generic, fixed, [](Adafruit_SSD1306 &d) {
+    for (int16_t i = 0; i < 2048; i++) {
+      d.drawPixel(i % 128, (i * 7) % 64, SSD1306_INVERSE);
+    }
+  });
+  compare("100x50 fillRect", generic, fixed, [](Adafruit_SSD1306 &d) { d.fillRect(13, 5, 100, 50, SSD1306_INVERSE); });
+  compare("64 horizontal lines", generic, fixed, [](Adafruit_SSD1306 &d) {
+    for (int16_t y = 0; y < 64; y++) {
+      d.drawFastHLine(y, y, 100, SSD1306_INVERSE);
+    }
+  });
+  compare("128 vertical lines", generic, fixed, [](Adafruit_SSD1306 &d) {
+    for (int16_t x = 0; x < 128; x++) {
+      d.drawFastVLine(x, x % 16, 40, SSD1306_INVERSE);
+    }
+  });
+  compare("\"-12.3\" at size 3", generic, fixed, [](Adafruit_SSD1306 &d) {
+    d.setTextSize(3);
+    d.setTextColor(SSD1306_WHITE, SSD1306_BLACK);
+    d.setCursor(10, 20);
+    d.print("-12.3");
+  });
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_rotation_0);
+  RUN_TEST(test_rotation_1);
+  RUN_TEST(test_rotation_2);
+  RUN_TEST(test_rotation_3);
+  RUN_TEST(test_set_rotation_is_fixed);
+  RUN_TEST(test_timings);
+  return UNITY_END();
+}
@@ -0,0 +1,183 @@
+// Tare window with still, noisy and moving synthetic accelerometer traces
+
+#include <unity.h>
+#include <math.h>
+#include "tareEngine.h"
+
+#define samplePeriod 5  // msec, ~208Hz
+
+static uint32_t state;
+
+// Roughly gaussian noise (sum of four uniforms), standard deviation sigma counts
+static int16_t noise(float sigma) {
+  float total = 0;
+  for (uint8_t i = 0; i < 4; i++) {
+    state = state * 1103515245 + 12345;
+    total += (state >> 8) / 16777216.0f - 0.5f;
+  }
+  return lroundf(total * sigma * 1.732f);
+}
+
+static accelSample still(float sigma) {
+  return { (int16_t)(120 + noise(sigma)), (int16_t)(-340 + noise(sigma)), (int16_t)(16384 + noise(sigma)) };
+}
+
+// Feeds samples until the tare completes or `limit` msec pass, returns when it completed
+static uint32_t run(TareEngine &tare, uint32_t &now, uint32_t limit, accelSample (*source)(uint32_t), float *x, float *y, float *z) {
+  uint32_t end = now + limit;
+  for (; now < end; now += samplePeriod) {
+    tare.addSample(source(now));
+    if (tare.poll(now, x, y, z)) {
+      return now;
+    }
+  }
+  return 0;
+}
+
+static accelSample quiet(uint32_t) { return still(8); }
+static accelSample shaking(uint32_t) { return still(400); }
+static accelSample tilting(uint32_t now) {
+  // a smooth tilt, 2000 counts (~7 degrees) per second, with little noise
+  accelSample sample = still(4);
+  sample.x += now * 2;
+  return sample;
+}
+static accelSample settling(uint32_t now) { return now < 3000 ? still(400) : still(8); }
+
+void setUp(void) {
+  state = 1;
+}
+void tearDown(void) {}
+
+void test_nothing_without_request(void) {
+  TareEngine tare;
+  float x, y, z;
+  uint32_t now = 0;
+  TEST_ASSERT_EQUAL_UINT32(0, run(tare, now, 1000, quiet, &x, &y, &z));
+  TEST_ASSERT_TRUE(tare.steady());
+  TEST_ASSERT_FALSE(tare.pending());
+}
+
+void test_still_tares_at_once(void) {
+  TareEngine tare;
+  float x, y, z;
+  uint32_t now = 0;
+  run(tare, now, 1000, quiet, &x, &y, &z);
+  tare.request(now);
+  TEST_ASSERT_EQUAL_UINT32(now, run(tare, now, 1000, quiet, &x, &y, &z));
+  TEST_ASSERT_FALSE(tare.pending());
+  // the mean of 64 samples with 8 counts of noise is within a few counts
+  TEST_ASSERT_FLOAT_WITHIN(4, 120, x);
+  TEST_ASSERT_FLOAT_WITHIN(4, -340, y);
+  TEST_ASSERT_FLOAT_WITHIN(4, 16384, z);
+}
+
+void test_request_at_boot_waits_for_a_full_window(void) {
+  TareEngine tare;
+  float x, y, z;
+  uint32_t now = 0;
+  tare.request(now);
+  uint32_t done = run(tare, now, 1000, quiet, &x, &y, &z);
+  TEST_ASSERT_EQUAL_UINT32((tareWindow - 1) * samplePeriod, done);
+}
+
+void test_shaking_waits_for_the_timeout(void) {
+  TareEngine tare;
+  float x, y, z;
+  uint32_t now = 0;
+  run(tare, now, 1000, shaking, &x, &y, &z);
+  TEST_ASSERT_FALSE(tare.steady());
+  uint32_t start = now;
+  tare.request(start);
+  uint32_t done = run(tare, now, 5000, shaking, &x, &y, &z);
+  TEST_ASSERT_EQUAL_UINT32(start + tare.timeout, done);
+  // and still takes the window mean, good to the standard error
+  TEST_ASSERT_FLOAT_WITHIN(200, 16384, z);
+}
+
+void test_steady_tilt_is_not_steady(void) {
+  // a turn has little noise but its window spread is large, it times out too
+  TareEngine tare;
+  float x, y, z;
+  uint32_t now = 0;
+  run(tare, now, 1000, tilting, &x, &y, &z);
+  tare.request(now);
+  uint32_t start = now;
+  TEST_ASSERT_EQUAL_UINT32(start + tare.timeout, run(tare, now, 5000, tilting, &x, &y, &z));
+}
+
+void test_tares_one_window_after_motion_stops(void) {
+  TareEngine tare;
+  float x, y, z;
+  uint32_t now = 0;
+  tare.request(now);
+  tare.timeout = 10000;
+  uint32_t done = run(tare, now, 10000, settling, &x, &y, &z);
+  TEST_ASSERT_GREATER_OR_EQUAL(3000, done);
+  TEST_ASSERT_LESS_OR_EQUAL(3000 + tareWindow * samplePeriod, done);
+  TEST_ASSERT_FLOAT_WITHIN(4, 16384, z);
+}
+
+void test_threshold_matches_the_standard_error(void) {
+  // noise well below tolerance * sqrt(window) passes, well above fails
+  TareEngine tare;
+  float limit = tare.tolerance * sqrtf(tareWindow);
+  for (uint32_t i = 0; i < tareWindow; i++) {
+    tare.addSample(still(limit * 0.7f));
+  }
+  TEST_ASSERT_TRUE(tare.steady());
+  for (uint32_t i = 0; i < tareWindow; i++) {
+    tare.addSample(still(limit * 1.4f));
+  }
+  TEST_ASSERT_FALSE(tare.steady());
+}
+
+void test_sums_track_a_recomputed_window(void) {
+  // after many thousands of full scale samples the running sums still match the window
+  TareEngine tare;
+  for (uint32_t i = 0; i < 100000; i++) {
+    state = state * 1103515245 + 12345;
+    int16_t value = state >> 16;
+    tare.addSample({ value, (int16_t)-value, (int16_t)(i & 1 ? -32768 : 32767) });
+  }
+  for (uint32_t i = 0; i < tareWindow; i++) {
+    tare.addSample({ 1000, 2000, 3000 });
+  }
+  TEST_ASSERT_TRUE(tare.steady());
+  float x, y, z;
+  tare.request(0);
+  TEST_ASSERT_TRUE(tare.poll(0, &x, &y, &z));
+  TEST_ASSERT_EQUAL_FLOAT(1000, x);
+  TEST_ASSERT_EQUAL_FLOAT(2000, y);
+  TEST_ASSERT_EQUAL_FLOAT(3000, z);
+}
+
+void test_clear_empties_the_window(void) {
+  TareEngine tare;
+  for (uint32_t i = 0; i < tareWindow; i++) {
+    tare.addSample(still(0));
+  }
+  TEST_ASSERT_TRUE(tare.steady());
+  tare.clear();
+  TEST_ASSERT_FALSE(tare.steady());
+  float x, y, z;
+  tare.request(0);
+  TEST_ASSERT_FALSE(tare.poll(5000, &x, &y, &z));  // no samples, not even after the timeout
+  tare.addSample({ 7, 8, 9 });
+  TEST_ASSERT_TRUE(tare.poll(5000, &x, &y, &z));
+  TEST_ASSERT_EQUAL_FLOAT(7, x);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_nothing_without_request);
+  RUN_TEST(test_still_tares_at_once);
+  RUN_TEST(test_request_at_boot_waits_for_a_full_window);
+  RUN_TEST(test_shaking_waits_for_the_timeout);
+  RUN_TEST(test_steady_tilt_is_not_steady);
+  RUN_TEST(test_tares_one_window_after_motion_stops);
+  RUN_TEST(test_threshold_matches_the_standard_error);
+  RUN_TEST(test_sums_track_a_recomputed_window);
+  RUN_TEST(test_clear_empties_the_window);
+  return UNITY_END();
+}
@@ -0,0 +1,222 @@
+// Telemetry ring and COBS framing: a port that never drains must not block or
+// corrupt anything, and every frame must decode back to the struct that was sent
+
+#include <unity.h>
+#include <string>
+#include <vector>
+#include "telemetry.h"
+
+// A port that takes at most `room` bytes per service() call, 0 = stalled host
+class TestPort : public Print {
+  public:
+    int room = 0;
+    std::string received;
+    uint32_t calls = 0;
+
+    size_t write(uint8_t c) override {
+      received += (char)c;
+      return 1;
+    }
+    size_t write(const uint8_t *data, size_t length) override {
+      TEST_ASSERT_LESS_OR_EQUAL(room, (int)length);  // never more than it said it could take
+      calls++;
+      received.append((const char *)data, length);
+      room -= length;
+      return length;
+    }
+    int availableForWrite() override { return room; }
+};
+
+// COBS decoder, as tools/streamDecode.py does it
+static bool cobsDecode(const std::string &encoded, std::vector<uint8_t> &out) {
+  out.clear();
+  size_t i = 0;
+  while (i < encoded.size()) {
+    uint8_t code = encoded[i];
+    if (code == 0 || i + code > encoded.size()) {
+      return false;
+    }
+    out.insert(out.end(), encoded.begin() + i + 1, encoded.begin() + i + code);
+    i += code;
+    if (code < 0xFF && i < encoded.size()) {
+      out.push_back(0);
+    }
+  }
+  return true;
+}
+
+// Splits the received bytes on the 0x00 delimiters
+static std::vector<std::vector<uint8_t>> frames(const std::string &received) {
+  std::vector<std::vector<uint8_t>> decoded;
+  size_t start = 0;
+  size_t end;
+  while ((end = received.find('\0', start)) != std::string::npos) {
+    std::vector<uint8_t> frame;
+    TEST_ASSERT_TRUE_MESSAGE(cobsDecode(received.substr(start, end - start), frame), "bad COBS frame");
+    decoded.push_back(frame);
+    start = end + 1;
+  }
+  TEST_ASSERT_EQUAL_UINT(received.size(), start);  // nothing after the last delimiter
+  return decoded;
+}
+
+static Telemetry *channel;
+
+void setUp(void) {
+  channel = new Telemetry();
+}
+void tearDown(void) {
+  delete channel;
+}
+
+void test_lines_are_held_until_complete(void) {
+  TestPort port;
+  port.room = 1000;
+  channel->print("roll ");
+  channel->print(12.5, 1);
+  channel->service(port);
+  TEST_ASSERT_EQUAL_UINT(0, port.received.size());
+  channel->println();
+  channel->service(port);
+  TEST_ASSERT_EQUAL_STRING("roll 12.5\r\n", port.received.c_str());
+  TEST_ASSERT_EQUAL_UINT(0, channel->queued());
+}
+
+void test_stalled_port_drops_whole_lines(void) {
+  TestPort port;  // never reads
+  uint32_t lines = 0;
+  for (uint32_t i = 0; i < 1000; i++) {
+    channel->println("0123456789012345678901234567890123456789");
+    channel->service(port);
+    lines++;
+  }
+  TEST_ASSERT_EQUAL_UINT32(0, port.calls);
+  // the ring filled with whole lines and the rest were counted, not blocked on
+  uint32_t kept = channel->queued() / 42;
+  TEST_ASSERT_EQUAL_UINT(kept * 42, channel->queued());
+  TEST_ASSERT_EQUAL_UINT32(lines - kept, channel->dropped);
+  TEST_ASSERT_LESS_OR_EQUAL(telemetryBufferSize - 1, channel->queued());
+
+  // the host starts reading: every line it gets is intact
+  port.room = 100000;
+  channel->service(port);
+  TEST_ASSERT_EQUAL_UINT(kept * 42, port.received.size());
+  for (uint32_t i = 0; i < kept; i++) {
+    TEST_ASSERT_EQUAL_MEMORY("0123456789012345678901234567890123456789\r\n", port.received.data() + i * 42, 42);
+  }
+}
+
+void test_long_line_is_dropped(void) {
+  TestPort port;
+  port.room = 1000;
+  for (uint16_t i = 0; i < telemetryLineSize + 10; i++) {
+    channel->print('x');
+  }
+  channel->println();
+  channel->println("ok");
+  channel->service(port);
+  TEST_ASSERT_EQUAL_UINT32(1, channel->dropped);
+  TEST_ASSERT_EQUAL_STRING("ok\r\n", port.received.c_str());
+}
+
+void test_slow_port_gets_everything_in_order(void) {
+  // a few bytes per loop, across the ring's wrap point many times
+  TestPort port;
+  std::string sent;
+  char line[32];
+  for (uint32_t i = 0; i < 20000; i++) {
+    if (channel->queued() < telemetryBufferSize - 64) {
+      snprintf(line, sizeof(line), "line %lu", (unsigned long)i);
+      channel->println(line);
+      sent += line;
+      sent += "\r\n";
+    }
+    port.room = i % 13;
+    channel->service(port);
+  }
+  port.room = telemetryBufferSize;
+  channel->service(port);
+  TEST_ASSERT_EQUAL_UINT32(0, channel->dropped);
+  TEST_ASSERT_TRUE(sent == port.received);
+}
+
+void test_frames_round_trip(void) {
+  TestPort port;
+  port.room = 100000;
+  channel->binary = true;
+  uint32_t state = 1;
+  std::vector<std::vector<uint8_t>> sent;
+  for (uint32_t i = 0; i < 2000; i++) {
+    std::vector<uint8_t> frame(1 + i % telemetryMaxFrame);
+    for (auto &b : frame) {
+      state = state * 1103515245 + 12345;
+      b = (state >> 16) % 3 == 0 ? 0 : state >> 24;  // plenty of zeros
+    }
+    if (i % 50 == 0) {
+      std::fill(frame.begin(), frame.end(), 0);
+    }
+    TEST_ASSERT_TRUE(channel->sendFrame(frame.data(), frame.size()));
+    sent.push_back(frame);
+    channel->service(port);
+  }
+  std::vector<std::vector<uint8_t>> received = frames(port.received);
+  TEST_ASSERT_EQUAL_UINT(sent.size(), received.size());
+  for (size_t i = 0; i < sent.size(); i++) {
+    TEST_ASSERT_EQUAL_UINT(sent[i].size(), received[i].size());
+    TEST_ASSERT_EQUAL_MEMORY(sent[i].data(), received[i].data(), sent[i].size());
+  }
+}
+
+void test_frames_are_all_or_nothing(void) {
+  TestPort port;  // stalled
+  channel->binary = true;
+  telemetryDataFrame data = { telemetryFrameData, 0, 0, 1.5, -2.5, 3.9 };
+  uint32_t sent = 0;
+  for (uint32_t i = 0; i < 1000; i++) {
+    data.sequence = i;
+    if (channel->sendFrame(&data, sizeof(data))) {
+      sent++;
+    }
+    channel->service(port);
+  }
+  TEST_ASSERT_EQUAL_UINT32(1000 - sent, channel->dropped);
+  port.room = 100000;
+  channel->service(port);
+  std::vector<std::vector<uint8_t>> received = frames(port.received);
+  TEST_ASSERT_EQUAL_UINT(sent, received.size());
+  for (uint32_t i = 0; i < sent; i++) {
+    telemetryDataFrame frame;
+    TEST_ASSERT_EQUAL_UINT(sizeof(frame), received[i].size());
+    memcpy(&frame, received[i].data(), sizeof(frame));
+    TEST_ASSERT_EQUAL_UINT8(i, frame.sequence);  // the first ones, in order, no gaps
+    TEST_ASSERT_EQUAL_FLOAT(-2.5, frame.pitch);
+  }
+  // text is off in binary mode, oversized structs are refused
+  channel->println("hidden");
+  uint8_t big[telemetryMaxFrame + 1] = {};
+  TEST_ASSERT_FALSE(channel->sendFrame(big, sizeof(big)));
+  TEST_ASSERT_EQUAL_UINT(0, channel->queued());
+}
+
+void test_data_rate_limit(void) {
+  channel->dataPeriod = 100;
+  TEST_ASSERT_TRUE(channel->dataDue(1000));
+  TEST_ASSERT_FALSE(channel->dataDue(1099));
+  TEST_ASSERT_TRUE(channel->dataDue(1100));
+  channel->level = telemetryInfo;
+  TEST_ASSERT_FALSE(channel->dataDue(5000));
+  channel->binary = true;  // frames ignore the text level
+  TEST_ASSERT_TRUE(channel->dataDue(5000));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_lines_are_held_until_complete);
+  RUN_TEST(test_stalled_port_drops_whole_lines);
+  RUN_TEST(test_long_line_is_dropped);
+  RUN_TEST(test_slow_port_gets_everything_in_order);
+  RUN_TEST(test_frames_round_trip);
+  RUN_TEST(test_frames_are_all_or_nothing);
+  RUN_TEST(test_data_rate_limit);
+  return UNITY_END();
+}
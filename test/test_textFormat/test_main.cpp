@@ -0,0 +1,135 @@
+// formatFixed() against dtostrf(), which on the nRF52 core is printf "%*.*f"
+// (here the host's snprintf), byte for byte
+
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include "textFormat.h"
+
+// dtostrf() as the mbed core implements it
+static const char *dtostrf(double value, signed char width, unsigned char decimals, char *buffer) {
+  sprintf(buffer, "%*.*f", width, decimals, value);
+  return buffer;
+}
+
+static uint32_t state = 1;
+static uint32_t random32() {
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+static void checkSame(float value, int8_t width, uint8_t decimals) {
+  char expected[64];
+  char actual[formatBufferSize];
+  dtostrf(value, width, decimals, expected);
+  uint8_t length = formatFixed(actual, value, width, decimals);
+  if (strcmp(expected, actual)) {
+    char message[160];
+    snprintf(message, sizeof(message), "%.9g width %d decimals %u", value, width, decimals);
+    TEST_ASSERT_EQUAL_STRING_MESSAGE(expected, actual, message);
+  }
+  TEST_ASSERT_EQUAL_UINT(strlen(expected), length);
+}
+
+void setUp(void) {
+  state = 1;
+}
+void tearDown(void) {}
+
+void test_firmware_formats(void) {
+  // roll/pitch (5,1), battery volts (4,2), percent (4,0), throw (6,1), hours (0,0)
+  static const float values[] = { 0, 0.04, 0.05, 0.15, -0.05, -0.04, 1.25, 3.7, 4.195, 4.205, 12.34, -12.34, 45.55, -89.95, 99.95, -99.95, 179.95, -180, 100, 360.04 };
+  for (float value : values) {
+    checkSame(value, 5, 1);
+    checkSame(value, 4, 2);
+    checkSame(value, 4, 0);
+    checkSame(value, 6, 1);
+    checkSame(value, 0, 0);
+  }
+}
+
+void test_random_values(void) {
+  // every magnitude below the 2^32 limit, all widths and decimals
+  for (uint32_t i = 0; i < 300000; i++) {
+    uint32_t bits = random32();
+    float value;
+    memcpy(&value, &bits, 4);
+    if (!isfinite(value) || fabsf(value) >= 4294967296.0f) {
+      continue;
+    }
+    checkSame(value, (int8_t)(random32() % 25) - 12, random32() % (formatMaxDecimals + 1));
+  }
+}
+
+void test_angle_range(void) {
+  // the values the firmware really prints, densely
+  for (uint32_t i = 0; i < 200000; i++) {
+    float value = ((int32_t)(random32() % 3600001) - 1800000) / 10000.0f;
+    checkSame(value, 5, 1);
+    checkSame(value, 4, 2);
+  }
+}
+
+void test_ties_round_to_even(void) {
+  // exact binary halves, printf rounds them to even
+  for (int32_t k = -4096; k <= 4096; k++) {
+    for (uint8_t decimals = 0; decimals <= 3; decimals++) {
+      checkSame(k / 8.0f, 0, decimals);
+      checkSame(k / 1024.0f, 0, decimals);
+    }
+  }
+}
+
+void test_special_values(void) {
+  char text[formatBufferSize];
+  checkSame(INFINITY, 0, 1);
+  checkSame(-INFINITY, 6, 1);
+  checkSame(-0.0f, 5, 1);
+  checkSame(1e-40f, 0, 6);  // subnormal
+  // newlib prints nan unsigned, glibc doesn't
+  formatFixed(text, -NAN, 5, 1);
+  TEST_ASSERT_EQUAL_STRING("  nan", text);
+  // 2^32 and up, like Print::printFloat()
+  formatFixed(text, 5e9f, 0, 1);
+  TEST_ASSERT_EQUAL_STRING("ovf", text);
+  formatFixed(text, -5e9f, 5, 1);
+  TEST_ASSERT_EQUAL_STRING(" -ovf", text);
+  // decimals are capped
+  formatFixed(text, 1.5f, 0, 9);
+  TEST_ASSERT_EQUAL_STRING("1.500000", text);
+}
+
+void test_short_buffer_truncates(void) {
+  char text[5];
+  memset(text, 'x', sizeof(text));
+  TEST_ASSERT_EQUAL_UINT(4, formatFixed(text, sizeof(text), -123.45f, 8, 2));
+  TEST_ASSERT_EQUAL_STRING(" -12", text);  // " -123.45" cut to fit
+  TEST_ASSERT_EQUAL_UINT(4, formatFixed(text, sizeof(text), -123.45f, 0, 2));
+  TEST_ASSERT_EQUAL_STRING("-123", text);
+  TEST_ASSERT_EQUAL_UINT(0, formatFixed(text, 1, 1.0f, 0, 0));
+  TEST_ASSERT_EQUAL_STRING("", text);
+}
+
+void test_copy_address(void) {
+  char address[addressLength + 1];
+  copyAddress(address, "a4:c1:38:00:11:22");
+  TEST_ASSERT_EQUAL_STRING("a4:c1:38:00:11:22", address);
+  copyAddress(address, "a4:c1:38:00:11:22:33:44");  // cut to an address
+  TEST_ASSERT_EQUAL_STRING("a4:c1:38:00:11:22", address);
+  copyAddress(address, "");
+  TEST_ASSERT_EQUAL_STRING("", address);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_firmware_formats);
+  RUN_TEST(test_random_values);
+  RUN_TEST(test_angle_range);
+  RUN_TEST(test_ties_round_to_even);
+  RUN_TEST(test_special_values);
+  RUN_TEST(test_short_buffer_truncates);
+  RUN_TEST(test_copy_address);
+  return UNITY_END();
+}
@@ -0,0 +1,116 @@
+// Throw capture with sweep traces at the accelerometer rate
+
+#include <unity.h>
+#include <math.h>
+#include "throwCapture.h"
+
+#define sampleRate 208
+
+static uint32_t state;
+
+// Roughly gaussian noise (sum of four uniforms), standard deviation sigma
+static float noise(float sigma) {
+  float total = 0;
+  for (uint8_t i = 0; i < 4; i++) {
+    state = state * 1103515245 + 12345;
+    total += (state >> 8) / 16777216.0f - 0.5f;
+  }
+  return total * sigma * 1.732f;
+}
+
+void setUp(void) {
+  state = 1;
+}
+void tearDown(void) {}
+
+void test_filter_coefficient(void) {
+  ThrowCapture capture;
+  TEST_ASSERT_EQUAL_FLOAT(1, capture.smoothing);
+  capture.setFilter(0, sampleRate);
+  TEST_ASSERT_EQUAL_FLOAT(1, capture.smoothing);
+  capture.setFilter(20, sampleRate);
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 0.1938, capture.smoothing);  // 4.8ms / (20 + 4.8ms)
+}
+
+void test_first_sample_seeds_the_extremes(void) {
+  ThrowCapture capture;
+  capture.setFilter(20, sampleRate);
+  TEST_ASSERT_FALSE(capture.captured());
+  capture.add(30, -40);
+  TEST_ASSERT_TRUE(capture.captured());
+  TEST_ASSERT_EQUAL_FLOAT(30, capture.roll().minimum);
+  TEST_ASSERT_EQUAL_FLOAT(30, capture.roll().maximum);
+  TEST_ASSERT_EQUAL_FLOAT(-40, capture.pitch().maximum);
+  TEST_ASSERT_EQUAL_FLOAT(0, capture.roll().span());
+}
+
+void test_noise_doesnt_inflate_the_span(void) {
+  // 0.15 degrees of sensor noise on a still surface, 10 seconds
+  ThrowCapture raw;
+  ThrowCapture filtered;
+  filtered.setFilter(20, sampleRate);
+  for (uint32_t i = 0; i < sampleRate * 10; i++) {
+    float roll = noise(0.15);
+    float pitch = 5 + noise(0.15);
+    raw.add(roll, pitch);
+    filtered.add(roll, pitch);
+  }
+  TEST_ASSERT_GREATER_THAN(0.6, raw.roll().span());
+  TEST_ASSERT_LESS_THAN(0.5, filtered.roll().span());
+  TEST_ASSERT_LESS_THAN(0.5, filtered.pitch().span());
+  TEST_ASSERT_LESS_THAN(raw.roll().span() / 2, filtered.roll().span());
+}
+
+void test_sweep_endpoints_are_caught(void) {
+  // a 1Hz sweep from -30 to +25 degrees for three seconds, pitch at half the roll
+  ThrowCapture capture;
+  capture.setFilter(20, sampleRate);
+  for (uint32_t i = 0; i < sampleRate * 3; i++) {
+    float angle = -2.5f + 27.5f * sinf(2 * (float)M_PI * i / sampleRate);
+    capture.add(angle + noise(0.15), angle / 2 + noise(0.15));
+  }
+  TEST_ASSERT_FLOAT_WITHIN(0.4, -30, capture.roll().minimum);
+  TEST_ASSERT_FLOAT_WITHIN(0.4, 25, capture.roll().maximum);
+  TEST_ASSERT_FLOAT_WITHIN(0.5, 55, capture.roll().span());
+  TEST_ASSERT_FLOAT_WITHIN(0.4, 27.5, capture.pitch().span());
+}
+
+void test_quick_flick_is_caught(void) {
+  // a flick to 40 degrees that dwells 150ms, between two display updates
+  ThrowCapture capture;
+  capture.setFilter(20, sampleRate);
+  for (uint32_t i = 0; i < sampleRate; i++) {
+    capture.add(0, 0);
+  }
+  for (uint32_t i = 0; i < sampleRate * 3 / 20; i++) {
+    capture.add(40, 0);
+  }
+  for (uint32_t i = 0; i < sampleRate; i++) {
+    capture.add(0, 0);
+  }
+  TEST_ASSERT_FLOAT_WITHIN(0.1, 40, capture.roll().maximum);
+  TEST_ASSERT_EQUAL_FLOAT(0, capture.roll().minimum);
+}
+
+void test_reset_starts_over(void) {
+  ThrowCapture capture;
+  capture.add(-20, 10);
+  capture.add(20, -10);
+  capture.reset();
+  TEST_ASSERT_FALSE(capture.captured());
+  capture.add(5, 6);
+  TEST_ASSERT_EQUAL_FLOAT(5, capture.roll().minimum);
+  TEST_ASSERT_EQUAL_FLOAT(5, capture.roll().maximum);
+  TEST_ASSERT_EQUAL_FLOAT(6, capture.pitch().minimum);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_filter_coefficient);
+  RUN_TEST(test_first_sample_seeds_the_extremes);
+  RUN_TEST(test_noise_doesnt_inflate_the_span);
+  RUN_TEST(test_sweep_endpoints_are_caught);
+  RUN_TEST(test_quick_flick_is_caught);
+  RUN_TEST(test_reset_starts_over);
+  return UNITY_END();
+}
@@ -0,0 +1,90 @@
+#!/usr/bin/env python3
+# Firmware update over BLE for the ble-inclinometer (see include/dfuEngine.h)
+# Sends .pio/build/<env>/firmware.bin in chunks, resumes where the device left off
+# (after a dropped link or a power cycle just run it again), then installs it.
+# pip install bleak
+
+import asyncio
+import struct
+import sys
+import zlib
+
+from bleak import BleakClient, BleakScanner
+
+CONTROL = '0000100b-0000-1000-8000-00805f9b34fb'
+DATA = '0000100c-0000-1000-8000-00805f9b34fb'
+START, STATUS, INSTALL = 1, 2, 3
+RESULTS = ['ok', 'bad length', 'bad opcode', 'image too large', 'bad offset', 'not started',
+           'crc error', 'incomplete', 'sketch reaches the update slot',
+           'not a firmware image for this board']
+RESPONSE = struct.Struct('<BBBII')  # dfuResponse
+MAX_CHUNK = 240
+APP_BASE = 0x27000  # dfuAppBase
+RAM = (0x20000000, 0x20040000)
+
+def crc32(data):
+  # the device continues a crc without the final xor
+  return zlib.crc32(data) ^ 0xFFFFFFFF
+
+def bootable(image):
+  # the device refuses anything else after the transfer, catch a .hex or .uf2 up front
+  if len(image) < 8:
+    return False
+  stack, reset = struct.unpack_from('<II', image)
+  return (RAM[0] < stack <= RAM[1] and stack % 4 == 0 and reset & 1
+          and APP_BASE <= reset & ~1 < APP_BASE + len(image))
+
+async def main(path, name):
+  image = open(path, 'rb').read()
+  if not bootable(image):
+    sys.exit('{} is not a firmware image for this board, use .pio/build/<env>/firmware.bin'.format(path))
+  device = await BleakScanner.find_device_by_name(name)
+  if device is None:
+    sys.exit('"{}" not found'.format(name))
+
+  responses = asyncio.Queue()
+  async with BleakClient(device) as client:
+    await client.start_notify(CONTROL, lambda _, data: responses.put_nowait(RESPONSE.unpack(data)))
+    # chunk size from the negotiated MTU (3 bytes ATT header, 4 bytes offset)
+    chunk = max(4, min(MAX_CHUNK, (client.mtu_size - 7) // 4 * 4))
+
+    # answered once the device has erased its update slot, a few seconds for a large image
+    print('waiting for the device to erase its update slot')
+    await client.write_gatt_char(CONTROL, struct.pack('<BII', START, len(image), crc32(image)), response=True)
+    opcode, result, state, offset, size = await responses.get()
+    if result:
+      sys.exit('start failed: ' + RESULTS[result])
+    print('{} bytes, starting at {} ({} byte chunks)'.format(len(image), offset, chunk))
+
+    while offset < len(image):
+      data = image[offset:offset + chunk]
+      await client.write_gatt_char(DATA, struct.pack('<I', offset) + data, response=False)
+      offset += len(data)
+      if not responses.empty():
+        opcode, result, state, offset, size = responses.get_nowait()
+        print('device asked to continue at {} ({})'.format(offset, RESULTS[result]))
+        await asyncio.sleep(0.1)  # let the chunks in flight drain
+        while not responses.empty():
+          opcode, result, state, offset, size = responses.get_nowait()
+      print('\r{:6.1%}'.format(offset / len(image)), end='', flush=True)
+
+    # confirm the device has everything (the status request is queued behind the last chunk)
+    await client.write_gatt_char(CONTROL, bytes([STATUS]), response=True)
+    opcode, result, state, offset, size = await responses.get()
+    if offset < len(image):
+      sys.exit('\ndevice stopped at {}, run again to resume'.format(offset))
+
+    print('\ninstalling, keep the board powered for the next 10 seconds')
+    print('(if the power goes during the install: double tap reset for the USB bootloader and')
+    print(' upload over USB as usual, pio run -t upload)')
+    await client.write_gatt_char(CONTROL, bytes([INSTALL]), response=True)
+    opcode, result, state, offset, size = await responses.get()
+    print('install: ' + RESULTS[result])
+    if result == 0:
+      print('the board restarts with the new firmware once the copy is done')
+
+if __name__ == '__main__':
+  if len(sys.argv) < 2:
+    print("Usage: {} <firmware.bin> [device name]\n".format(sys.argv[0]), file=sys.stderr)
+    sys.exit(1)
+  asyncio.run(main(sys.argv[1], sys.argv[2] if len(sys.argv) > 2 else 'Angle Monitor'))
@@ -0,0 +1,95 @@
+#!/usr/bin/env python3
+# Reference decoder for the ble-inclinometer USB stream (usbStream in src/main.cpp)
+# Reads COBS framed telemetry from a serial port (or a captured file), and prints
+# samples/sec, bytes/sec and lost samples once a second. Use --csv to dump samples.
+# pip install pyserial to read from a port
+
+import struct
+import sys
+import time
+
+FRAME_DATA = 1
+FRAME_RAW = 2
+FRAME_ANGLES = 3
+HEADER = struct.Struct('<BBI')  # telemetrySamplesHeader
+
+def cobs_decode(data):
+  out = bytearray()
+  i = 0
+  while i < len(data):
+    code = data[i]
+    if code == 0 or i + code > len(data):
+      return None
+    out += data[i + 1:i + code]
+    i += code
+    if code < 0xFF and i < len(data):
+      out.append(0)
+  return bytes(out)
+
+def frames(stream):
+  # yields (decoded frame, raw length) split on 0x00 delimiters
+  pending = bytearray()
+  while True:
+    chunk = stream.read(4096)
+    if not chunk:
+      if hasattr(stream, 'in_waiting'):
+        continue  # serial timeout, keep waiting
+      return
+    pending += chunk
+    while True:
+      end = pending.find(b'\0')
+      if end < 0:
+        break
+      raw = bytes(pending[:end])
+      del pending[:end + 1]
+      yield cobs_decode(raw), len(raw) + 1
+
+def main(source, csv):
+  if source.startswith('/dev/') or source.upper().startswith('COM'):
+    import serial
+    stream = serial.Serial(source, 115200, timeout=0.1)
+  else:
+    stream = open(source, 'rb')
+
+  expected = None
+  samples = lost = bad = total_bytes = 0
+  start = report = time.time()
+  for frame, length in frames(stream):
+    total_bytes += length
+    if frame is None:
+      bad += 1
+      continue
+    if len(frame) < HEADER.size or frame[0] not in (FRAME_RAW, FRAME_ANGLES):
+      continue  # telemetryDataFrame or text, not part of the stream
+    kind, count, first = HEADER.unpack_from(frame)
+    width = 3 if kind == FRAME_RAW else 2
+    if len(frame) != HEADER.size + count * width * 2:
+      bad += 1
+      continue
+    if expected is not None and first > expected:
+      lost += first - expected
+    expected = first + count
+    samples += count
+    if csv:
+      values = struct.unpack_from('<{}h'.format(count * width), frame, HEADER.size)
+      for n in range(count):
+        sample = values[n * width:(n + 1) * width]
+        if kind == FRAME_ANGLES:
+          sample = ['{:.2f}'.format(v / 100) for v in sample]
+        print(first + n, *sample, sep=',')
+
+    now = time.time()
+    if not csv and now - report >= 1:
+      elapsed = now - start
+      print('{:8.0f} samples/s {:8.0f} bytes/s  lost {} ({:.2%})  bad frames {}'.format(
+            samples / elapsed, total_bytes / elapsed, lost, lost / max(samples + lost, 1), bad))
+      report = now
+
+  if not csv:
+    print('total {} samples, {} lost, {} bad frames'.format(samples, lost, bad))
+
+if __name__ == '__main__':
+  if len(sys.argv) < 2:
+    print("Usage: {} <serial port | capture file> [--csv]\n".format(sys.argv[0]), file=sys.stderr)
+    sys.exit(1)
+  main(sys.argv[1], '--csv' in sys.argv[2:])